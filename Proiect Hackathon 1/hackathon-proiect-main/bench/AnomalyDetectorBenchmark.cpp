@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/AnomalyDetector.h"
+#include "../src/CpuFeatures.h"
+
+// Feeds one reading per device per tick for 100k devices through an
+// AnomalyDetector, both through observe() with pre-resolved device ids and
+// through onReadings() the way DatabaseManager delivers committed batches.
+// A handful of devices get a methane spike to check that alerts fire.
+
+int main() {
+    const std::size_t devices = 100000;
+    const int ticks = 50;
+    const std::int64_t start = 1700000000000000;
+
+    std::mt19937_64 rng(42);
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    AnomalyDetector detector;
+    const std::int64_t lastTick = start + static_cast<std::int64_t>(ticks - 1) * 60000000;
+    std::uint64_t spikes = 0;
+    detector.setAlertHandler([&](std::span<const AnomalyAlert> alerts) {
+        for (const AnomalyAlert& alert : alerts) {
+            if (alert.kind == AnomalyKind::Spike && alert.channel == ReadingChannel::Methane && alert.timestamp == lastTick) spikes++;
+        }
+    });
+
+    std::vector<std::uint32_t> ids(devices);
+    std::vector<ReadingInput> inputs(devices);
+    for (std::size_t d = 0; d < devices; d++) {
+        inputs[d].user = "device" + std::to_string(d);
+        ids[d] = detector.deviceId(inputs[d].user);
+    }
+
+    std::vector<Reading> readings(devices);
+    std::vector<std::int64_t> timestamps(devices);
+    double observeSeconds = 0.0;
+    double observerSeconds = 0.0;
+    for (int t = 0; t < ticks; t++) {
+        for (std::size_t d = 0; d < devices; d++) {
+            Reading& r = readings[d];
+            r.timestamp = start + static_cast<std::int64_t>(t) * 60000000;
+            r.carbonDioxide = 400.0 + 5.0 * noise(rng);
+            r.methane = 2.0 + 0.1 * noise(rng);
+            r.ammonia = 0.3 + 0.02 * noise(rng);
+            r.inductivity = 10.0 + noise(rng);
+            r.reflectance = 0.5 + 0.01 * noise(rng);
+            if (t == ticks - 1 && d % 10000 == 0) {
+                r.methane += 5.0;
+            }
+            inputs[d] = {r.carbonDioxide, r.methane, r.ammonia, r.inductivity, r.reflectance, inputs[d].user, r.timestamp};
+            timestamps[d] = r.timestamp;
+        }
+        // Alternate the two entry points so both see the same warm state.
+        auto begin = std::chrono::steady_clock::now();
+        if (t % 2 == 0) {
+            detector.observe(ids, readings);
+            observeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+        else {
+            detector.onReadings(inputs, timestamps);
+            observerSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+        }
+    }
+
+    const double perPath = static_cast<double>(devices) * ticks / 2;
+    AnomalyDetectorStats stats = detector.stats();
+    std::cout << "kernel: " << (cpuFeatures().avx2 ? "AVX2" : "scalar") << std::endl;
+    std::cout << "devices " << stats.devices << ", samples " << stats.samples << ", alerts " << stats.alerts
+              << std::endl;
+    std::cout << "methane spikes on the last tick: " << spikes << " (" << devices / 10000 << " injected)" << std::endl;
+    std::cout << "observe()     : " << perPath / observeSeconds / 1e6 << " M readings/s" << std::endl;
+    std::cout << "onReadings()  : " << perPath / observerSeconds / 1e6 << " M readings/s" << std::endl;
+    return 0;
+}
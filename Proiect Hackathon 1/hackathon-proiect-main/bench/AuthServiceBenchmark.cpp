@@ -0,0 +1,72 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/AuthService.h"
+
+// Login storm against AuthService: four request threads fire 600 logins
+// (one in ten with a wrong password) as fast as they can, for several worker
+// pool sizes. Reports how long a submit call keeps the request thread, how
+// many logins were turned away once the queue filled, and queue wait against
+// hash time. Uses 20000 PBKDF2 iterations so a run stays short.
+
+int main() {
+    const std::string dbName = "authServiceBench.db";
+    const int accounts = 50;
+    const int requestThreads = 4;
+    const int loginsPerThread = 150;
+
+    std::printf("%8s %8s %10s %10s %12s %12s %12s %12s %12s\n", "workers", "ok", "failed", "overload",
+                "submit max", "wait p50", "wait p99", "hash p50", "hash p99");
+    for (const std::size_t workerCount : {1, 2, 4}) {
+        std::remove(dbName.c_str());
+        AuthServiceConfig config;
+        config.workers = workerCount;
+        config.queueCapacity = 128;
+        config.iterations = 20000;
+        AuthService auth(dbName, config);
+        for (int i = 0; i < accounts; i++) {
+            auth.newAccount("user" + std::to_string(i), "password" + std::to_string(i),
+                            "user" + std::to_string(i) + "@example.com").wait();
+        }
+        auth.resetLatencies();
+
+        std::atomic<int> ok{0};
+        std::atomic<int> failed{0};
+        std::atomic<int> overloaded{0};
+        std::atomic<long long> submitMaxNanos{0};
+        {
+            std::vector<std::jthread> clients;
+            for (int t = 0; t < requestThreads; t++) {
+                clients.emplace_back([&, t] {
+                    for (int i = 0; i < loginsPerThread; i++) {
+                        const int id = (t * loginsPerThread + i) % accounts;
+                        const std::string password = i % 10 == 0 ? "wrong" : "password" + std::to_string(id);
+                        const auto start = std::chrono::steady_clock::now();
+                        auth.checkPassword("user" + std::to_string(id) + "@example.com", password,
+                                           [&](const AuthStatus status) {
+                                               if (status == AuthStatus::Ok) ok++;
+                                               else if (status == AuthStatus::Failed) failed++;
+                                               else overloaded++;
+                                           });
+                        const long long nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - start).count();
+                        long long seen = submitMaxNanos.load();
+                        while (nanos > seen && !submitMaxNanos.compare_exchange_weak(seen, nanos)) {}
+                    }
+                });
+            }
+        }
+        auth.stop();
+
+        const AuthServiceStats stats = auth.stats();
+        std::printf("%8zu %8d %10d %10d %9.1f us %9.0f us %9.0f us %9.0f us %9.0f us\n", workerCount, ok.load(),
+                    failed.load(), overloaded.load(), submitMaxNanos.load() / 1000.0, stats.queueWait.p50Micros,
+                    stats.queueWait.p99Micros, stats.hashTime.p50Micros, stats.hashTime.p99Micros);
+    }
+    std::remove(dbName.c_str());
+    return 0;
+}
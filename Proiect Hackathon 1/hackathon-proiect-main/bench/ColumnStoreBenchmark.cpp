@@ -0,0 +1,84 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "../src/CpuFeatures.h"
+#include "../src/DatabaseManager.h"
+#include "../src/ReadingColumnStore.h"
+
+// Loads synthetic readings through DatabaseManager with a ReadingColumnStore
+// attached, then compares a methane min/max/sum/count over one device with the
+// equivalent SQL aggregate on the readings table.
+
+template <typename Fn>
+static double averageMicros(int repeats, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < repeats; i++) {
+        fn();
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / repeats;
+}
+
+int main() {
+    const std::string dbName = "columnStoreBench.db";
+    const std::size_t rowsPerDevice = 250000;
+    const int devices = 4;
+    std::remove(dbName.c_str());
+
+    DatabaseManager database(dbName);
+    ReadingColumnStore store;
+    database.addObserver(&store);
+    database.setBatchSize(8192);
+
+    std::vector<ReadingInput> readings;
+    readings.reserve(rowsPerDevice * devices);
+    const std::int64_t start = 1700000000000000;
+    for (std::size_t i = 0; i < rowsPerDevice; i++) {
+        for (int d = 0; d < devices; d++) {
+            double x = static_cast<double>((i * 7 + d) % 1000);
+            readings.push_back({400.0 + x, 1.5 + x / 100.0, 0.2 + x / 1000.0, x / 10.0, 1.0 - x / 1000.0,
+                                "device" + std::to_string(d), start + static_cast<std::int64_t>(i) * 1000000});
+        }
+    }
+    database.addReadings(readings);
+
+    sqlite3* db = nullptr;
+    sqlite3_open(dbName.c_str(), &db);
+    sqlite3_stmt* stmt = nullptr;
+    sqlite3_prepare_v2(db, "SELECT COUNT(*), SUM(methane), MIN(methane), MAX(methane) FROM readings WHERE user = ?;",
+                       -1, &stmt, nullptr);
+    double sqlSum = 0.0;
+    double sqlMicros = averageMicros(10, [&] {
+        sqlite3_bind_text(stmt, 1, "device1", -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            sqlSum = sqlite3_column_double(stmt, 1);
+        }
+        sqlite3_reset(stmt);
+    });
+    sqlite3_finalize(stmt);
+    sqlite3_close(db);
+
+    ChannelAggregate full;
+    double fullMicros = averageMicros(100, [&] {
+        full = store.aggregate("device1", ReadingChannel::Methane, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max());
+    });
+    // Misaligned range: partial chunks at both ends go through the SIMD kernel.
+    ChannelAggregate partial;
+    const std::int64_t from = start + 1234 * 1000000LL;
+    const std::int64_t to = start + 201234 * 1000000LL;
+    double partialMicros = averageMicros(100, [&] {
+        partial = store.aggregate("device1", ReadingChannel::Methane, from, to);
+    });
+
+    std::cout << "kernel: " << (cpuFeatures().avx2 ? "AVX2" : cpuFeatures().sse2 ? "SSE2" : "scalar") << std::endl;
+    std::cout << "SQL aggregate (" << rowsPerDevice << " rows)    : " << sqlMicros << " us, sum " << sqlSum << std::endl;
+    std::cout << "column store, full range        : " << fullMicros << " us, sum " << full.sum << std::endl;
+    std::cout << "column store, " << partial.count << " row range   : " << partialMicros << " us, mean "
+              << partial.mean << std::endl;
+
+    std::remove(dbName.c_str());
+    return 0;
+}
@@ -0,0 +1,100 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/DumbsterCache.h"
+#include "../src/DumbsterDatabaseManager.h"
+
+// Seeds a fleet of dumpsters, then measures getDumbster / isDumbsterFull
+// latency percentiles for random ids and getDumbstersStreet / City for random
+// keys, first against SQLite and then with a DumbsterCache attached.
+
+struct Percentiles {
+    double p50;
+    double p99;
+};
+
+template <typename Fn>
+static Percentiles measure(const std::vector<int>& ids, Fn&& fn) {
+    std::vector<double> nanos;
+    nanos.reserve(ids.size());
+    for (int id : ids) {
+        auto start = std::chrono::steady_clock::now();
+        fn(id);
+        nanos.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(nanos.begin(), nanos.end());
+    return {nanos[nanos.size() / 2], nanos[nanos.size() * 99 / 100]};
+}
+
+int main() {
+    const std::string dbName = "dumbsterCacheBench.db";
+    const int fleet = 100000;
+    const int lookups = 200000;
+    std::remove(dbName.c_str());
+
+    DumbsterDatabaseManager database(dbName);
+    {
+        sqlite3* db = nullptr;
+        sqlite3_open(dbName.c_str(), &db);
+        sqlite3_exec(db, "BEGIN;", nullptr, nullptr, nullptr);
+        sqlite3_stmt* stmt = nullptr;
+        sqlite3_prepare_v2(db, "INSERT INTO dumbster (city, county, street, streetNumber, isFull, useNumber) VALUES (?, ?, ?, ?, ?, 0);",
+                           -1, &stmt, nullptr);
+        for (int i = 0; i < fleet; i++) {
+            const std::string city = "City" + std::to_string(i % 50);
+            const std::string county = "County" + std::to_string(i % 10);
+            const std::string street = "Street" + std::to_string(i % 2000);
+            sqlite3_bind_text(stmt, 1, city.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 2, county.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_text(stmt, 3, street.c_str(), -1, SQLITE_TRANSIENT);
+            sqlite3_bind_int(stmt, 4, i % 200);
+            sqlite3_bind_int(stmt, 5, i % 3 == 0);
+            sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        }
+        sqlite3_finalize(stmt);
+        sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr);
+        sqlite3_close(db);
+    }
+
+    std::mt19937 rng(3);
+    std::vector<int> ids(lookups);
+    for (int& id : ids) id = 1 + static_cast<int>(rng() % fleet);
+
+    std::vector<int> keys(2000);
+    for (int& key : keys) key = static_cast<int>(rng() % 2000);
+
+    std::size_t sink = 0;
+    const Percentiles sqlGet = measure(ids, [&](int id) { sink += database.getDumbster(id).streetNumber; });
+    const Percentiles sqlFull = measure(ids, [&](int id) { sink += database.isDumbsterFull(id); });
+    const Percentiles sqlStreet = measure(keys, [&](int key) { sink += database.getDumbstersStreet("Street" + std::to_string(key)).size(); });
+    const Percentiles sqlCity = measure(keys, [&](int key) { sink += database.getDumbstersCity("City" + std::to_string(key % 50)).size(); });
+
+    DumbsterCache cache;
+    auto loadStart = std::chrono::steady_clock::now();
+    database.attachCache(&cache);
+    const double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    const Percentiles cachedGet = measure(ids, [&](int id) { sink += database.getDumbster(id).streetNumber; });
+    const Percentiles cachedFull = measure(ids, [&](int id) { sink += database.isDumbsterFull(id); });
+    const Percentiles cachedStreet = measure(keys, [&](int key) { sink += database.getDumbstersStreet("Street" + std::to_string(key)).size(); });
+    const Percentiles cachedCity = measure(keys, [&](int key) { sink += database.getDumbstersCity("City" + std::to_string(key % 50)).size(); });
+
+    std::cout << fleet << " dumpsters, " << lookups << " random lookups (checksum " << sink << ")" << std::endl;
+    std::cout << "cache load: " << loadMillis << " ms for " << cache.size() << " rows" << std::endl;
+    std::cout << "getDumbster    SQLite p50 " << sqlGet.p50 << " ns, p99 " << sqlGet.p99 << " ns | cache p50 "
+              << cachedGet.p50 << " ns, p99 " << cachedGet.p99 << " ns" << std::endl;
+    std::cout << "isDumbsterFull SQLite p50 " << sqlFull.p50 << " ns, p99 " << sqlFull.p99 << " ns | cache p50 "
+              << cachedFull.p50 << " ns, p99 " << cachedFull.p99 << " ns" << std::endl;
+    std::cout << "getDumbstersStreet (" << fleet / 2000 << " rows) SQLite p50 " << sqlStreet.p50 << " ns, p99 " << sqlStreet.p99
+              << " ns | cache p50 " << cachedStreet.p50 << " ns, p99 " << cachedStreet.p99 << " ns" << std::endl;
+    std::cout << "getDumbstersCity (" << fleet / 50 << " rows) SQLite p50 " << sqlCity.p50 << " ns, p99 " << sqlCity.p99
+              << " ns | cache p50 " << cachedCity.p50 << " ns, p99 " << cachedCity.p99 << " ns" << std::endl;
+
+    std::remove(dbName.c_str());
+    return 0;
+}
@@ -0,0 +1,87 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/DumbsterEventBus.h"
+
+// Reports two million samples for a fleet of 10,000 dumpsters, of which about
+// one in fifty changes the full state, and measures report() throughput with
+// no subscribers, with pull-queue subscribers drained by a consumer thread,
+// and with a callback subscriber dispatched by a MonitorScheduler. A last run
+// with a small buffer and nobody draining it shows the drop counters.
+
+struct Run {
+    double reportsPerSecond;
+    DumbsterEventBusStats stats;
+    std::uint64_t received;
+};
+
+static Run run(const int queues, const bool callback, const std::size_t bufferSize, const bool consume) {
+    const int fleet = 10000;
+    const int rounds = 200;
+    DumbsterEventBusConfig config;
+    config.bufferSize = bufferSize;
+    MonitorScheduler scheduler(1);
+    DumbsterEventBus bus(config);
+    std::atomic<std::uint64_t> received{0};
+
+    std::vector<std::shared_ptr<DumbsterEventQueue>> subscriptions;
+    for (int i = 0; i < queues; i++) subscriptions.push_back(bus.subscribeQueue());
+    if (callback) {
+        bus.subscribe([&](const DumbsterEvent&) { received.fetch_add(1, std::memory_order_relaxed); });
+        bus.attach(scheduler);
+    }
+    std::atomic<bool> done{false};
+    std::jthread consumer;
+    if (consume && queues > 0) {
+        consumer = std::jthread([&] {
+            std::vector<DumbsterEvent> events;
+            while (true) {
+                const bool finished = done.load();
+                std::size_t drained = 0;
+                for (auto& queue : subscriptions) drained += queue->drain(events);
+                received.fetch_add(drained, std::memory_order_relaxed);
+                events.clear();
+                if (finished) break;
+                if (drained == 0) std::this_thread::yield();
+            }
+        });
+    }
+
+    std::mt19937 rng(20);
+    std::vector<bool> full(fleet, false);
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (int id = 0; id < fleet; id++) {
+            if (rng() % 50 == 0) full[id] = !full[id];
+            bus.report(id, full[id], full[id] ? 90.0f : 30.0f);
+        }
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    done = true;
+    if (consumer.joinable()) consumer.join();
+    if (callback) {
+        bus.detach();
+        while (bus.dispatch() > 0) {}
+    }
+    return {static_cast<double>(fleet) * rounds / seconds, bus.stats(), received.load()};
+}
+
+int main() {
+    std::printf("%-34s %14s %10s %12s %10s %10s\n", "subscribers", "reports/s", "events", "delivered", "dropped", "received");
+    auto print = [](const char* name, const Run& r) {
+        std::printf("%-34s %14.0f %10llu %12llu %10llu %10llu\n", name, r.reportsPerSecond,
+                    static_cast<unsigned long long>(r.stats.published), static_cast<unsigned long long>(r.stats.delivered),
+                    static_cast<unsigned long long>(r.stats.dropped), static_cast<unsigned long long>(r.received));
+    };
+    print("none", run(0, false, 1024, true));
+    print("1 queue", run(1, false, 1 << 16, true));
+    print("4 queues", run(4, false, 1 << 16, true));
+    print("1 callback (scheduler dispatch)", run(0, true, 1 << 16, false));
+    print("1 queue, 64 slots, not drained", run(1, false, 64, false));
+    return 0;
+}
@@ -0,0 +1,57 @@
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/DumbsterCache.h"
+
+// Builds a fleet with realistic Romanian address names and reports bytes per
+// dumpster held as DumbsterData rows (the pre-interning cache layout) against
+// DumbsterCache's compact records over a StringPool.
+
+static std::size_t heapBytes(const std::string& text) {
+    // Short strings live inside the std::string object (SSO) and cost nothing extra.
+    const char* begin = reinterpret_cast<const char*>(&text);
+    const bool inline_ = text.data() >= begin && text.data() < begin + sizeof(std::string);
+    return inline_ ? 0 : text.capacity() + 1;
+}
+
+int main() {
+    const int fleet = 1000000;
+    const char* counties[] = {"Bucuresti", "Cluj", "Timis", "Iasi", "Constanta", "Brasov", "Prahova", "Dolj"};
+    const char* kinds[] = {"Strada", "Bulevardul", "Calea", "Aleea", "Soseaua"};
+
+    std::vector<DumbsterData> rows;
+    rows.reserve(fleet);
+    for (int i = 0; i < fleet; i++) {
+        const int county = i % 8;
+        const int city = i % 120;
+        const int street = i % 20000;
+        DumbsterData row("Municipiul " + std::string(counties[county]) + " Sector " + std::to_string(city),
+                         std::string("Judetul ") + counties[county],
+                         std::string(kinds[street % 5]) + " Independentei " + std::to_string(street),
+                         i % 250);
+        row.id = i + 1;
+        row.isFull = i % 3 == 0;
+        rows.push_back(std::move(row));
+    }
+
+    std::size_t before = rows.capacity() * sizeof(DumbsterData);
+    for (const DumbsterData& row : rows) {
+        before += heapBytes(row.city) + heapBytes(row.county) + heapBytes(row.street);
+    }
+
+    DumbsterCache cache;
+    cache.assign(rows);
+    const DumbsterCacheMemory after = cache.memoryUsage();
+
+    std::cout << fleet << " dumpsters, sizeof(DumbsterData) " << sizeof(DumbsterData)
+              << " B, sizeof(DumbsterRecord) " << sizeof(DumbsterRecord) << " B" << std::endl;
+    std::cout << "DumbsterData rows: " << static_cast<double>(before) / fleet << " B/dumpster ("
+              << before / (1024 * 1024) << " MiB)" << std::endl;
+    std::cout << "DumbsterCache:     " << static_cast<double>(after.total()) / fleet << " B/dumpster ("
+              << after.total() / (1024 * 1024) << " MiB; records " << after.recordBytes / (1024 * 1024)
+              << " MiB, strings " << after.stringBytes / 1024 << " KiB, indexes "
+              << after.indexBytes / (1024 * 1024) << " MiB)" << std::endl;
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/FillForecaster.h"
+
+// Simulates five weeks of hourly, noisy fullness samples for a fleet whose
+// fill rates depend on the weekday, then reports: observe() throughput, the
+// time of a parallel recompute() (keeping two profile half-lives, so all five
+// weeks are replayed), the kept history's size, and the error of the predicted time-to-full
+// against the true (noise-free) one, with and without the weekday profile.
+
+struct Bin {
+    double rate;   // percent per hour on an average weekday
+    double level;  // true fullness
+};
+
+// Sunday .. Saturday.
+static const std::array<double, 7> weekdayShape = {0.5, 1.6, 1.0, 1.0, 1.0, 1.0, 1.8};
+
+static double trueHoursToFull(double level, std::int64_t now, const double rate, const double threshold) {
+    double hours = 0;
+    while (level < threshold && hours < 24 * 7 * 8) {
+        const int day = static_cast<int>(((now / 86400) + 4) % 7);
+        level += rate * weekdayShape[day] * 0.05;
+        hours += 0.05;
+        now += 180;
+    }
+    return hours;
+}
+
+int main() {
+    const int fleet = 20000;
+    const std::int64_t start = 1767571200;  // Monday 2026-01-05 00:00 UTC
+    const int hoursSimulated = 5 * 7 * 24 + 13;
+
+    std::mt19937 rng(18);
+    std::uniform_real_distribution<double> rate(0.3, 1.2);
+    std::uniform_real_distribution<double> emptied(0.0, 5.0);
+    std::normal_distribution<double> noise(0.0, 2.0);
+
+    std::vector<Bin> bins(fleet);
+    for (Bin& bin : bins) bin = {rate(rng), emptied(rng)};
+
+    std::vector<float> readings(static_cast<std::size_t>(fleet) * hoursSimulated);
+    for (int hour = 0; hour < hoursSimulated; hour++) {
+        const int day = static_cast<int>(((start / 86400 + hour / 24) + 4) % 7);
+        for (int id = 0; id < fleet; id++) {
+            Bin& bin = bins[id];
+            bin.level += bin.rate * weekdayShape[day];
+            if (bin.level >= 95) bin.level = emptied(rng);
+            readings[static_cast<std::size_t>(hour) * fleet + id] = static_cast<float>(std::clamp(bin.level + noise(rng), 0.0, 100.0));
+        }
+    }
+    auto feed = [&](FillForecaster& forecaster) {
+        for (int hour = 0; hour < hoursSimulated; hour++) {
+            const std::int64_t now = start + static_cast<std::int64_t>(hour) * 3600;
+            for (int id = 0; id < fleet; id++) {
+                forecaster.observe(id, now, readings[static_cast<std::size_t>(hour) * fleet + id]);
+            }
+        }
+    };
+    const std::int64_t end = start + static_cast<std::int64_t>(hoursSimulated - 1) * 3600;
+
+    FillForecasterConfig seasonalConfig;
+    seasonalConfig.threads = 1;
+    FillForecaster seasonal(seasonalConfig);
+    auto begin = std::chrono::steady_clock::now();
+    feed(seasonal);
+    const double observeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+
+    FillForecasterConfig flatConfig;
+    flatConfig.minWeekdayHours = 1e18;  // every weekday factor stays 1
+    FillForecaster flat(flatConfig);
+    feed(flat);
+
+    std::vector<double> seasonalError;
+    std::vector<double> flatError;
+    for (int id = 0; id < fleet; id++) {
+        if (bins[id].level >= 80) continue;
+        const double truth = trueHoursToFull(bins[id].level, end, bins[id].rate, 80);
+        const auto a = seasonal.forecast(id);
+        const auto b = flat.forecast(id);
+        if (a && std::isfinite(a->hoursToFull)) seasonalError.push_back(std::abs(a->hoursToFull - truth));
+        if (b && std::isfinite(b->hoursToFull)) flatError.push_back(std::abs(b->hoursToFull - truth));
+    }
+    auto summarize = [](std::vector<double>& errors) {
+        double sum = 0;
+        for (double error : errors) sum += error;
+        std::sort(errors.begin(), errors.end());
+        std::cout << "mean " << sum / static_cast<double>(errors.size()) << " h, median " << errors[errors.size() / 2]
+                  << " h, p90 " << errors[errors.size() * 9 / 10] << " h (" << errors.size() << " bins)" << std::endl;
+    };
+
+    const std::vector<FillForecast> before = seasonal.soonest(100);
+    std::cout << fleet << " dumpsters, " << hoursSimulated << " hourly samples each" << std::endl;
+    std::cout << "observe: " << static_cast<double>(fleet) * hoursSimulated / observeSeconds / 1e6 << " M samples/s" << std::endl;
+
+    std::vector<std::size_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+    std::vector<FillForecast> after;
+    std::size_t historyBytes = 0;
+    for (const std::size_t threads : threadCounts) {
+        FillForecasterConfig config;
+        config.threads = threads;
+        config.historyHalfLives = 2;
+        FillForecaster replay(config);
+        feed(replay);
+        begin = std::chrono::steady_clock::now();
+        replay.recompute(end);
+        std::cout << "recompute (" << threads << " threads): "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() << " ms" << std::endl;
+        after = replay.soonest(100);
+        historyBytes = replay.historyBytes();
+    }
+    bool same = before.size() == after.size();
+    for (std::size_t i = 0; same && i < before.size(); i++) {
+        same = before[i].id == after[i].id && before[i].fullAt == after[i].fullAt;
+    }
+    std::cout << "recompute matches incremental forecasts: " << (same ? "yes" : "NO") << std::endl;
+    std::cout << "history: " << historyBytes / 1e6 << " MB" << std::endl;
+    std::cout << "100 soonest are full within " << after.back().hoursToFull << " h" << std::endl;
+
+    std::cout << "time-to-full error with weekday profile: ";
+    summarize(seasonalError);
+    std::cout << "time-to-full error, fill rate only:      ";
+    summarize(flatError);
+    return 0;
+}
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "../src/FillHistory.h"
+
+// Records two days of fullness samples, one every three minutes, for a fleet
+// of 20,000 dumpsters into a FillHistory and flushes the downsampled buckets
+// once per simulated hour. Reports record() throughput, flush time, the
+// memory used per dumpster by the ring arena, and the latency of fill-curve
+// queries that are served from memory only, and that also read stored buckets.
+
+static double percentile(std::vector<double>& values, const double p) {
+    std::sort(values.begin(), values.end());
+    return values[static_cast<std::size_t>(p * static_cast<double>(values.size() - 1))];
+}
+
+int main() {
+    const std::string dbName = "fillHistoryBench.db";
+    const int fleet = 20000;
+    const std::int64_t start = 1767571200;  // 2026-01-05 00:00 UTC
+    const std::int64_t period = 180;
+    const int steps = 2 * 24 * 3600 / period;
+    std::remove(dbName.c_str());
+
+    std::mt19937 rng(19);
+    std::uniform_real_distribution<float> rate(0.5f, 3.0f);
+    std::normal_distribution<float> noise(0.0f, 1.5f);
+    std::vector<float> rates(fleet);
+    std::vector<float> levels(fleet, 0.0f);
+    for (float& r : rates) r = rate(rng);
+
+    double recordSeconds = 0;
+    double flushSeconds = 0;
+    int flushCount = 0;
+    FillHistoryStats stats{};
+    {
+        FillHistory history(dbName);
+        history.reserve(fleet);
+        for (int step = 0; step < steps; step++) {
+            const std::int64_t now = start + step * period;
+            auto begin = std::chrono::steady_clock::now();
+            for (int id = 0; id < fleet; id++) {
+                levels[id] += rates[id] * static_cast<float>(period) / 3600.0f;
+                if (levels[id] >= 95) levels[id] = 0;
+                history.record(id, now, std::clamp(levels[id] + noise(rng), 0.0f, 100.0f));
+            }
+            recordSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+            if ((now + period) % 3600 == 0) {
+                begin = std::chrono::steady_clock::now();
+                history.flush();
+                flushSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+                flushCount++;
+            }
+        }
+
+        const std::int64_t end = start + steps * period;
+        std::vector<double> memoryOnly;
+        std::vector<double> withStored;
+        std::size_t points = 0;
+        for (int i = 0; i < 2000; i++) {
+            const int id = static_cast<int>(rng() % fleet);
+            auto begin = std::chrono::steady_clock::now();
+            points += history.curve(id, end - 6 * 3600, end).size();
+            memoryOnly.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+            begin = std::chrono::steady_clock::now();
+            points += history.curve(id, start, end).size();
+            withStored.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+        }
+        stats = history.stats();
+
+        const double samples = static_cast<double>(fleet) * steps;
+        std::cout << fleet << " dumpsters, " << steps << " samples each" << std::endl;
+        std::cout << "record: " << samples / recordSeconds / 1e6 << " M samples/s" << std::endl;
+        std::cout << "flush: " << flushCount << " flushes, " << stats.bucketsWritten << " buckets, "
+                  << flushSeconds * 1000 / flushCount << " ms per flush, " << stats.lost << " samples lost" << std::endl;
+        std::cout << "ring arena: " << static_cast<double>(stats.memoryBytes) / fleet << " B per dumpster ("
+                  << static_cast<double>(stats.memoryBytes) / (1 << 20) << " MiB)" << std::endl;
+        std::printf("curve, last 6 h (memory):    p50 %.1f us, p99 %.1f us\n", percentile(memoryOnly, 0.5),
+                    percentile(memoryOnly, 0.99));
+        std::printf("curve, 2 days (with stored): p50 %.1f us, p99 %.1f us\n", percentile(withStored, 0.5),
+                    percentile(withStored, 0.99));
+        std::cout << "(" << points << " points returned)" << std::endl;
+    }
+    std::remove(dbName.c_str());
+    return 0;
+}
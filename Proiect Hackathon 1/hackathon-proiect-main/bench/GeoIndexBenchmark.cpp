@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/DumbsterGeoIndex.h"
+
+// Loads 1M synthetic dumpsters clustered around cities in a Romania-sized
+// box into a DumbsterGeoIndex, then measures k-nearest and 2 km radius query
+// latencies for full dumpsters. A sample of queries is checked against a
+// linear scan, whose latency is reported for comparison.
+
+struct Percentiles {
+    double p50;
+    double p99;
+};
+
+template <typename Fn>
+static Percentiles measure(const std::vector<GeoPoint>& queries, Fn&& fn) {
+    std::vector<double> nanos;
+    nanos.reserve(queries.size());
+    for (const GeoPoint& query : queries) {
+        auto start = std::chrono::steady_clock::now();
+        fn(query);
+        nanos.push_back(std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(nanos.begin(), nanos.end());
+    return {nanos[nanos.size() / 2], nanos[nanos.size() * 99 / 100]};
+}
+
+static std::vector<GeoMatch> scan(const std::vector<DumbsterLocation>& fleet, const GeoPoint& center, const double radius) {
+    std::vector<GeoMatch> matches;
+    for (const DumbsterLocation& location : fleet) {
+        if (!location.isFull) continue;
+        const double distance = distanceMeters(center, location.point);
+        if (distance <= radius) matches.push_back({location.id, distance});
+    }
+    std::sort(matches.begin(), matches.end(), [](const GeoMatch& a, const GeoMatch& b) {
+        return a.distance != b.distance ? a.distance < b.distance : a.id < b.id;
+    });
+    return matches;
+}
+
+static bool same(const std::vector<GeoMatch>& a, const std::vector<GeoMatch>& b) {
+    if (a.size() != b.size()) return false;
+    for (std::size_t i = 0; i < a.size(); i++) {
+        if (a[i].id != b[i].id) return false;
+    }
+    return true;
+}
+
+int main() {
+    const int fleetSize = 1000000;
+    const int queryCount = 20000;
+    const int checkedQueries = 200;
+    const std::size_t k = 10;
+    const double radius = 2000;
+
+    std::mt19937 rng(16);
+    std::uniform_real_distribution<double> latitude(43.7, 48.2);
+    std::uniform_real_distribution<double> longitude(20.3, 29.6);
+    std::normal_distribution<double> spread(0, 0.05);  // about 5 km around a city centre
+
+    std::vector<GeoPoint> cities(300);
+    for (GeoPoint& city : cities) city = {latitude(rng), longitude(rng)};
+
+    std::vector<DumbsterLocation> fleet;
+    fleet.reserve(fleetSize);
+    for (int i = 0; i < fleetSize; i++) {
+        // Most dumpsters sit in cities, the rest are spread over the countryside.
+        GeoPoint point{latitude(rng), longitude(rng)};
+        if (i % 10 != 0) {
+            const GeoPoint& city = cities[rng() % cities.size()];
+            point = {city.latitude + spread(rng), city.longitude + spread(rng) * 1.4};
+        }
+        fleet.push_back({i + 1, point, rng() % 4 == 0});
+    }
+
+    std::vector<GeoPoint> queries(queryCount);
+    for (GeoPoint& query : queries) {
+        const GeoPoint& city = cities[rng() % cities.size()];
+        query = {city.latitude + spread(rng), city.longitude + spread(rng) * 1.4};
+    }
+
+    DumbsterGeoIndex index;
+    auto loadStart = std::chrono::steady_clock::now();
+    index.assign(fleet);
+    const double loadMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+
+    std::size_t found = 0;
+    const Percentiles nearest = measure(queries, [&](const GeoPoint& query) {
+        found += index.nearest(query, k, FullFilter::Full).size();
+    });
+    std::size_t inRadius = 0;
+    const Percentiles within = measure(queries, [&](const GeoPoint& query) {
+        inRadius += index.within(query, radius, FullFilter::Full).size();
+    });
+
+    const std::vector<GeoPoint> sample(queries.begin(), queries.begin() + checkedQueries);
+    int mismatches = 0;
+    for (const GeoPoint& query : sample) {
+        std::vector<GeoMatch> expected = scan(fleet, query, radius);
+        if (!same(index.within(query, radius, FullFilter::Full), expected)) mismatches++;
+        std::vector<GeoMatch> all = scan(fleet, query, 1e9);
+        all.resize(std::min(all.size(), k));
+        if (!same(index.nearest(query, k, FullFilter::Full), all)) mismatches++;
+    }
+    std::size_t sink = 0;
+    const Percentiles linear = measure(sample, [&](const GeoPoint& query) { sink += scan(fleet, query, radius).size(); });
+
+    std::cout << fleetSize << " dumpsters, bulk load " << loadMillis << " ms" << std::endl;
+    std::cout << "nearest " << k << " full: p50 " << nearest.p50 / 1000 << " us, p99 " << nearest.p99 / 1000
+              << " us (avg " << static_cast<double>(found) / queryCount << " results)" << std::endl;
+    std::cout << "within " << radius << " m, full: p50 " << within.p50 / 1000 << " us, p99 " << within.p99 / 1000
+              << " us (avg " << static_cast<double>(inRadius) / queryCount << " results)" << std::endl;
+    std::cout << "linear scan: p50 " << linear.p50 / 1000 << " us, p99 " << linear.p99 / 1000 << " us (checksum "
+              << sink << ")" << std::endl;
+    std::cout << "mismatches against linear scan: " << mismatches << " of " << 2 * checkedQueries << std::endl;
+    return mismatches == 0 ? 0 : 1;
+}
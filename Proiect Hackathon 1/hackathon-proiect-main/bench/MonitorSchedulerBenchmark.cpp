@@ -0,0 +1,107 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/MonitorScheduler.h"
+
+// Simulates 1k, 10k and 100k dumpsters sampling once per second on one
+// MonitorScheduler and reports CPU time, resident memory and how late the
+// samples ran. For comparison, the old thread-per-dumpster model is measured
+// at 1k dumpsters (larger counts run into OS thread limits).
+
+static long residentKiB() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) return std::stol(line.substr(6));
+    }
+    return -1;
+}
+
+struct SimulatedDumpster {
+    std::atomic<std::uint64_t> samples{0};
+    std::atomic<float> fullness{0.0f};
+    MonitorScheduler::Clock::time_point next;
+};
+
+int main() {
+    const auto period = std::chrono::seconds(1);
+    const auto runFor = std::chrono::seconds(5);
+
+    for (const std::size_t count : {1000, 10000, 100000}) {
+        const long rssBefore = residentKiB();
+        std::vector<SimulatedDumpster> dumpsters(count);
+        std::atomic<std::int64_t> lateMicrosSum{0};
+        std::atomic<std::int64_t> lateMicrosMax{0};
+
+        const std::clock_t cpuStart = std::clock();
+        MonitorScheduler scheduler(std::thread::hardware_concurrency());
+        std::mt19937 rng(1);
+        std::vector<MonitorScheduler::TaskId> tasks;
+        const auto now = MonitorScheduler::Clock::now();
+        for (SimulatedDumpster& d : dumpsters) {
+            // Spread the phases so a tick does not fire the whole fleet at once.
+            const auto phase = std::chrono::microseconds(rng() % 1000000);
+            d.next = now + phase;
+            tasks.push_back(scheduler.schedule(period, phase, [&d, &lateMicrosSum, &lateMicrosMax, period] {
+                const auto late = std::chrono::duration_cast<std::chrono::microseconds>(MonitorScheduler::Clock::now() - d.next).count();
+                d.next += period;
+                lateMicrosSum += late;
+                std::int64_t max = lateMicrosMax.load();
+                while (late > max && !lateMicrosMax.compare_exchange_weak(max, late)) {}
+                d.fullness = static_cast<float>(d.samples.fetch_add(1) % 100);
+            }));
+        }
+        const long rssRunning = residentKiB();
+        std::this_thread::sleep_for(runFor);
+        const auto stopStart = std::chrono::steady_clock::now();
+        for (MonitorScheduler::TaskId task : tasks) {
+            scheduler.cancel(task);
+        }
+        const double stopMicros = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - stopStart).count() / count;
+        const double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        const MonitorSchedulerStats stats = scheduler.stats();
+
+        std::cout << count << " dumpsters: " << stats.runs << " samples, CPU " << cpuSeconds << " s ("
+                  << 100.0 * cpuSeconds / std::chrono::duration<double>(runFor).count() << "% of one core), RSS +"
+                  << rssRunning - rssBefore << " KiB, avg late " << lateMicrosSum / std::max<std::uint64_t>(1, stats.runs)
+                  << " us, max late " << lateMicrosMax << " us, missed " << stats.missed << ", cancel " << stopMicros
+                  << " us/task" << std::endl;
+    }
+
+    {
+        const std::size_t count = 1000;
+        const long rssBefore = residentKiB();
+        const std::clock_t cpuStart = std::clock();
+        std::vector<std::jthread> threads;
+        std::atomic<std::uint64_t> samples{0};
+        for (std::size_t i = 0; i < count; i++) {
+            threads.emplace_back([&samples, period](std::stop_token token) {
+                while (!token.stop_requested()) {
+                    samples++;
+                    std::this_thread::sleep_for(period);
+                }
+            });
+        }
+        const long rssRunning = residentKiB();
+        std::this_thread::sleep_for(runFor);
+        const auto stopStart = std::chrono::steady_clock::now();
+        for (std::jthread& thread : threads) {
+            thread.request_stop();
+        }
+        threads.clear();  // each thread notices the stop only after its current sleep
+        const double stopMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stopStart).count();
+        const double cpuSeconds = static_cast<double>(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+        std::cout << count << " threads (old model): " << samples << " samples, CPU " << cpuSeconds << " s, RSS +"
+                  << rssRunning - rssBefore << " KiB (" << (rssRunning - rssBefore) / static_cast<long>(count)
+                  << " KiB/dumpster), stopping all took " << stopMillis << " ms" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "../src/AccountDatabaseManager.h"
+#include "../src/PasswordHash.h"
+
+// Measures PBKDF2-HMAC-SHA256 at several iteration counts (time per hash and
+// logins per second on one core), then full checkPassword() logins through
+// AccountDatabaseManager at the default cost, including the one-off rehash of
+// an account stored with the legacy unsalted hash.
+
+template <typename Fn>
+static double secondsPer(Fn&& fn, const double budget = 0.5) {
+    int runs = 0;
+    const auto start = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < budget || runs < 3) {
+        fn();
+        runs++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+    return elapsed / runs;
+}
+
+int main() {
+    std::printf("SHA256 backend: %s\n", SHA256::backendName(SHA256::backend()));
+    std::printf("%12s %12s %14s\n", "iterations", "ms/hash", "logins/s/core");
+    const std::string salt = newPasswordSalt();
+    unsigned sink = 0;
+    for (const std::uint32_t iterations : {1000u, 10000u, 100000u, 310000u, 600000u}) {
+        const double seconds = secondsPer([&] { sink += pbkdf2HmacSha256("correct horse battery", salt, iterations)[0]; });
+        std::printf("%12u %12.3f %14.1f\n", iterations, seconds * 1000, 1 / seconds);
+    }
+
+    const std::string dbName = "passwordHashBench.db";
+    std::remove(dbName.c_str());
+    {
+        AccountDatabaseManager accounts(dbName);
+        accounts.newAccount("bench", "correct horse battery", "bench@example.com");
+
+        // An account as the old code stored it: bare SHA-256 hex, no salt.
+        sqlite3* db = nullptr;
+        sqlite3_open(dbName.c_str(), &db);
+        const std::string legacy = "INSERT INTO accountData (username, password, email) VALUES ('old', '" +
+                                   AccountDatabaseManager::encryptPassword("hunter2") + "', 'old@example.com');";
+        sqlite3_exec(db, legacy.c_str(), nullptr, nullptr, nullptr);
+        sqlite3_close(db);
+
+        auto start = std::chrono::steady_clock::now();
+        const bool legacyLogin = accounts.checkPassword("old@example.com", "hunter2");
+        const double rehashMillis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        const AccountData upgraded = accounts.getAccountInfo("old@example.com");
+
+        const double login = secondsPer([&] { sink += accounts.checkPassword("bench@example.com", "correct horse battery"); }, 1.0);
+        const double rejected = secondsPer([&] { sink += accounts.checkPassword("bench@example.com", "wrong"); }, 1.0);
+
+        std::printf("legacy login %s, rehashed to %u iterations in %.1f ms\n", legacyLogin ? "ok" : "FAILED",
+                    upgraded.iterations, rehashMillis);
+        std::printf("checkPassword at %u iterations: %.1f logins/s (%.2f ms), wrong password %.2f ms\n",
+                    DefaultPasswordIterations, 1 / login, login * 1000, rejected * 1000);
+    }
+    std::remove(dbName.c_str());
+    return sink == 0xffffffffu ? 1 : 0;
+}
@@ -0,0 +1,58 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "../src/DatabaseManager.h"
+
+// Inserts the same synthetic e-nose samples with addReading (one implicit
+// transaction per row) and with addReadings at several batch sizes, and prints
+// the sustained rows/s for each.
+
+static std::vector<ReadingInput> makeReadings(std::size_t count) {
+    std::vector<ReadingInput> readings;
+    readings.reserve(count);
+    for (std::size_t i = 0; i < count; i++) {
+        double x = static_cast<double>(i % 1000);
+        readings.push_back({400.0 + x, 1.5 + x / 100.0, 0.2 + x / 1000.0, x / 10.0, 1.0 - x / 1000.0,
+                            "device" + std::to_string(i % 16) + "@bench"});
+    }
+    return readings;
+}
+
+static double rowsPerSecond(std::size_t rows, std::chrono::steady_clock::duration elapsed) {
+    return static_cast<double>(rows) / std::chrono::duration<double>(elapsed).count();
+}
+
+int main() {
+    const std::string dbName = "readingIngestBench.db";
+    const std::vector<ReadingInput> readings = makeReadings(20000);
+
+    {
+        std::remove(dbName.c_str());
+        DatabaseManager database(dbName);
+        const std::size_t rows = 500; // one fsync per row, keep it short
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t i = 0; i < rows; i++) {
+            const ReadingInput& r = readings[i];
+            database.addReading(r.carbonDioxide, r.methane, r.ammonia, r.inductivity, r.reflectance, r.user);
+        }
+        std::cout << "addReading (per row)      : "
+                  << rowsPerSecond(rows, std::chrono::steady_clock::now() - start) << " rows/s" << std::endl;
+    }
+
+    for (std::size_t batchSize : {1, 8, 64, 512, 4096, 20000}) {
+        std::remove(dbName.c_str());
+        DatabaseManager database(dbName);
+        database.setBatchSize(batchSize);
+        const std::size_t rows = batchSize == 1 ? 500 : readings.size();
+        auto start = std::chrono::steady_clock::now();
+        database.addReadings(std::span(readings).first(rows));
+        std::cout << "addReadings batch " << batchSize << " : "
+                  << rowsPerSecond(rows, std::chrono::steady_clock::now() - start) << " rows/s" << std::endl;
+    }
+
+    std::remove(dbName.c_str());
+    return 0;
+}
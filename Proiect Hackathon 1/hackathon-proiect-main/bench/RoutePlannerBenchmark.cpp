@@ -0,0 +1,67 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "../src/RoutePlanner.h"
+
+// Plans collection routes for 100 to 10,000 full dumpsters spread over a
+// city around one depot (trucks of 100 bins) and reports total distance
+// against wall time: after the construction heuristic, after plain local
+// search, and with more perturbations, single-threaded and on every core.
+// Each configuration is also planned with a different thread count to check
+// that the result does not depend on it.
+
+static std::vector<RouteStop> makeStops(const int count, const GeoPoint& depot, std::mt19937& rng) {
+    std::normal_distribution<double> district(0, 0.04);  // about 4 km
+    std::normal_distribution<double> street(0, 0.004);
+    std::vector<GeoPoint> districts(20);
+    for (GeoPoint& centre : districts) centre = {depot.latitude + district(rng), depot.longitude + district(rng) * 1.4};
+    std::vector<RouteStop> stops;
+    for (int i = 0; i < count; i++) {
+        const GeoPoint& centre = districts[rng() % districts.size()];
+        stops.push_back({i + 1, {centre.latitude + street(rng), centre.longitude + street(rng) * 1.4}, 1});
+    }
+    return stops;
+}
+
+static bool sameRoutes(const RoutePlan& a, const RoutePlan& b) {
+    if (a.routes.size() != b.routes.size() || a.unassigned != b.unassigned) return false;
+    for (std::size_t t = 0; t < a.routes.size(); t++) {
+        if (a.routes[t].stops != b.routes[t].stops) return false;
+    }
+    return true;
+}
+
+int main() {
+    const GeoPoint depot{46.770, 23.590};
+    std::vector<std::size_t> threadCounts{1};
+    if (std::thread::hardware_concurrency() > 1) threadCounts.push_back(std::thread::hardware_concurrency());
+    std::printf("%8s %7s %8s %7s %12s %12s %8s %10s %6s\n", "stops", "trucks", "threads", "kicks", "built km",
+                "final km", "gain", "wall ms", "same");
+    for (const int count : {100, 1000, 3000, 10000}) {
+        std::mt19937 rng(17);
+        const std::vector<RouteStop> stops = makeStops(count, depot, rng);
+        RoutePlannerConfig config;
+        config.depot = depot;
+        config.truckCapacities.assign(count / 100 + 1 + count / 500, 100);
+        for (const std::size_t kicks : {0, 50, 200}) {
+            for (const std::size_t threads : threadCounts) {
+                config.perturbations = kicks;
+                config.threads = threads;
+                auto start = std::chrono::steady_clock::now();
+                const RoutePlan plan = RoutePlanner(config).plan(stops);
+                const double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+                config.threads = threads == 1 ? 3 : 1;
+                const bool same = sameRoutes(plan, RoutePlanner(config).plan(stops));
+                std::printf("%8d %7zu %8zu %7zu %12.1f %12.1f %7.1f%% %10.1f %6s\n", count, config.truckCapacities.size(),
+                            threads, kicks, plan.constructionDistance / 1000, plan.distance / 1000,
+                            100 * (1 - plan.distance / plan.constructionDistance), millis, same ? "yes" : "NO");
+            }
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "../src/CpuFeatures.h"
+#include "../src/WasteClassifier.h"
+
+// Writes a synthetic five-class centroid model, samples readings around the
+// centroids and measures single-threaded classifications per second. The
+// centroids are made up for the benchmark, not calibrated against sensors.
+
+int main() {
+    const char* modelPath = "wasteClassifierBench.model";
+    const double centroids[5][5] = {
+        {450.0, 6.0, 1.2, 0.1, 0.2},   // organic
+        {410.0, 1.0, 0.1, 0.2, 0.9},   // plastic
+        {405.0, 0.8, 0.1, 0.1, 0.6},   // glass
+        {402.0, 0.5, 0.1, 0.9, 0.4},   // metal
+        {420.0, 2.0, 0.3, 0.1, 0.3}};  // paper
+    const char* names[5] = {"organic", "plastic", "glass", "metal", "paper"};
+    {
+        std::ofstream model(modelPath);
+        model << "classifier centroid\n";
+        model << "normalize 420 2 0.4 0.3 0.5  20 2 0.4 0.3 0.25\n";
+        for (int c = 0; c < 5; c++) {
+            model << "class " << names[c];
+            for (double v : centroids[c]) model << ' ' << v;
+            model << '\n';
+        }
+    }
+
+    WasteClassifier classifier;
+    if (!classifier.load(modelPath)) {
+        return 1;
+    }
+    std::remove(modelPath);
+
+    const std::size_t count = 1 << 20;
+    std::mt19937_64 rng(7);
+    std::normal_distribution<double> noise(0.0, 0.1);
+    std::vector<Reading> readings(count);
+    std::vector<std::uint32_t> truth(count);
+    for (std::size_t i = 0; i < count; i++) {
+        const std::uint32_t c = static_cast<std::uint32_t>(rng() % 5);
+        const double* m = centroids[c];
+        truth[i] = c;
+        readings[i] = {static_cast<std::int64_t>(i), m[0] * (1 + noise(rng) * 0.02), m[1] * (1 + noise(rng)),
+                       m[2] * (1 + noise(rng)), m[3] + noise(rng), m[4] + noise(rng) * 0.5};
+    }
+
+    std::vector<WasteClassification> out(count);
+    classifier.classify(readings, out);  // warm up
+    const int repeats = 10;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        classifier.classify(readings, out);
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::size_t correct = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        correct += out[i].label == truth[i];
+    }
+    std::cout << "kernel: " << (cpuFeatures().avx2 ? "AVX2" : "scalar") << ", classes " << classifier.classCount() << std::endl;
+    std::cout << "accuracy on synthetic readings: " << 100.0 * correct / count << "%" << std::endl;
+    std::cout << "throughput: " << count * repeats / seconds / 1e6 << " M classifications/s (1 core)" << std::endl;
+    return 0;
+}
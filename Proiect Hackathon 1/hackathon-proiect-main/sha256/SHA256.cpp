@@ -1,10 +1,34 @@
 #include "SHA256.h"
+#include "../src/CpuFeatures.h"
+#include <algorithm>
 #include <cstring>
 #include <sstream>
 #include <iomanip>
 
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
 constexpr std::array<uint32_t, 64> SHA256::K;
 
+// Portable until the static initializer below picks the best backend.
+std::atomic<SHA256::CompressFn> SHA256::s_compress{&SHA256::compressPortable};
+
+namespace {
+
+SHA256::Backend bestBackend() {
+	for (SHA256::Backend backend : {SHA256::Backend::ShaNi, SHA256::Backend::Avx2, SHA256::Backend::Ssse3}) {
+		if (SHA256::isSupported(backend)) {
+			return backend;
+		}
+	}
+	return SHA256::Backend::Portable;
+}
+
+const bool backendSelected = SHA256::setBackend(bestBackend());
+
+}
+
 SHA256::SHA256(): m_blocklen(0), m_bitlen(0) {
 	m_state[0] = 0x6a09e667;
 	m_state[1] = 0xbb67ae85;
@@ -17,15 +41,31 @@ SHA256::SHA256(): m_blocklen(0), m_bitlen(0) {
 }
 
 void SHA256::update(const uint8_t * data, size_t length) {
-	for (size_t i = 0 ; i < length ; i++) {
-		m_data[m_blocklen++] = data[i];
-		if (m_blocklen == 64) {
-			transform();
-
-			// End of the block
-			m_bitlen += 512;
-			m_blocklen = 0;
+	if (m_blocklen > 0) { // Top up the buffered partial block first
+		const size_t take = std::min<size_t>(64 - m_blocklen, length);
+		memcpy(m_data + m_blocklen, data, take);
+		m_blocklen += take;
+		data += take;
+		length -= take;
+		if (m_blocklen < 64) {
+			return;
 		}
+		transform();
+		m_bitlen += 512;
+		m_blocklen = 0;
+	}
+
+	const size_t blocks = length / 64;
+	if (blocks > 0) {
+		s_compress.load(std::memory_order_relaxed)(m_state, data, blocks);
+		m_bitlen += blocks * 512;
+		data += blocks * 64;
+		length -= blocks * 64;
+	}
+
+	if (length > 0) {
+		memcpy(m_data, data, length);
+		m_blocklen = length;
 	}
 }
 
@@ -63,45 +103,448 @@ uint32_t SHA256::sig1(uint32_t x) {
 }
 
 void SHA256::transform() {
+	s_compress.load(std::memory_order_relaxed)(m_state, m_data, 1);
+}
+
+void SHA256::compressPortable(uint32_t hash[8], const uint8_t * data, size_t blocks) {
 	uint32_t maj, xorA, ch, xorE, sum, newA, newE, m[64];
 	uint32_t state[8];
 
-	for (uint8_t i = 0, j = 0; i < 16; i++, j += 4) { // Split data in 32 bit blocks for the 16 first words
-		m[i] = (m_data[j] << 24) | (m_data[j + 1] << 16) | (m_data[j + 2] << 8) | (m_data[j + 3]);
+	for (; blocks > 0; blocks--, data += 64) {
+		for (uint8_t i = 0, j = 0; i < 16; i++, j += 4) { // Split data in 32 bit blocks for the 16 first words
+			m[i] = (data[j] << 24) | (data[j + 1] << 16) | (data[j + 2] << 8) | (data[j + 3]);
+		}
+
+		for (uint8_t k = 16 ; k < 64; k++) { // Remaining 48 blocks
+			m[k] = SHA256::sig1(m[k - 2]) + m[k - 7] + SHA256::sig0(m[k - 15]) + m[k - 16];
+		}
+
+		for(uint8_t i = 0 ; i < 8 ; i++) {
+			state[i] = hash[i];
+		}
+
+		for (uint8_t i = 0; i < 64; i++) {
+			maj   = SHA256::majority(state[0], state[1], state[2]);
+			xorA  = SHA256::rotr(state[0], 2) ^ SHA256::rotr(state[0], 13) ^ SHA256::rotr(state[0], 22);
+
+			ch = choose(state[4], state[5], state[6]);
+
+			xorE  = SHA256::rotr(state[4], 6) ^ SHA256::rotr(state[4], 11) ^ SHA256::rotr(state[4], 25);
+
+			sum  = m[i] + K[i] + state[7] + ch + xorE;
+			newA = xorA + maj + sum;
+			newE = state[3] + sum;
+
+			state[7] = state[6];
+			state[6] = state[5];
+			state[5] = state[4];
+			state[4] = newE;
+			state[3] = state[2];
+			state[2] = state[1];
+			state[1] = state[0];
+			state[0] = newA;
+		}
+
+		for(uint8_t i = 0 ; i < 8 ; i++) {
+			hash[i] += state[i];
+		}
 	}
+}
 
-	for (uint8_t k = 16 ; k < 64; k++) { // Remaining 48 blocks
-		m[k] = SHA256::sig1(m[k - 2]) + m[k - 7] + SHA256::sig0(m[k - 15]) + m[k - 16];
+// 64 rounds over a precomputed W[i] + K[i], unrolled so the working
+// variables stay in registers instead of shifting through an array.
+void SHA256::rounds(uint32_t hash[8], const uint32_t * wk) {
+	uint32_t a = hash[0], b = hash[1], c = hash[2], d = hash[3];
+	uint32_t e = hash[4], f = hash[5], g = hash[6], h = hash[7];
+
+#define SHA256_ROUND(a, b, c, d, e, f, g, h, i) \
+	{ \
+		const uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + choose(e, f, g) + wk[i]; \
+		d += t1; \
+		h = t1 + (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + majority(a, b, c); \
 	}
 
-	for(uint8_t i = 0 ; i < 8 ; i++) {
-		state[i] = m_state[i];
+	for (int i = 0; i < 64; i += 8) {
+		SHA256_ROUND(a, b, c, d, e, f, g, h, i);
+		SHA256_ROUND(h, a, b, c, d, e, f, g, i + 1);
+		SHA256_ROUND(g, h, a, b, c, d, e, f, i + 2);
+		SHA256_ROUND(f, g, h, a, b, c, d, e, i + 3);
+		SHA256_ROUND(e, f, g, h, a, b, c, d, i + 4);
+		SHA256_ROUND(d, e, f, g, h, a, b, c, i + 5);
+		SHA256_ROUND(c, d, e, f, g, h, a, b, i + 6);
+		SHA256_ROUND(b, c, d, e, f, g, h, a, i + 7);
 	}
 
-	for (uint8_t i = 0; i < 64; i++) {
-		maj   = SHA256::majority(state[0], state[1], state[2]);
-		xorA  = SHA256::rotr(state[0], 2) ^ SHA256::rotr(state[0], 13) ^ SHA256::rotr(state[0], 22);
+#undef SHA256_ROUND
+
+	hash[0] += a; hash[1] += b; hash[2] += c; hash[3] += d;
+	hash[4] += e; hash[5] += f; hash[6] += g; hash[7] += h;
+}
+
+#if CPU_X86
 
-		ch = choose(state[4], state[5], state[6]);
+namespace {
 
-		xorE  = SHA256::rotr(state[4], 6) ^ SHA256::rotr(state[4], 11) ^ SHA256::rotr(state[4], 25);
+// Vector forms of the message schedule: four consecutive words per 128-bit
+// lane, one block per lane for the 256-bit versions.
+template <int N>
+TARGET_SSSE3 inline __m128i rotr32(__m128i x) {
+	return _mm_or_si128(_mm_srli_epi32(x, N), _mm_slli_epi32(x, 32 - N));
+}
+
+TARGET_SSSE3 inline __m128i sigma0(__m128i x) {
+	return _mm_xor_si128(_mm_xor_si128(rotr32<7>(x), rotr32<18>(x)), _mm_srli_epi32(x, 3));
+}
 
-		sum  = m[i] + K[i] + state[7] + ch + xorE;
-		newA = xorA + maj + sum;
-		newE = state[3] + sum;
+TARGET_SSSE3 inline __m128i sigma1(__m128i x) {
+	return _mm_xor_si128(_mm_xor_si128(rotr32<17>(x), rotr32<19>(x)), _mm_srli_epi32(x, 10));
+}
 
-		state[7] = state[6];
-		state[6] = state[5];
-		state[5] = state[4];
-		state[4] = newE;
-		state[3] = state[2];
-		state[2] = state[1];
-		state[1] = state[0];
-		state[0] = newA;
+// W[t..t+3] from x0 = W[t-16..t-13] .. x3 = W[t-4..t-1]. sigma1 of W[t+2]
+// and W[t+3] needs W[t] and W[t+1], so the lower half is finished first.
+TARGET_SSSE3 inline __m128i schedule(__m128i x0, __m128i x1, __m128i x2, __m128i x3) {
+	const __m128i partial = _mm_add_epi32(_mm_add_epi32(x0, sigma0(_mm_alignr_epi8(x1, x0, 4))), _mm_alignr_epi8(x3, x2, 4));
+	const __m128i low = sigma1(_mm_shuffle_epi32(x3, _MM_SHUFFLE(3, 2, 3, 2)));
+	const __m128i high = sigma1(_mm_add_epi32(partial, low));
+	return _mm_add_epi32(partial, _mm_unpacklo_epi64(low, high));
+}
+
+template <int N>
+TARGET_AVX2 inline __m256i rotr32(__m256i x) {
+	return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+}
+
+TARGET_AVX2 inline __m256i sigma0(__m256i x) {
+	return _mm256_xor_si256(_mm256_xor_si256(rotr32<7>(x), rotr32<18>(x)), _mm256_srli_epi32(x, 3));
+}
+
+TARGET_AVX2 inline __m256i sigma1(__m256i x) {
+	return _mm256_xor_si256(_mm256_xor_si256(rotr32<17>(x), rotr32<19>(x)), _mm256_srli_epi32(x, 10));
+}
+
+TARGET_AVX2 inline __m256i schedule(__m256i x0, __m256i x1, __m256i x2, __m256i x3) {
+	const __m256i partial = _mm256_add_epi32(_mm256_add_epi32(x0, sigma0(_mm256_alignr_epi8(x1, x0, 4))), _mm256_alignr_epi8(x3, x2, 4));
+	const __m256i low = sigma1(_mm256_shuffle_epi32(x3, _MM_SHUFFLE(3, 2, 3, 2)));
+	const __m256i high = sigma1(_mm256_add_epi32(partial, low));
+	return _mm256_add_epi32(partial, _mm256_unpacklo_epi64(low, high));
+}
+
+}
+
+TARGET_SSSE3 void SHA256::compressSsse3(uint32_t hash[8], const uint8_t * data, size_t blocks) {
+	const __m128i byteSwap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	const __m128i * k = reinterpret_cast<const __m128i *>(K.data());
+	alignas(16) uint32_t wk[64];
+	__m128i * out = reinterpret_cast<__m128i *>(wk);
+
+	for (; blocks > 0; blocks--, data += 64) {
+		__m128i w[4];
+		for (int i = 0; i < 4; i++) {
+			w[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data) + i), byteSwap);
+			_mm_store_si128(out + i, _mm_add_epi32(w[i], _mm_loadu_si128(k + i)));
+		}
+		for (int i = 4; i < 16; i++) {
+			const __m128i next = schedule(w[0], w[1], w[2], w[3]);
+			w[0] = w[1];
+			w[1] = w[2];
+			w[2] = w[3];
+			w[3] = next;
+			_mm_store_si128(out + i, _mm_add_epi32(next, _mm_loadu_si128(k + i)));
+		}
+		rounds(hash, wk);
 	}
+}
+
+// Schedules two blocks at once, one per 128-bit lane; the rounds stay scalar.
+TARGET_AVX2 void SHA256::compressAvx2(uint32_t hash[8], const uint8_t * data, size_t blocks) {
+	const __m256i byteSwap = _mm256_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3,
+	                                         12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	const __m128i * k = reinterpret_cast<const __m128i *>(K.data());
+	alignas(32) uint32_t wk[2][64];
+	__m128i * first = reinterpret_cast<__m128i *>(wk[0]);
+	__m128i * second = reinterpret_cast<__m128i *>(wk[1]);
+
+	for (; blocks >= 2; blocks -= 2, data += 128) {
+		const __m128i * in = reinterpret_cast<const __m128i *>(data);
+		__m256i w[4];
+		for (int i = 0; i < 4; i++) {
+			const __m256i pair = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(in + i)), _mm_loadu_si128(in + 4 + i), 1);
+			w[i] = _mm256_shuffle_epi8(pair, byteSwap);
+			const __m256i sum = _mm256_add_epi32(w[i], _mm256_broadcastsi128_si256(_mm_loadu_si128(k + i)));
+			_mm_store_si128(first + i, _mm256_castsi256_si128(sum));
+			_mm_store_si128(second + i, _mm256_extracti128_si256(sum, 1));
+		}
+		for (int i = 4; i < 16; i++) {
+			const __m256i next = schedule(w[0], w[1], w[2], w[3]);
+			w[0] = w[1];
+			w[1] = w[2];
+			w[2] = w[3];
+			w[3] = next;
+			const __m256i sum = _mm256_add_epi32(next, _mm256_broadcastsi128_si256(_mm_loadu_si128(k + i)));
+			_mm_store_si128(first + i, _mm256_castsi256_si128(sum));
+			_mm_store_si128(second + i, _mm256_extracti128_si256(sum, 1));
+		}
+		rounds(hash, wk[0]);
+		rounds(hash, wk[1]);
+	}
+	if (blocks > 0) {
+		compressSsse3(hash, data, blocks);
+	}
+}
+
+// The state is kept as ABEF / CDGH, the layout sha256rnds2 works on. Each
+// group of four rounds also advances the message schedule with
+// sha256msg1 / sha256msg2, four words at a time.
+TARGET_SHA void SHA256::compressShaNi(uint32_t hash[8], const uint8_t * data, size_t blocks) {
+	const __m128i byteSwap = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	const __m128i * k = reinterpret_cast<const __m128i *>(K.data());
+
+	__m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hash)), 0xB1);     // CDAB
+	__m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(hash + 4)), 0x1B); // EFGH
+	__m128i state0 = _mm_alignr_epi8(tmp, state1, 8);    // ABEF
+	state1 = _mm_blend_epi16(state1, tmp, 0xF0);         // CDGH
+
+	for (; blocks > 0; blocks--, data += 64) {
+		const __m128i saved0 = state0;
+		const __m128i saved1 = state1;
+		__m128i msg[4];
+
+#if defined(__GNUC__)
+#pragma GCC unroll 16
+#endif
+		for (int g = 0; g < 16; g++) {
+			__m128i & current = msg[g & 3];
+			if (g < 4) {
+				current = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data) + g), byteSwap);
+			}
+			__m128i wk = _mm_add_epi32(current, _mm_loadu_si128(k + g));
+			state1 = _mm_sha256rnds2_epu32(state1, state0, wk);
+			if (g >= 3 && g < 15) {
+				__m128i & next = msg[(g + 1) & 3];
+				next = _mm_add_epi32(next, _mm_alignr_epi8(current, msg[(g + 3) & 3], 4));
+				next = _mm_sha256msg2_epu32(next, current);
+			}
+			wk = _mm_shuffle_epi32(wk, 0x0E);
+			state0 = _mm_sha256rnds2_epu32(state0, state1, wk);
+			if (g >= 1 && g < 13) {
+				__m128i & previous = msg[(g + 3) & 3];
+				previous = _mm_sha256msg1_epu32(previous, current);
+			}
+		}
+
+		state0 = _mm_add_epi32(state0, saved0);
+		state1 = _mm_add_epi32(state1, saved1);
+	}
+
+	tmp = _mm_shuffle_epi32(state0, 0x1B);               // FEBA
+	state1 = _mm_shuffle_epi32(state1, 0xB1);            // DCHG
+	state0 = _mm_blend_epi16(tmp, state1, 0xF0);         // DCBA
+	state1 = _mm_alignr_epi8(state1, tmp, 8);            // HGFE
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(hash), state0);
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(hash + 4), state1);
+}
+
+namespace {
+
+constexpr uint32_t InitialState[8] = {
+	0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+constexpr int Lanes = 8;
+
+template <int N>
+TARGET_AVX2 inline __m256i rotr8x(__m256i x) {
+	return _mm256_or_si256(_mm256_srli_epi32(x, N), _mm256_slli_epi32(x, 32 - N));
+}
+
+// One message in flight in a vector lane. Whole blocks are read from the
+// message itself; the last one or two padded blocks from `tail`.
+struct LaneMessage {
+	const uint8_t * data = nullptr;
+	size_t index = 0;
+	size_t fullBlocks = 0;
+	size_t blocks = 0;
+	size_t next = 0;
+	uint8_t tail[128];
+
+	void start(std::string_view message, size_t messageIndex) {
+		data = reinterpret_cast<const uint8_t *>(message.data());
+		index = messageIndex;
+		fullBlocks = message.size() / 64;
+		const size_t rest = message.size() % 64;
+		const size_t tailLength = rest < 56 ? 64 : 128;
+		blocks = fullBlocks + tailLength / 64;
+		next = 0;
+		memset(tail, 0, tailLength);
+		if (rest > 0) {
+			memcpy(tail, data + fullBlocks * 64, rest);
+		}
+		tail[rest] = 0x80;
+		const uint64_t bits = static_cast<uint64_t>(message.size()) * 8;
+		for (int i = 0; i < 8; i++) {
+			tail[tailLength - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+		}
+	}
+
+	const uint8_t * block() const {
+		return next < fullBlocks ? data + next * 64 : tail + (next - fullBlocks) * 64;
+	}
+};
+
+}
+
+// Eight messages per pass: word j of every lane's block sits in one vector,
+// so the schedule and the rounds run unchanged on all eight at once. A lane
+// whose message is done is refilled with the next one, so long and short
+// messages mix without waiting for each other.
+TARGET_AVX2 void SHA256::hashManyAvx2(std::span<const std::string_view> messages, std::array<uint8_t, 32> * digests) {
+	LaneMessage lanes[Lanes];
+	bool active[Lanes] = {};
+	alignas(32) uint32_t state[8][Lanes];
+	alignas(32) uint32_t words[16][Lanes];
+	__m256i w[64];
+	size_t pending = 0;
+
+	auto refill = [&](int lane) {
+		active[lane] = pending < messages.size();
+		if (!active[lane]) {
+			return;
+		}
+		lanes[lane].start(messages[pending], pending);
+		pending++;
+		for (int j = 0; j < 8; j++) {
+			state[j][lane] = InitialState[j];
+		}
+	};
+	for (int lane = 0; lane < Lanes; lane++) {
+		refill(lane);
+	}
+
+	int running = 0;
+	for (int lane = 0; lane < Lanes; lane++) {
+		running += active[lane];
+	}
+	while (running > 0) {
+		for (int lane = 0; lane < Lanes; lane++) {
+			if (!active[lane]) {
+				continue;
+			}
+			const uint8_t * block = lanes[lane].block();
+			for (int j = 0; j < 16; j++) {
+				words[j][lane] = (uint32_t(block[4 * j]) << 24) | (uint32_t(block[4 * j + 1]) << 16) | (uint32_t(block[4 * j + 2]) << 8) | block[4 * j + 3];
+			}
+		}
+		for (int j = 0; j < 16; j++) {
+			w[j] = _mm256_load_si256(reinterpret_cast<const __m256i *>(words[j]));
+		}
+		for (int t = 16; t < 64; t++) {
+			const __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr8x<7>(w[t - 15]), rotr8x<18>(w[t - 15])), _mm256_srli_epi32(w[t - 15], 3));
+			const __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr8x<17>(w[t - 2]), rotr8x<19>(w[t - 2])), _mm256_srli_epi32(w[t - 2], 10));
+			w[t] = _mm256_add_epi32(_mm256_add_epi32(s1, w[t - 7]), _mm256_add_epi32(s0, w[t - 16]));
+		}
+
+		__m256i v[8];
+		for (int j = 0; j < 8; j++) {
+			v[j] = _mm256_load_si256(reinterpret_cast<const __m256i *>(state[j]));
+		}
+		__m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+		for (int t = 0; t < 64; t++) {
+			const __m256i bigSigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr8x<6>(e), rotr8x<11>(e)), rotr8x<25>(e));
+			const __m256i ch = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+			const __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(_mm256_add_epi32(h, bigSigma1), _mm256_add_epi32(ch, w[t])),
+			                                    _mm256_set1_epi32(static_cast<int>(K[t])));
+			const __m256i bigSigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr8x<2>(a), rotr8x<13>(a)), rotr8x<22>(a));
+			const __m256i maj = _mm256_or_si256(_mm256_and_si256(a, _mm256_or_si256(b, c)), _mm256_and_si256(b, c));
+			h = g;
+			g = f;
+			f = e;
+			e = _mm256_add_epi32(d, t1);
+			d = c;
+			c = b;
+			b = a;
+			a = _mm256_add_epi32(t1, _mm256_add_epi32(bigSigma0, maj));
+		}
+		const __m256i out[8] = {a, b, c, d, e, f, g, h};
+		for (int j = 0; j < 8; j++) {
+			_mm256_store_si256(reinterpret_cast<__m256i *>(state[j]), _mm256_add_epi32(v[j], out[j]));
+		}
+
+		for (int lane = 0; lane < Lanes; lane++) {
+			if (!active[lane] || ++lanes[lane].next < lanes[lane].blocks) {
+				continue;
+			}
+			std::array<uint8_t, 32> & digest = digests[lanes[lane].index];
+			for (int j = 0; j < 8; j++) {
+				for (int i = 0; i < 4; i++) {
+					digest[4 * j + i] = static_cast<uint8_t>(state[j][lane] >> (24 - 8 * i));
+				}
+			}
+			refill(lane);
+			running -= !active[lane];
+		}
+	}
+}
+
+#endif
+
+std::vector<std::array<uint8_t, 32>> SHA256::hashMany(std::span<const std::string_view> messages) {
+	std::vector<std::array<uint8_t, 32>> digests(messages.size());
+#if CPU_X86
+	if (backend() == Backend::Avx2 && messages.size() > 1) {
+		hashManyAvx2(messages, digests.data());
+		return digests;
+	}
+#endif
+	for (size_t i = 0; i < messages.size(); i++) {
+		SHA256 sha;
+		sha.update(reinterpret_cast<const uint8_t *>(messages[i].data()), messages[i].size());
+		digests[i] = sha.digest();
+	}
+	return digests;
+}
+
+SHA256::Backend SHA256::backend() {
+	const CompressFn compress = s_compress.load(std::memory_order_relaxed);
+#if CPU_X86
+	if (compress == &SHA256::compressShaNi) return Backend::ShaNi;
+	if (compress == &SHA256::compressAvx2) return Backend::Avx2;
+	if (compress == &SHA256::compressSsse3) return Backend::Ssse3;
+#endif
+	return Backend::Portable;
+}
+
+bool SHA256::isSupported(Backend backend) {
+	switch (backend) {
+		case Backend::Portable: return true;
+#if CPU_X86
+		case Backend::Ssse3: return cpuFeatures().ssse3;
+		case Backend::Avx2: return cpuFeatures().avx2 && cpuFeatures().ssse3;
+		case Backend::ShaNi: return cpuFeatures().sha && cpuFeatures().ssse3;
+#endif
+		default: return false;
+	}
+}
+
+bool SHA256::setBackend(Backend backend) {
+	if (!isSupported(backend)) {
+		return false;
+	}
+	CompressFn compress = &SHA256::compressPortable;
+#if CPU_X86
+	if (backend == Backend::Ssse3) compress = &SHA256::compressSsse3;
+	if (backend == Backend::Avx2) compress = &SHA256::compressAvx2;
+	if (backend == Backend::ShaNi) compress = &SHA256::compressShaNi;
+#endif
+	s_compress.store(compress, std::memory_order_relaxed);
+	return true;
+}
 
-	for(uint8_t i = 0 ; i < 8 ; i++) {
-		m_state[i] += state[i];
+const char * SHA256::backendName(Backend backend) {
+	switch (backend) {
+		case Backend::Ssse3: return "ssse3";
+		case Backend::Avx2: return "avx2";
+		case Backend::ShaNi: return "sha-ni";
+		default: return "portable";
 	}
 }
 
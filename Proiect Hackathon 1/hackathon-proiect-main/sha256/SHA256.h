@@ -3,18 +3,43 @@
 
 #include <string>
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
 
 class SHA256 {
 
 public:
+	// Compression function used for every block. The fastest one the CPU
+	// supports is picked at startup; ShaNi uses the x86 SHA extensions, Avx2
+	// and Ssse3 compute the message schedule with vector instructions (Avx2
+	// for two blocks at once) and Portable is plain C++.
+	enum class Backend { Portable, Ssse3, Avx2, ShaNi };
+
 	SHA256();
+	// Whole 64-byte blocks are compressed straight from `data`; only a
+	// partial block at either end is copied into the internal buffer.
 	void update(const uint8_t * data, size_t length);
 	void update(const std::string &data);
 	std::array<uint8_t, 32> digest();
 
 	static std::string toString(const std::array<uint8_t, 32> & digest);
 
+	// Digests of many independent messages, identical to hashing each one
+	// with its own SHA256. With the Avx2 backend eight messages are hashed
+	// at once, one per 32-bit vector lane; otherwise they are hashed in turn.
+	static std::vector<std::array<uint8_t, 32>> hashMany(std::span<const std::string_view> messages);
+
+	static Backend backend();
+	static bool isSupported(Backend backend);
+	// Switches every SHA256 in the process to `backend`, for tests and
+	// benchmarks; returns false (and changes nothing) if the CPU lacks it.
+	static bool setBackend(Backend backend);
+	static const char * backendName(Backend backend);
+
 private:
 	uint8_t  m_data[64];
 	uint32_t m_blocklen;
@@ -44,6 +69,15 @@ private:
 	static uint32_t majority(uint32_t a, uint32_t b, uint32_t c);
 	static uint32_t sig0(uint32_t x);
 	static uint32_t sig1(uint32_t x);
+	using CompressFn = void (*)(uint32_t state[8], const uint8_t * data, size_t blocks);
+	static std::atomic<CompressFn> s_compress;
+
+	static void compressPortable(uint32_t state[8], const uint8_t * data, size_t blocks);
+	static void compressSsse3(uint32_t state[8], const uint8_t * data, size_t blocks);
+	static void compressAvx2(uint32_t state[8], const uint8_t * data, size_t blocks);
+	static void compressShaNi(uint32_t state[8], const uint8_t * data, size_t blocks);
+	static void rounds(uint32_t state[8], const uint32_t * wk);
+	static void hashManyAvx2(std::span<const std::string_view> messages, std::array<uint8_t, 32> * digests);
 	void transform();
 	void pad();
 	void revert(std::array<uint8_t, 32> & hash);
@@ -4,7 +4,9 @@
 #include <iomanip>
 #include <iostream>
 #include <ostream>
+#include "PasswordHash.h"
 #include "SHA256.h"
+#include "SessionStore.h"
 
 #include "DatabaseManager.h"
 
@@ -34,11 +36,16 @@ bool AccountDatabaseManager::openDB() {
         std::cerr << "Error opening database " << this->dbName << std::endl;
         return false;
     }
+    // Several connections may share the file (one per AuthService worker);
+    // wait out another writer's lock instead of failing with SQLITE_BUSY.
+    sqlite3_busy_timeout(db, 5000);
+    statements.attach(db);
     std::cout << "Opened database " << this->dbName << std::endl;
     return true;
 }
 
 bool AccountDatabaseManager::closeDB() const {
+    statements.clear();
     bool closeStatus = sqlite3_close(this->db);
     if (closeStatus != SQLITE_OK) {
         std::cerr << "Error closing database, rolling back " << this->dbName << std::endl;
@@ -59,7 +66,9 @@ bool AccountDatabaseManager::setupDB() const {
         "id INTEGER PRIMARY KEY AUTOINCREMENT, "
         "username TEXT NOT NULL,"
         "password TEXT NOT NULL,"
-        "email TEXT NOT NULL UNIQUE"
+        "email TEXT NOT NULL UNIQUE,"
+        "salt TEXT,"
+        "iterations INTEGER NOT NULL DEFAULT 0"
         ");";
     char* errMsg = nullptr;
     int execStatus = sqlite3_exec(this->db, sqlQuery, nullptr, nullptr, &errMsg);
@@ -68,23 +77,70 @@ bool AccountDatabaseManager::setupDB() const {
         sqlite3_free(errMsg);
         return false;
     }
+    // A sessions table that stored bearer tokens in plaintext is dropped, so
+    // they leave the disk; those sessions log in again.
+    {
+        Statement stmt = statements.acquire("SELECT 1 FROM pragma_table_info('sessions') WHERE name = 'token';");
+        if (!stmt) {
+            std::cerr << "Error preparing setupDB " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        if (sqlite3_step(stmt) == SQLITE_ROW
+            && sqlite3_exec(this->db, "DROP TABLE sessions;", nullptr, nullptr, &errMsg) != SQLITE_OK) {
+            std::cerr << "Error dropping plaintext sessions: " << errMsg << std::endl;
+            sqlite3_free(errMsg);
+            return false;
+        }
+    }
+    const char* sessionsQuery =
+        "CREATE TABLE IF NOT EXISTS sessions ("
+        "tokenHash TEXT PRIMARY KEY, "
+        "email TEXT NOT NULL,"
+        "expiresAt INTEGER NOT NULL"
+        ") WITHOUT ROWID;";
+    if (sqlite3_exec(this->db, sessionsQuery, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Error creating sessions table: " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    // Tables from before salted hashes get the columns added; their rows
+    // keep iterations = 0 until the next login rehashes them.
+    const char* columns[][2] = {{"salt", "TEXT"}, {"iterations", "INTEGER NOT NULL DEFAULT 0"}};
+    for (const auto& [column, type] : columns) {
+        Statement stmt = statements.acquire("SELECT 1 FROM pragma_table_info('accountData') WHERE name = ?;");
+        if (!stmt) {
+            std::cerr << "Error preparing setupDB " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        sqlite3_bind_text(stmt, 1, column, -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) != SQLITE_ROW) {
+            const std::string sql = std::string("ALTER TABLE accountData ADD COLUMN ") + column + " " + type + ";";
+            if (sqlite3_exec(db, sql.c_str(), nullptr, nullptr, &errMsg) != SQLITE_OK) {
+                std::cerr << "Error migrating accountData: " << errMsg << std::endl;
+                sqlite3_free(errMsg);
+                return false;
+            }
+        }
+    }
     std::cout << "Created database " << this->dbName << std::endl;
     return true;
 }
 
 bool AccountDatabaseManager::newAccount(const std::string& username, const std::string &password, const std::string& email) const {
-    const char* sqlQuery = "INSERT INTO accountData (username, password, email) VALUES (?, ?, ?);";
-    sqlite3_stmt *stmt = nullptr;
+    const char* sqlQuery = "INSERT INTO accountData (username, password, email, salt, iterations) VALUES (?, ?, ?, ?, ?);";
+    Statement stmt = statements.acquire(sqlQuery);
 
-    if (sqlite3_prepare(this->db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+    if (!stmt) {
         std::cerr << "Error preparing newAccount " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
+    const std::string salt = newPasswordSalt();
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, encryptPassword(password).c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, hashPassword(password, salt, passwordIterations).c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 3, email.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, salt.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 5, passwordIterations);
 
     int stepVal = sqlite3_step(stmt);
     bool success = stepVal == SQLITE_DONE;
@@ -95,10 +151,8 @@ bool AccountDatabaseManager::newAccount(const std::string& username, const std::
         else {
             std::cerr << "Error creating account " << sqlite3_errmsg(db) << std::endl;
         }
-        sqlite3_finalize(stmt);
         return false;
     }
-    sqlite3_finalize(stmt);
     std::cout << "Created account" << std::endl;
     return true;
 }
@@ -107,10 +161,9 @@ bool AccountDatabaseManager::deleteAccount(const std::string& email, const std::
     AccountData data = getAccountInfo(email);
     if (!checkPassword(email, password)) return false;
     const char* sqlQuery = "DELETE FROM accountData WHERE email = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
         std::cerr << "Error preparing deleteAccount " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
@@ -120,7 +173,6 @@ bool AccountDatabaseManager::deleteAccount(const std::string& email, const std::
     if (!success) {
         std::cerr << "Error deleting account " << sqlite3_errmsg(db) << std::endl;
     }
-    sqlite3_finalize(stmt);
 
     return success;
 }
@@ -128,18 +180,20 @@ bool AccountDatabaseManager::deleteAccount(const std::string& email, const std::
 bool AccountDatabaseManager::updateAccount(const std::string &username, const std::string &password, const std::string &email, const std::string &oldEmail, const std::string &oldPassword) const {
     AccountData data = getAccountInfo(oldEmail);
     if (!checkPassword(oldEmail, oldPassword)) return false;
-    const char* sqlQuery = "UPDATE accountData SET username = ?, password = ?, email = ? WHERE email = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+    const char* sqlQuery = "UPDATE accountData SET username = ?, password = ?, email = ?, salt = ?, iterations = ? WHERE email = ?;";
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
         std::cerr << "Error preparing updateAccount " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
+    const std::string salt = newPasswordSalt();
     sqlite3_bind_text(stmt, 1, username.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 2, encryptPassword(password).c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, hashPassword(password, salt, passwordIterations).c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 3, email.c_str(), -1, SQLITE_TRANSIENT);
-    sqlite3_bind_text(stmt, 4, oldEmail.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, salt.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 5, passwordIterations);
+    sqlite3_bind_text(stmt, 6, oldEmail.c_str(), -1, SQLITE_TRANSIENT);
 
 
     int stepVal = sqlite3_step(stmt);
@@ -151,10 +205,8 @@ bool AccountDatabaseManager::updateAccount(const std::string &username, const st
         else {
             std::cerr << "Error updating account " << sqlite3_errmsg(db) << std::endl;
         }
-        sqlite3_finalize(stmt);
         return false;
     }
-    sqlite3_finalize(stmt);
     std::cout << "Updated account " << std::endl;
     return true;
 }
@@ -163,11 +215,10 @@ bool AccountDatabaseManager::updateAccount(const std::string &username, const st
 AccountData AccountDatabaseManager::getAccountInfo(const std::string& email) const {
     AccountData accData;
     const char* sqlQuery =
-        "SELECT username, password FROM accountData WHERE email = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare(this->db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+        "SELECT username, password, salt, iterations FROM accountData WHERE email = ?;";
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
         std::cerr << "Error preparing getAccountInfo: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return accData;
     }
 
@@ -179,6 +230,10 @@ AccountData AccountDatabaseManager::getAccountInfo(const std::string& email) con
         accData.username = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0));
         accData.password = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
         accData.email = email;
+        if (sqlite3_column_type(stmt, 2) != SQLITE_NULL) {
+            accData.salt = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
+        }
+        accData.iterations = static_cast<std::uint32_t>(sqlite3_column_int64(stmt, 3));
     }
     else if (stepCheck == SQLITE_DONE) {
         std::cerr << "Account not found: " << email << std::endl;
@@ -186,7 +241,6 @@ AccountData AccountDatabaseManager::getAccountInfo(const std::string& email) con
     else {
         std::cerr << "Error getting account " << sqlite3_errmsg(db) << std::endl;
     }
-    sqlite3_finalize(stmt);
     return accData;
 }
 
@@ -202,10 +256,121 @@ std::string AccountDatabaseManager::encryptPassword(const std::string& password)
 
 bool AccountDatabaseManager::checkPassword(const std::string &email, const std::string &enteredPassword) const {
     AccountData accData = getAccountInfo(email);
-    std::string enteredHash = encryptPassword(enteredPassword);
-    if (enteredHash != accData.password) {
+    if (accData.password.empty()) {
+        return false;
+    }
+    const std::string enteredHash = accData.iterations == 0
+        ? encryptPassword(enteredPassword)
+        : hashPassword(enteredPassword, accData.salt, accData.iterations);
+    if (!equalHashes(enteredHash, accData.password)) {
+        return false;
+    }
+    if (accData.iterations < passwordIterations && !storePassword(email, enteredPassword)) {
+        std::cerr << "Error rehashing password for " << email << std::endl;
+    }
+    return true;
+}
+
+bool AccountDatabaseManager::storePassword(const std::string& email, const std::string& password) const {
+    const char* sqlQuery = "UPDATE accountData SET password = ?, salt = ?, iterations = ? WHERE email = ?;";
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing storePassword " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    const std::string salt = newPasswordSalt();
+    sqlite3_bind_text(stmt, 1, hashPassword(password, salt, passwordIterations).c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, salt.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 3, passwordIterations);
+    sqlite3_bind_text(stmt, 4, email.c_str(), -1, SQLITE_TRANSIENT);
+
+    bool success = sqlite3_step(stmt) == SQLITE_DONE;
+    if (!success) {
+        std::cerr << "Error storing password " << sqlite3_errmsg(db) << std::endl;
+    }
+    return success;
+}
+
+void AccountDatabaseManager::setPasswordIterations(const std::uint32_t iterations) {
+    passwordIterations = iterations > 0 ? iterations : 1;
+}
+
+bool AccountDatabaseManager::deleteAccount(const std::string& email, const std::string& password, SessionStore& sessions) const {
+    if (!deleteAccount(email, password)) {
+        return false;
+    }
+    sessions.revokeAll(email);
+    return true;
+}
+
+bool AccountDatabaseManager::updateAccount(const std::string& username, const std::string& password, const std::string& email,
+                                           const std::string& oldEmail, const std::string& oldPassword, SessionStore& sessions) const {
+    if (!updateAccount(username, password, email, oldEmail, oldPassword)) {
         return false;
     }
+    sessions.revokeAll(oldEmail);
     return true;
 }
 
+std::string AccountDatabaseManager::login(const std::string& email, const std::string& password, SessionStore& sessions) const {
+    if (!checkPassword(email, password)) {
+        return "";
+    }
+    return sessions.issue(email);
+}
+
+bool AccountDatabaseManager::saveSessions(std::span<const SessionRecord> sessions) const {
+    if (sqlite3_exec(db, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Error starting saveSessions " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    if (sqlite3_exec(db, "DELETE FROM sessions;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+        std::cerr << "Error clearing sessions " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    Statement stmt = statements.acquire("INSERT INTO sessions (tokenHash, email, expiresAt) VALUES (?, ?, ?);");
+    if (!stmt) {
+        std::cerr << "Error preparing saveSessions " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+        return false;
+    }
+    for (const SessionRecord& session : sessions) {
+        sqlite3_bind_text(stmt, 1, session.tokenHash.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, 2, session.email.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 3, session.expiresAt);
+        int stepVal = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (stepVal != SQLITE_DONE) {
+            std::cerr << "Error saving session " << sqlite3_errmsg(db) << std::endl;
+            sqlite3_exec(db, "ROLLBACK;", nullptr, nullptr, nullptr);
+            return false;
+        }
+    }
+    return sqlite3_exec(db, "COMMIT;", nullptr, nullptr, nullptr) == SQLITE_OK;
+}
+
+std::vector<SessionRecord> AccountDatabaseManager::getSessions(const std::int64_t notExpiredAt) const {
+    std::vector<SessionRecord> sessions;
+    Statement stmt = statements.acquire("SELECT tokenHash, email, expiresAt FROM sessions WHERE expiresAt > ?;");
+    if (!stmt) {
+        std::cerr << "Error preparing getSessions " << sqlite3_errmsg(db) << std::endl;
+        return sessions;
+    }
+    sqlite3_bind_int64(stmt, 1, notExpiredAt);
+    int stepVal;
+    while ((stepVal = sqlite3_step(stmt)) == SQLITE_ROW) {
+        sessions.push_back({reinterpret_cast<const char*>(sqlite3_column_text(stmt, 0)),
+                            reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1)),
+                            sqlite3_column_int64(stmt, 2)});
+    }
+    if (stepVal != SQLITE_DONE) {
+        std::cerr << "Error getting sessions " << sqlite3_errmsg(db) << std::endl;
+    }
+    return sessions;
+}
+
+StatementCacheStats AccountDatabaseManager::statementCacheStats() const {
+    return statements.stats();
+}
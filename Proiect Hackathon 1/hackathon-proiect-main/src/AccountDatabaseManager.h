@@ -1,16 +1,37 @@
 #pragma once
 #include "sqlite3.h"
+#include "StatementCache.h"
 #include "string"
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class SessionStore;
+
+// Iterations of PBKDF2-HMAC-SHA256 for new and rehashed passwords.
+constexpr std::uint32_t DefaultPasswordIterations = 100000;
 
 struct AccountData {
     std::string username;
     std::string password;
     std::string email;
+    std::string salt;
+    std::uint32_t iterations = 0;  // 0 for a legacy unsalted SHA-256 hash
+};
+
+struct SessionRecord {
+    std::string tokenHash;  // hex of the first 128 bits of SHA-256(token); never the token itself
+    std::string email;
+    std::int64_t expiresAt;  // unix seconds
 };
 
 class AccountDatabaseManager {
     sqlite3 *db;
     std::string dbName;
+    mutable StatementCache statements;
+    std::uint32_t passwordIterations = DefaultPasswordIterations;
+
+    bool storePassword(const std::string& email, const std::string& password) const;
 public:
     explicit AccountDatabaseManager(const std::string &dbName);
     ~AccountDatabaseManager();
@@ -20,10 +41,27 @@ public:
     bool setupDB() const;
 
     bool newAccount(const std::string& username, const std::string &password, const std::string& email) const;
+    // These leave the account's session tokens valid; once sessions are
+    // issued, use the overloads below (AuthService does).
     bool deleteAccount(const std::string& email, const std::string &password) const;
     bool updateAccount(const std::string &username, const std::string &password, const std::string &email, const std::string &oldEmail, const std::string &oldPassword) const;
+    // As above, then revoke every session of the account in `sessions`.
+    bool deleteAccount(const std::string& email, const std::string &password, SessionStore& sessions) const;
+    bool updateAccount(const std::string &username, const std::string &password, const std::string &email, const std::string &oldEmail, const std::string &oldPassword, SessionStore& sessions) const;
     AccountData getAccountInfo(const std::string& email) const;
 
+    // Legacy unsalted hash, still accepted by checkPassword for old accounts.
     static std::string encryptPassword(const std::string &password);
+    // A successful check also rehashes a legacy or cheaper hash with the
+    // current salt-and-iterations scheme.
     bool checkPassword(const std::string &email, const std::string &enteredPassword) const;
+    void setPasswordIterations(std::uint32_t iterations);
+    // checkPassword, then a session token from `sessions`; empty on failure.
+    std::string login(const std::string& email, const std::string& password, SessionStore& sessions) const;
+
+    // Replaces the stored sessions with `sessions`, in one transaction.
+    bool saveSessions(std::span<const SessionRecord> sessions) const;
+    std::vector<SessionRecord> getSessions(std::int64_t notExpiredAt) const;
+
+    StatementCacheStats statementCacheStats() const;
 };
\ No newline at end of file
@@ -0,0 +1,259 @@
+#pragma once
+#include "AnomalyDetector.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <cmath>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+enum : std::uint8_t {
+    FlagSpike = 1,
+    FlagDriftUp = 2,
+    FlagDriftDown = 4
+};
+
+// Variance floor so a flat channel does not divide by zero.
+constexpr double MinVariance = 1e-12;
+
+struct KernelParams {
+    double alpha;
+    double zThreshold;
+    double cusumSlack;
+    double cusumThreshold;
+};
+
+// Scores each lane against its baseline, advances the CUSUMs and then folds
+// the sample into the EWMA mean/variance.
+void updateScalar(const KernelParams& p, const std::size_t n, const double* value, double* mean, double* variance,
+                  double* high, double* low, double* zScore, std::uint8_t* flags) {
+    for (std::size_t i = 0; i < n; i++) {
+        const double diff = value[i] - mean[i];
+        const double z = diff / std::sqrt(std::max(variance[i], MinVariance));
+        high[i] = std::max(0.0, high[i] + z - p.cusumSlack);
+        low[i] = std::max(0.0, low[i] - z - p.cusumSlack);
+        const double increment = p.alpha * diff;
+        mean[i] += increment;
+        variance[i] = (1.0 - p.alpha) * (variance[i] + diff * increment);
+        zScore[i] = z;
+        flags[i] = (std::abs(z) > p.zThreshold ? FlagSpike : 0)
+                 | (high[i] > p.cusumThreshold ? FlagDriftUp : 0)
+                 | (low[i] > p.cusumThreshold ? FlagDriftDown : 0);
+    }
+}
+
+#if CPU_X86
+TARGET_AVX2 void updateAvx2(const KernelParams& p, const std::size_t n, const double* value, double* mean, double* variance,
+                            double* high, double* low, double* zScore, std::uint8_t* flags) {
+    const __m256d alpha = _mm256_set1_pd(p.alpha);
+    const __m256d keep = _mm256_set1_pd(1.0 - p.alpha);
+    const __m256d zThreshold = _mm256_set1_pd(p.zThreshold);
+    const __m256d slack = _mm256_set1_pd(p.cusumSlack);
+    const __m256d cusumThreshold = _mm256_set1_pd(p.cusumThreshold);
+    const __m256d minVariance = _mm256_set1_pd(MinVariance);
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d absMask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffffLL));
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const __m256d x = _mm256_loadu_pd(value + i);
+        const __m256d m = _mm256_loadu_pd(mean + i);
+        const __m256d v = _mm256_loadu_pd(variance + i);
+        const __m256d diff = _mm256_sub_pd(x, m);
+        const __m256d z = _mm256_div_pd(diff, _mm256_sqrt_pd(_mm256_max_pd(v, minVariance)));
+        const __m256d h = _mm256_max_pd(zero, _mm256_sub_pd(_mm256_add_pd(_mm256_loadu_pd(high + i), z), slack));
+        const __m256d l = _mm256_max_pd(zero, _mm256_sub_pd(_mm256_sub_pd(_mm256_loadu_pd(low + i), z), slack));
+        const __m256d increment = _mm256_mul_pd(alpha, diff);
+        _mm256_storeu_pd(mean + i, _mm256_add_pd(m, increment));
+        _mm256_storeu_pd(variance + i, _mm256_mul_pd(keep, _mm256_add_pd(v, _mm256_mul_pd(diff, increment))));
+        _mm256_storeu_pd(high + i, h);
+        _mm256_storeu_pd(low + i, l);
+        _mm256_storeu_pd(zScore + i, z);
+
+        const int spike = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_and_pd(z, absMask), zThreshold, _CMP_GT_OQ));
+        const int up = _mm256_movemask_pd(_mm256_cmp_pd(h, cusumThreshold, _CMP_GT_OQ));
+        const int down = _mm256_movemask_pd(_mm256_cmp_pd(l, cusumThreshold, _CMP_GT_OQ));
+        for (int j = 0; j < 4; j++) {
+            flags[i + j] = static_cast<std::uint8_t>(((spike >> j) & 1) | (((up >> j) & 1) << 1) | (((down >> j) & 1) << 2));
+        }
+    }
+    updateScalar(p, n - i, value + i, mean + i, variance + i, high + i, low + i, zScore + i, flags + i);
+}
+#endif
+
+using UpdateFn = void (*)(const KernelParams&, std::size_t, const double*, double*, double*, double*, double*, double*, std::uint8_t*);
+
+UpdateFn selectUpdate() {
+#if CPU_X86
+    if (cpuFeatures().avx2) return updateAvx2;
+#endif
+    return updateScalar;
+}
+
+const UpdateFn update = selectUpdate();
+
+constexpr double Reading::*Channels[ReadingChannelCount] = {
+    &Reading::carbonDioxide, &Reading::methane, &Reading::ammonia, &Reading::inductivity, &Reading::reflectance
+};
+
+}
+
+AnomalyDetector::AnomalyDetector(const AnomalyDetectorConfig config) : config(config) {
+}
+
+void AnomalyDetector::setAlertHandler(std::function<void(std::span<const AnomalyAlert>)> handler) {
+    std::unique_lock lock(mutex);
+    alertHandler = std::move(handler);
+}
+
+std::uint32_t AnomalyDetector::deviceIdLocked(const std::string& user) {
+    auto [it, inserted] = deviceIds.try_emplace(user, static_cast<std::uint32_t>(deviceNames.size()));
+    if (inserted) {
+        deviceNames.push_back(user);
+        sampleCount.push_back(0);
+        roundMark.push_back(0);
+        for (ChannelState& channel : channels) {
+            channel.mean.push_back(0.0);
+            channel.variance.push_back(0.0);
+            channel.cusumHigh.push_back(0.0);
+            channel.cusumLow.push_back(0.0);
+        }
+    }
+    return it->second;
+}
+
+std::uint32_t AnomalyDetector::deviceId(const std::string& user) {
+    std::unique_lock lock(mutex);
+    return deviceIdLocked(user);
+}
+
+void AnomalyDetector::evaluateRound(std::span<const std::uint32_t> devices, std::span<const Reading> readings, std::span<const std::size_t> round) {
+    const std::size_t n = round.size();
+    lanes.value.resize(n);
+    lanes.mean.resize(n);
+    lanes.variance.resize(n);
+    lanes.cusumHigh.resize(n);
+    lanes.cusumLow.resize(n);
+    lanes.zScore.resize(n);
+    lanes.flags.resize(n);
+    const KernelParams params{config.alpha, config.zThreshold, config.cusumSlack, config.cusumThreshold};
+
+    for (std::size_t c = 0; c < ReadingChannelCount; c++) {
+        ChannelState& state = channels[c];
+        for (std::size_t j = 0; j < n; j++) {
+            const std::uint32_t d = devices[round[j]];
+            const double value = readings[round[j]].*Channels[c];
+            lanes.value[j] = value;
+            // A device's first sample seeds its mean.
+            lanes.mean[j] = sampleCount[d] == 0 ? value : state.mean[d];
+            lanes.variance[j] = state.variance[d];
+            lanes.cusumHigh[j] = state.cusumHigh[d];
+            lanes.cusumLow[j] = state.cusumLow[d];
+        }
+        update(params, n, lanes.value.data(), lanes.mean.data(), lanes.variance.data(), lanes.cusumHigh.data(),
+               lanes.cusumLow.data(), lanes.zScore.data(), lanes.flags.data());
+        for (std::size_t j = 0; j < n; j++) {
+            const std::uint32_t d = devices[round[j]];
+            std::uint8_t flags = lanes.flags[j];
+            if (sampleCount[d] < config.warmup) {
+                flags = 0;
+                lanes.cusumHigh[j] = 0.0;
+                lanes.cusumLow[j] = 0.0;
+            }
+            if (flags != 0) {
+                const Reading& r = readings[round[j]];
+                const auto channel = static_cast<ReadingChannel>(c);
+                if (flags & FlagSpike) {
+                    alerts.push_back({deviceNames[d], r.timestamp, channel, AnomalyKind::Spike, lanes.value[j], lanes.zScore[j]});
+                }
+                if (flags & FlagDriftUp) {
+                    alerts.push_back({deviceNames[d], r.timestamp, channel, AnomalyKind::DriftUp, lanes.value[j], lanes.zScore[j]});
+                    lanes.cusumHigh[j] = 0.0;
+                }
+                if (flags & FlagDriftDown) {
+                    alerts.push_back({deviceNames[d], r.timestamp, channel, AnomalyKind::DriftDown, lanes.value[j], lanes.zScore[j]});
+                    lanes.cusumLow[j] = 0.0;
+                }
+            }
+            state.mean[d] = lanes.mean[j];
+            state.variance[d] = lanes.variance[j];
+            state.cusumHigh[d] = lanes.cusumHigh[j];
+            state.cusumLow[d] = lanes.cusumLow[j];
+        }
+    }
+    for (const std::size_t index : round) {
+        sampleCount[devices[index]]++;
+    }
+    samples += n;
+}
+
+void AnomalyDetector::observe(std::span<const std::uint32_t> devices, std::span<const Reading> readings) {
+    std::vector<AnomalyAlert> raised;
+    std::function<void(std::span<const AnomalyAlert>)> handler;
+    {
+        std::unique_lock lock(mutex);
+        // A device can only occupy one lane per kernel call, so repeated
+        // samples of the same device are split into successive rounds.
+        std::vector<std::size_t> pending(readings.size());
+        for (std::size_t i = 0; i < pending.size(); i++) {
+            pending[i] = i;
+        }
+        std::vector<std::size_t> round;
+        std::vector<std::size_t> deferred;
+        while (!pending.empty()) {
+            roundEpoch++;
+            round.clear();
+            deferred.clear();
+            for (const std::size_t i : pending) {
+                if (roundMark[devices[i]] == roundEpoch) {
+                    deferred.push_back(i);
+                }
+                else {
+                    roundMark[devices[i]] = roundEpoch;
+                    round.push_back(i);
+                }
+            }
+            evaluateRound(devices, readings, round);
+            pending.swap(deferred);
+        }
+        alertCount += alerts.size();
+        raised.swap(alerts);
+        handler = alertHandler;
+    }
+    if (!raised.empty() && handler) {
+        handler(raised);
+    }
+}
+
+void AnomalyDetector::onReadings(std::span<const ReadingInput> readings, std::span<const std::int64_t> timestamps) {
+    std::vector<std::uint32_t> devices(readings.size());
+    std::vector<Reading> values(readings.size());
+    {
+        std::unique_lock lock(mutex);
+        for (std::size_t i = 0; i < readings.size(); i++) {
+            const ReadingInput& r = readings[i];
+            devices[i] = deviceIdLocked(r.user);
+            values[i] = {timestamps[i], r.carbonDioxide, r.methane, r.ammonia, r.inductivity, r.reflectance};
+        }
+    }
+    observe(devices, values);
+}
+
+bool AnomalyDetector::baseline(const std::string& user, const ReadingChannel channel, double& mean, double& variance) const {
+    std::unique_lock lock(mutex);
+    auto found = deviceIds.find(user);
+    if (found == deviceIds.end()) {
+        return false;
+    }
+    const ChannelState& state = channels[static_cast<std::size_t>(channel)];
+    mean = state.mean[found->second];
+    variance = state.variance[found->second];
+    return true;
+}
+
+AnomalyDetectorStats AnomalyDetector::stats() const {
+    std::unique_lock lock(mutex);
+    return {deviceNames.size(), samples, alertCount};
+}
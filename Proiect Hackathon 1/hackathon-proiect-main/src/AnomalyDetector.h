@@ -0,0 +1,100 @@
+#pragma once
+#include "DatabaseManager.h"
+#include "ReadingColumnStore.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class AnomalyKind {
+    Spike,     // |z-score| above zThreshold
+    DriftUp,   // upper CUSUM above cusumThreshold
+    DriftDown  // lower CUSUM above cusumThreshold
+};
+
+struct AnomalyAlert {
+    std::string user;
+    std::int64_t timestamp;
+    ReadingChannel channel;
+    AnomalyKind kind;
+    double value;
+    double zScore;
+};
+
+struct AnomalyDetectorConfig {
+    double alpha = 0.05;          // EWMA weight of the newest sample
+    double zThreshold = 4.0;
+    double cusumSlack = 0.5;      // in standard deviations
+    double cusumThreshold = 8.0;  // in standard deviations
+    std::uint32_t warmup = 30;    // samples per device before alerts are raised
+};
+
+struct AnomalyDetectorStats {
+    std::size_t devices;
+    std::uint64_t samples;
+    std::uint64_t alerts;
+};
+
+// Online per-device anomaly detector for the five sensor channels. Each device
+// keeps an EWMA mean/variance and a two-sided CUSUM per channel, so a sample
+// costs O(1) regardless of history. State is stored column-wise per channel;
+// a batch is gathered into contiguous lanes (one per device) and evaluated with
+// AVX2 when the CPU has it.
+//
+// Attach it with DatabaseManager::addObserver to check every committed reading.
+class AnomalyDetector : public ReadingObserver {
+    struct ChannelState {
+        std::vector<double> mean;
+        std::vector<double> variance;
+        std::vector<double> cusumHigh;
+        std::vector<double> cusumLow;
+    };
+
+    struct Lanes {
+        std::vector<double> value;
+        std::vector<double> mean;
+        std::vector<double> variance;
+        std::vector<double> cusumHigh;
+        std::vector<double> cusumLow;
+        std::vector<double> zScore;
+        std::vector<std::uint8_t> flags;
+    };
+
+    AnomalyDetectorConfig config;
+    std::function<void(std::span<const AnomalyAlert>)> alertHandler;
+
+    mutable std::mutex mutex;
+    std::unordered_map<std::string, std::uint32_t> deviceIds;
+    std::vector<std::string> deviceNames;
+    std::vector<std::uint32_t> sampleCount;
+    std::vector<std::uint64_t> roundMark;
+    std::uint64_t roundEpoch = 0;
+    std::array<ChannelState, ReadingChannelCount> channels;
+
+    Lanes lanes;
+    std::vector<AnomalyAlert> alerts;
+    std::uint64_t samples = 0;
+    std::uint64_t alertCount = 0;
+
+    std::uint32_t deviceIdLocked(const std::string& user);
+    void evaluateRound(std::span<const std::uint32_t> devices, std::span<const Reading> readings, std::span<const std::size_t> round);
+public:
+    explicit AnomalyDetector(AnomalyDetectorConfig config = {});
+
+    // Called with the alerts raised by each batch, on the thread that observed it.
+    void setAlertHandler(std::function<void(std::span<const AnomalyAlert>)> handler);
+
+    // Dense id for `user`, for callers that feed observe() directly.
+    std::uint32_t deviceId(const std::string& user);
+    void observe(std::span<const std::uint32_t> devices, std::span<const Reading> readings);
+    void onReadings(std::span<const ReadingInput> readings, std::span<const std::int64_t> timestamps) override;
+
+    // Current EWMA mean and variance of one device channel.
+    bool baseline(const std::string& user, ReadingChannel channel, double& mean, double& variance) const;
+    AnomalyDetectorStats stats() const;
+};
@@ -0,0 +1,169 @@
+#pragma once
+#include "AuthService.h"
+#include <memory>
+#include <utility>
+
+AuthService::AuthService(const std::string& dbName, const AuthServiceConfig config)
+    : dbName(dbName), config(config) {
+    this->config.workers = std::max<std::size_t>(config.workers, 1);
+    this->config.queueCapacity = std::max<std::size_t>(config.queueCapacity, 1);
+    // The first connection creates or migrates the table before the workers
+    // open theirs, so they never race on setupDB().
+    AccountDatabaseManager setup(dbName);
+    for (std::size_t i = 0; i < this->config.workers; i++) {
+        workers.emplace_back([this] { workerLoop(); });
+    }
+}
+
+AuthService::~AuthService() {
+    stop();
+}
+
+void AuthService::submit(std::function<bool(AccountDatabaseManager&)> work, Callback done) {
+    AuthStatus refused;
+    {
+        std::lock_guard lock(mutex);
+        if (stopping) {
+            refused = AuthStatus::Stopped;
+        }
+        else if (queue.size() >= config.queueCapacity) {
+            overloaded++;
+            refused = AuthStatus::Overloaded;
+        }
+        else {
+            queue.push_back({std::move(work), std::move(done), Clock::now()});
+            submitted++;
+            maxDepth = std::max(maxDepth, queue.size());
+            available.notify_one();
+            return;
+        }
+    }
+    if (done) done(refused);
+}
+
+std::future<AuthStatus> AuthService::submit(std::function<bool(AccountDatabaseManager&)> work) {
+    auto promise = std::make_shared<std::promise<AuthStatus>>();
+    std::future<AuthStatus> result = promise->get_future();
+    submit(std::move(work), [promise](const AuthStatus status) { promise->set_value(status); });
+    return result;
+}
+
+void AuthService::workerLoop() {
+    AccountDatabaseManager accounts(dbName);
+    accounts.setPasswordIterations(config.iterations);
+    std::unique_lock lock(mutex);
+    while (true) {
+        available.wait(lock, [this] { return stopping || !queue.empty(); });
+        if (queue.empty()) return;
+        Job job = std::move(queue.front());
+        queue.pop_front();
+        lock.unlock();
+
+        const auto started = Clock::now();
+        queueWait.record(started - job.submitted);
+        const bool ok = job.work(accounts);
+        hashTime.record(Clock::now() - started);
+        if (job.done) job.done(ok ? AuthStatus::Ok : AuthStatus::Failed);
+
+        lock.lock();
+        completed++;
+        if (!ok) failed++;
+    }
+}
+
+void AuthService::setSessionStore(SessionStore* sessions) {
+    this->sessions.store(sessions);
+}
+
+std::future<AuthLogin> AuthService::login(std::string email, std::string password) {
+    auto promise = std::make_shared<std::promise<AuthLogin>>();
+    auto token = std::make_shared<std::string>();
+    std::future<AuthLogin> result = promise->get_future();
+    submit([this, token, email = std::move(email), password = std::move(password)](AccountDatabaseManager& accounts) {
+        SessionStore* store = sessions.load();
+        if (store == nullptr) return false;
+        *token = accounts.login(email, password, *store);
+        return !token->empty();
+    }, [promise, token](const AuthStatus status) { promise->set_value({status, std::move(*token)}); });
+    return result;
+}
+
+std::future<AuthStatus> AuthService::checkPassword(std::string email, std::string password) {
+    return submit([email = std::move(email), password = std::move(password)](AccountDatabaseManager& accounts) {
+        return accounts.checkPassword(email, password);
+    });
+}
+
+std::future<AuthStatus> AuthService::newAccount(std::string username, std::string password, std::string email) {
+    return submit([username = std::move(username), password = std::move(password),
+                   email = std::move(email)](AccountDatabaseManager& accounts) {
+        return accounts.newAccount(username, password, email);
+    });
+}
+
+std::future<AuthStatus> AuthService::updateAccount(std::string username, std::string password, std::string email,
+                                                   std::string oldEmail, std::string oldPassword) {
+    return submit([username = std::move(username), password = std::move(password), email = std::move(email),
+                   this, oldEmail = std::move(oldEmail), oldPassword = std::move(oldPassword)](AccountDatabaseManager& accounts) {
+        SessionStore* store = sessions.load();
+        return store != nullptr ? accounts.updateAccount(username, password, email, oldEmail, oldPassword, *store)
+                                : accounts.updateAccount(username, password, email, oldEmail, oldPassword);
+    });
+}
+
+std::future<AuthStatus> AuthService::deleteAccount(std::string email, std::string password) {
+    return submit([this, email = std::move(email), password = std::move(password)](AccountDatabaseManager& accounts) {
+        SessionStore* store = sessions.load();
+        return store != nullptr ? accounts.deleteAccount(email, password, *store) : accounts.deleteAccount(email, password);
+    });
+}
+
+void AuthService::checkPassword(std::string email, std::string password, Callback done) {
+    submit([email = std::move(email), password = std::move(password)](AccountDatabaseManager& accounts) {
+        return accounts.checkPassword(email, password);
+    }, std::move(done));
+}
+
+void AuthService::newAccount(std::string username, std::string password, std::string email, Callback done) {
+    submit([username = std::move(username), password = std::move(password),
+            email = std::move(email)](AccountDatabaseManager& accounts) {
+        return accounts.newAccount(username, password, email);
+    }, std::move(done));
+}
+
+void AuthService::updateAccount(std::string username, std::string password, std::string email,
+                                std::string oldEmail, std::string oldPassword, Callback done) {
+    submit([username = std::move(username), password = std::move(password), email = std::move(email),
+            this, oldEmail = std::move(oldEmail), oldPassword = std::move(oldPassword)](AccountDatabaseManager& accounts) {
+        SessionStore* store = sessions.load();
+        return store != nullptr ? accounts.updateAccount(username, password, email, oldEmail, oldPassword, *store)
+                                : accounts.updateAccount(username, password, email, oldEmail, oldPassword);
+    }, std::move(done));
+}
+
+void AuthService::deleteAccount(std::string email, std::string password, Callback done) {
+    submit([this, email = std::move(email), password = std::move(password)](AccountDatabaseManager& accounts) {
+        SessionStore* store = sessions.load();
+        return store != nullptr ? accounts.deleteAccount(email, password, *store) : accounts.deleteAccount(email, password);
+    }, std::move(done));
+}
+
+void AuthService::stop() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    available.notify_all();
+    workers.clear();
+}
+
+AuthServiceStats AuthService::stats() const {
+    std::lock_guard lock(mutex);
+    return {config.workers, queue.size(), maxDepth, submitted, completed, failed, overloaded,
+            queueWait.summary(), hashTime.summary()};
+}
+
+void AuthService::resetLatencies() {
+    queueWait.clear();
+    hashTime.clear();
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include "AccountDatabaseManager.h"
+#include "LatencyHistogram.h"
+#include "SessionStore.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+enum class AuthStatus {
+    Ok,
+    Failed,      // the account call returned false: wrong password, unknown or duplicate email
+    Overloaded,  // the queue was full; nothing was hashed
+    Stopped      // submitted after stop()
+};
+
+struct AuthServiceConfig {
+    // Hashing threads, and so the most cores a login storm can take from
+    // sensor ingest and the monitor workers.
+    std::size_t workers = std::max(1u, std::thread::hardware_concurrency() / 4);
+    std::size_t queueCapacity = 256;  // pending requests before new ones are turned away
+    std::uint32_t iterations = DefaultPasswordIterations;
+};
+
+struct AuthLogin {
+    AuthStatus status;
+    std::string token;  // set when status is Ok
+};
+
+struct AuthServiceStats {
+    std::size_t workers;
+    std::size_t depth;
+    std::size_t maxDepth;
+    std::uint64_t submitted;
+    std::uint64_t completed;
+    std::uint64_t failed;
+    std::uint64_t overloaded;
+    LatencySummary queueWait;  // submit -> a worker picks the request up
+    LatencySummary hashTime;   // the account call itself, dominated by PBKDF2
+};
+
+// Runs AccountDatabaseManager's password-checking calls on a small pool of
+// hashing threads, each with its own connection to the accounts database, so
+// request threads never spend the ~25 ms of a PBKDF2 hash themselves. Every
+// call returns at once with a future, or takes a callback that a worker
+// invokes with the result. When queueCapacity requests are already waiting
+// the request completes immediately with Overloaded instead of queueing
+// behind a storm it cannot get through in time.
+//
+// With a SessionStore set, login() hands back a session token so later
+// requests are checked with SessionStore::validate instead of a hash, and a
+// successful updateAccount or deleteAccount revokes the account's sessions.
+class AuthService {
+public:
+    using Callback = std::function<void(AuthStatus)>;
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Job {
+        std::function<bool(AccountDatabaseManager&)> work;
+        Callback done;
+        Clock::time_point submitted;
+    };
+
+    std::string dbName;
+    AuthServiceConfig config;
+
+    mutable std::mutex mutex;
+    std::condition_variable available;
+    std::deque<Job> queue;
+    bool stopping = false;
+    std::size_t maxDepth = 0;
+    std::uint64_t submitted = 0;
+    std::uint64_t completed = 0;
+    std::uint64_t failed = 0;
+    std::uint64_t overloaded = 0;
+
+    LatencyHistogram queueWait;
+    LatencyHistogram hashTime;
+    std::atomic<SessionStore*> sessions{nullptr};
+
+    std::vector<std::jthread> workers;
+
+    void submit(std::function<bool(AccountDatabaseManager&)> work, Callback done);
+    std::future<AuthStatus> submit(std::function<bool(AccountDatabaseManager&)> work);
+    void workerLoop();
+public:
+    explicit AuthService(const std::string& dbName, AuthServiceConfig config = {});
+    ~AuthService();
+
+    AuthService(const AuthService&) = delete;
+    AuthService& operator=(const AuthService&) = delete;
+
+    // Not owned; must outlive the service or be unset first.
+    void setSessionStore(SessionStore* sessions);
+
+    // checkPassword, then a token from the session store; Failed without one.
+    std::future<AuthLogin> login(std::string email, std::string password);
+    std::future<AuthStatus> checkPassword(std::string email, std::string password);
+    std::future<AuthStatus> newAccount(std::string username, std::string password, std::string email);
+    std::future<AuthStatus> updateAccount(std::string username, std::string password, std::string email,
+                                          std::string oldEmail, std::string oldPassword);
+    std::future<AuthStatus> deleteAccount(std::string email, std::string password);
+
+    // The callback runs on a worker thread, or on the caller's when the
+    // request is turned away, and must not block.
+    void checkPassword(std::string email, std::string password, Callback done);
+    void newAccount(std::string username, std::string password, std::string email, Callback done);
+    void updateAccount(std::string username, std::string password, std::string email,
+                       std::string oldEmail, std::string oldPassword, Callback done);
+    void deleteAccount(std::string email, std::string password, Callback done);
+
+    // Turns new requests away, finishes the queued ones and joins the workers.
+    void stop();
+
+    AuthServiceStats stats() const;
+    void resetLatencies();
+};
@@ -0,0 +1,65 @@
+#pragma once
+#include "CpuFeatures.h"
+
+#if CPU_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace {
+
+#if CPU_X86
+void cpuid(unsigned int leaf, unsigned int subleaf, unsigned int regs[4]) {
+#if defined(_MSC_VER)
+    int out[4];
+    __cpuidex(out, static_cast<int>(leaf), static_cast<int>(subleaf));
+    for (int i = 0; i < 4; i++) regs[i] = static_cast<unsigned int>(out[i]);
+#else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+// AVX state must be enabled by the OS (XCR0 bits 1 and 2), not only by the CPU.
+bool osSavesAvxState() {
+#if defined(_MSC_VER)
+    return (_xgetbv(0) & 0x6) == 0x6;
+#else
+    unsigned int lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (lo & 0x6) == 0x6;
+#endif
+}
+#endif
+
+CpuFeatures detect() {
+    CpuFeatures features;
+#if CPU_X86
+    unsigned int regs[4];
+    cpuid(0, 0, regs);
+    const unsigned int maxLeaf = regs[0];
+
+    cpuid(1, 0, regs);
+    features.sse2 = (regs[3] & (1u << 26)) != 0;
+    features.ssse3 = (regs[2] & (1u << 9)) != 0;
+    features.sse41 = (regs[2] & (1u << 19)) != 0;
+    const bool osxsave = (regs[2] & (1u << 27)) != 0;
+    const bool avx = (regs[2] & (1u << 28)) != 0 && osxsave && osSavesAvxState();
+
+    if (maxLeaf >= 7) {
+        cpuid(7, 0, regs);
+        features.avx2 = avx && (regs[1] & (1u << 5)) != 0;
+        features.sha = features.sse41 && (regs[1] & (1u << 29)) != 0;
+    }
+#endif
+    return features;
+}
+
+}
+
+const CpuFeatures& cpuFeatures() {
+    static const CpuFeatures features = detect();
+    return features;
+}
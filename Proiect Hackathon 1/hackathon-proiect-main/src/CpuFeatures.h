@@ -0,0 +1,34 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define CPU_X86 1
+#else
+#define CPU_X86 0
+#endif
+
+// GCC and Clang only emit vector instructions inside functions that are
+// compiled for the matching target; MSVC accepts the intrinsics anywhere.
+#if CPU_X86 && (defined(__GNUC__) || defined(__clang__))
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_SSSE3 __attribute__((target("ssse3")))
+#define TARGET_SSE41 __attribute__((target("sse4.1")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#define TARGET_SHA __attribute__((target("sha,sse4.1")))
+#else
+#define TARGET_SSE2
+#define TARGET_SSSE3
+#define TARGET_SSE41
+#define TARGET_AVX2
+#define TARGET_SHA
+#endif
+
+// Instruction set extensions usable on this machine, detected once via CPUID.
+struct CpuFeatures {
+    bool sse2 = false;
+    bool ssse3 = false;
+    bool sse41 = false;
+    bool avx2 = false;
+    bool sha = false;
+};
+
+const CpuFeatures& cpuFeatures();
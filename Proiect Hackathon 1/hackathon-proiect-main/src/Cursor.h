@@ -0,0 +1,67 @@
+#pragma once
+#include "StatementCache.h"
+#include <cstddef>
+#include <iostream>
+#include <iterator>
+#include <ostream>
+#include <string_view>
+#include <utility>
+
+// Text column of the current row as a view into SQLite's buffer.
+inline std::string_view columnText(sqlite3_stmt* stmt, const int column) {
+    const unsigned char* text = sqlite3_column_text(stmt, column);
+    if (text == nullptr) {
+        return {};
+    }
+    return {reinterpret_cast<const char*>(text), static_cast<std::size_t>(sqlite3_column_bytes(stmt, column))};
+}
+
+// Single-pass range over the rows of a prepared statement. Rows are produced
+// one sqlite3_step at a time; a Row is a thin view over the statement, so any
+// std::string_view it returns is only valid until the iterator is advanced.
+//
+//     for (const DumbsterRow& row : manager.streamDumbstersCity("Cluj")) { ... }
+template <typename Row>
+class Cursor {
+    Statement stmt;
+    bool done = false;
+
+    void step() {
+        int stepVal = sqlite3_step(stmt);
+        if (stepVal != SQLITE_ROW) {
+            if (stepVal != SQLITE_DONE) {
+                std::cerr << "Error stepping cursor: " << sqlite3_errmsg(sqlite3_db_handle(stmt)) << std::endl;
+            }
+            done = true;
+        }
+    }
+public:
+    class iterator {
+        Cursor* cursor = nullptr;
+    public:
+        using value_type = Row;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        explicit iterator(Cursor* cursor) : cursor(cursor) {}
+
+        Row operator*() const { return Row{cursor->stmt.get()}; }
+        iterator& operator++() {
+            cursor->step();
+            return *this;
+        }
+        void operator++(int) { ++*this; }
+        bool operator==(std::default_sentinel_t) const { return cursor == nullptr || cursor->done; }
+    };
+
+    Cursor() : done(true) {}
+    explicit Cursor(Statement stmt) : stmt(std::move(stmt)), done(!this->stmt) {}
+
+    iterator begin() {
+        if (!done) {
+            step();
+        }
+        return iterator(this);
+    }
+    std::default_sentinel_t end() const { return {}; }
+};
@@ -1,9 +1,30 @@
 #pragma once
 #include "DatabaseManager.h"
+#include "ReadingArchive.h"
+#include <algorithm>
 #include <iostream>
+#include <limits>
 #include <ostream>
 #include <sstream>
 
+namespace {
+
+// Clustered on (user, timestamp): a user's readings in a time range are one
+// contiguous b-tree range, so range queries cost O(log n + rows returned).
+constexpr const char* ReadingsTableSQL =
+    "CREATE TABLE IF NOT EXISTS readings ("
+    "user TEXT NOT NULL,"
+    "timestamp INTEGER NOT NULL,"
+    "carbonDioxide REAL,"
+    "methane REAL,"
+    "ammonia REAL,"
+    "inductivity REAL,"
+    "reflectance REAL,"
+    "PRIMARY KEY (user, timestamp)"
+    ") WITHOUT ROWID;";
+
+}
+
 DatabaseManager::DatabaseManager(const std::string &dbName) {
     this->dbName = dbName;
     this->db = nullptr;
@@ -18,6 +39,10 @@ DatabaseManager::DatabaseManager(const std::string &dbName) {
 }
 
 DatabaseManager::~DatabaseManager() {
+    detach();
+    if (!flushReadings()) {
+        std::cerr << "Error flushing pending readings." << dbName << std::endl;
+    }
     bool closeStatus = this->closeDB();
     if (!closeStatus) {
         std::cerr << "Error closing database." << dbName << std::endl;
@@ -31,32 +56,78 @@ bool DatabaseManager::openDB() {
         std::cerr << "Failed to open database: " << sqlite3_errmsg(db) << std::endl;
         return false;
     }
+    statements.attach(db);
     std::cout << "Opened database " << dbName << std::endl;
     return true;
 }
 
 bool DatabaseManager::setupDB() const {
-    const char* sqlQueryReadings =
-        "CREATE TABLE IF NOT EXISTS readings ("
-        "carbonDioxide REAL,"
-        "methane REAL,"
-        "ammonia REAL,"
-        "inductivity REAL,"
-        "reflectance REAL,"
-        "user TEXT NOT NULL"
-        ");";
     char* errMsg = nullptr;
-    int execStatus = sqlite3_exec(db, sqlQueryReadings, nullptr, nullptr, &errMsg);
+    int execStatus = sqlite3_exec(db, ReadingsTableSQL, nullptr, nullptr, &errMsg);
     if (execStatus != SQLITE_OK) {
         std::cerr << "Error creating table: " << errMsg << std::endl;
         sqlite3_free(errMsg);
         return false;
     }
+    if (!migrateReadings()) {
+        return false;
+    }
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db, "SELECT MAX(timestamp) FROM readings;", -1, &stmt, nullptr) == SQLITE_OK
+        && sqlite3_step(stmt) == SQLITE_ROW) {
+        lastTimestamp = sqlite3_column_int64(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
     std::cout << "Table readings created successfully" << std::endl;
     return true;
 }
 
+bool DatabaseManager::migrateReadings() const {
+    // Tables created before timestamps existed have a rowid layout and no
+    // primary key. They are copied into the clustered layout; a row without a
+    // timestamp (or with the 0 an earlier in-place migration gave it) takes its
+    // rowid, so old rows stay distinct, in insertion order and before every
+    // stamped reading.
+    sqlite3_stmt* stmt = nullptr;
+    const char* inspect =
+        "SELECT (SELECT COUNT(*) FROM pragma_index_list('readings') WHERE origin = 'pk'),"
+        " (SELECT COUNT(*) FROM pragma_table_info('readings') WHERE name = 'timestamp');";
+    if (sqlite3_prepare_v2(db, inspect, -1, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Error inspecting readings: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    const bool inspected = sqlite3_step(stmt) == SQLITE_ROW;
+    const bool clustered = inspected && sqlite3_column_int(stmt, 0) > 0;
+    const bool hasTimestamp = inspected && sqlite3_column_int(stmt, 1) > 0;
+    sqlite3_finalize(stmt);
+    if (!inspected) {
+        std::cerr << "Error inspecting readings: " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    if (clustered) {
+        return true;
+    }
+    std::cout << "Migrating readings table to timestamped layout" << std::endl;
+    const std::string copy = std::string(
+        "INSERT INTO readings (user, timestamp, carbonDioxide, methane, ammonia, inductivity, reflectance) "
+        "SELECT user, ") + (hasTimestamp ? "CASE WHEN timestamp = 0 THEN rowid ELSE timestamp END" : "rowid")
+        + ", carbonDioxide, methane, ammonia, inductivity, reflectance FROM readings_legacy;";
+    if (!execSQL("BEGIN IMMEDIATE;")) {
+        return false;
+    }
+    if (execSQL("ALTER TABLE readings RENAME TO readings_legacy;")
+        && execSQL(ReadingsTableSQL)
+        && execSQL(copy.c_str())
+        && execSQL("DROP TABLE readings_legacy;")) {
+        return execSQL("COMMIT;");
+    }
+    execSQL("ROLLBACK;");
+    return false;
+}
+
 bool DatabaseManager::closeDB() const {
+    statements.clear();
     int exitStatus = sqlite3_close(db);
     if (exitStatus != SQLITE_OK) {
         std::cerr << "Failed to close database: " << sqlite3_errmsg(db) << std::endl;
@@ -67,54 +138,321 @@ bool DatabaseManager::closeDB() const {
 }
 
 bool DatabaseManager::addReading(const float carbon, const float methane, const float ammonia, const float induct, const float reflect, const std::string& email) const {
+    const ReadingInput reading{carbon, methane, ammonia, induct, reflect, email};
+    return addReadings(std::span(&reading, 1));
+}
 
-    const char* sql =
-        "INSERT INTO Readings (carbonDioxide, methane, ammonia, inductivity, reflectance, user) "
-        "VALUES (?, ?, ?, ?, ?, ?);";
-    sqlite3_stmt* stmt = nullptr;
+std::int64_t DatabaseManager::stampReading(const std::int64_t requested) const {
+    if (requested != 0) {
+        return requested;
+    }
+    // Wall-clock microseconds, bumped when needed so stamps never repeat or go back.
+    const std::int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    std::int64_t last = lastTimestamp.load();
+    std::int64_t next;
+    do {
+        next = now > last ? now : last + 1;
+    } while (!lastTimestamp.compare_exchange_weak(last, next));
+    return next;
+}
 
-    if (sqlite3_prepare_v2(db, sql, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Error preparing addReading: " << sqlite3_errmsg(db) << std::endl;
+bool DatabaseManager::execSQL(const char* sql) const {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Error executing " << sql << " " << errMsg << std::endl;
+        sqlite3_free(errMsg);
         return false;
     }
+    return true;
+}
 
-    sqlite3_bind_double(stmt, 1, carbon);
-    sqlite3_bind_double(stmt, 2, methane);
-    sqlite3_bind_double(stmt, 3, ammonia);
-    sqlite3_bind_double(stmt, 4, induct);
-    sqlite3_bind_double(stmt, 5, reflect);
-    sqlite3_bind_text(stmt, 6, email.c_str(), -1, SQLITE_TRANSIENT);
+bool DatabaseManager::insertBatch(sqlite3_stmt* stmt, std::span<const ReadingInput> readings) const {
+    std::lock_guard lock(writeMutex);
+    if (!execSQL("BEGIN IMMEDIATE;")) {
+        return false;
+    }
+    std::vector<std::int64_t> timestamps;
+    timestamps.reserve(readings.size());
+    for (const ReadingInput& r : readings) {
+        timestamps.push_back(stampReading(r.timestamp));
 
-    bool success = (sqlite3_step(stmt) == SQLITE_DONE);
-    if (!success)
-        std::cerr << "Error executing addReading: " << sqlite3_errmsg(db) << std::endl;
-    sqlite3_finalize(stmt);
-    return success;
+        sqlite3_bind_double(stmt, 1, r.carbonDioxide);
+        sqlite3_bind_double(stmt, 2, r.methane);
+        sqlite3_bind_double(stmt, 3, r.ammonia);
+        sqlite3_bind_double(stmt, 4, r.inductivity);
+        sqlite3_bind_double(stmt, 5, r.reflectance);
+        sqlite3_bind_text(stmt, 6, r.user.c_str(), static_cast<int>(r.user.size()), SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 7, timestamps.back());
+
+        int stepVal = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        // Another connection stamped a reading for this user in the same
+        // microsecond; readings we stamp ourselves just move to the next one.
+        for (int retry = 0; stepVal == SQLITE_CONSTRAINT && r.timestamp == 0 && retry < 16; retry++) {
+            timestamps.back() = stampReading(0);
+            sqlite3_bind_int64(stmt, 7, timestamps.back());
+            stepVal = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+        }
+        if (stepVal != SQLITE_DONE) {
+            std::cerr << "Error executing addReadings: " << sqlite3_errmsg(db) << std::endl;
+            execSQL("ROLLBACK;");
+            return false;
+        }
+    }
+    if (!execSQL("COMMIT;")) {
+        return false;
+    }
+    for (ReadingObserver* observer : observers) {
+        observer->onReadings(readings, timestamps);
+    }
+    return true;
 }
 
-std::vector<Reading> DatabaseManager::getReadings(const std::string& user) const {
-    std::vector<Reading> readings;
-    const char* sqlQuery =
-        "SELECT carbonDioxide, methane, ammonia, inductivity, reflectance FROM readings";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Error preparing getSensorsByDevice: " << sqlite3_errmsg(db) << std::endl;
-        return readings;
+bool DatabaseManager::addReadings(std::span<const ReadingInput> readings) const {
+    return commitReadings(readings) == readings.size();
+}
+
+std::size_t DatabaseManager::commitReadings(std::span<const ReadingInput> readings) const {
+    if (readings.empty()) {
+        return 0;
     }
-    sqlite3_bind_text(stmt, 1, user.c_str(), -1, SQLITE_TRANSIENT);
+    const char* sql =
+        "INSERT INTO readings (carbonDioxide, methane, ammonia, inductivity, reflectance, user, timestamp) "
+        "VALUES (?, ?, ?, ?, ?, ?, ?);";
+    Statement stmt = statements.acquire(sql);
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        Reading r;
-        r.carbonDioxide = sqlite3_column_double(stmt, 1);
-        r.methane = sqlite3_column_double(stmt, 2);
-        r.ammonia = sqlite3_column_double(stmt, 3);
-        r.inductivity = sqlite3_column_double(stmt, 4);
-        r.reflectance = sqlite3_column_double(stmt, 5);
-        readings.push_back(r);
+    if (!stmt) {
+        std::cerr << "Error preparing addReadings: " << sqlite3_errmsg(db) << std::endl;
+        return 0;
     }
 
-    sqlite3_finalize(stmt);
-    return readings;
+    const std::size_t step = batchSize > 0 ? batchSize : readings.size();
+    std::size_t committed = 0;
+    while (committed < readings.size()) {
+        const std::size_t count = std::min(step, readings.size() - committed);
+        if (!insertBatch(stmt, readings.subspan(committed, count))) {
+            break;
+        }
+        committed += count;
+    }
+    return committed;
 }
 
+bool DatabaseManager::queueReading(const ReadingInput& reading) {
+    std::lock_guard lock(pendingMutex);
+    pending.push_back(reading);
+    if (pending.size() >= batchSize || std::chrono::steady_clock::now() - lastFlush >= flushInterval) {
+        return flushPending();
+    }
+    return true;
+}
+
+bool DatabaseManager::flushReadings() {
+    std::lock_guard lock(pendingMutex);
+    return flushPending();
+}
+
+bool DatabaseManager::flushPending() {
+    if (pending.empty()) {
+        return true;
+    }
+    lastFlush = std::chrono::steady_clock::now();
+    // Batches committed before a failure leave pending, so the next flush
+    // retries only the rest instead of inserting them again.
+    const std::size_t committed = commitReadings(pending);
+    pending.erase(pending.begin(), pending.begin() + static_cast<std::ptrdiff_t>(committed));
+    return pending.empty();
+}
 
+void DatabaseManager::setBatchSize(const std::size_t size) {
+    batchSize = size;
+}
+
+void DatabaseManager::setFlushInterval(const std::chrono::milliseconds interval) {
+    flushInterval = interval;
+    if (scheduler != nullptr) {
+        attach(*scheduler);
+    }
+}
+
+void DatabaseManager::attach(MonitorScheduler& scheduler) {
+    detach();
+    this->scheduler = &scheduler;
+    flushTask = scheduler.schedule(flushInterval, [this] {
+        if (!flushReadings()) {
+            std::cerr << "Error flushing pending readings." << dbName << std::endl;
+        }
+    });
+}
+
+void DatabaseManager::detach() {
+    if (scheduler != nullptr) {
+        scheduler->cancel(flushTask);
+        scheduler = nullptr;
+        flushTask = MonitorScheduler::InvalidTask;
+    }
+}
+
+void DatabaseManager::addObserver(ReadingObserver* observer) {
+    observers.push_back(observer);
+}
+
+void DatabaseManager::attachArchive(ReadingArchive* archive) {
+    this->archive = archive;
+}
+
+std::int64_t DatabaseManager::archiveOlderThan(const std::int64_t cutoff) {
+    if (archive == nullptr) {
+        return 0;
+    }
+    std::lock_guard lock(writeMutex);
+    // Segments are sealed before the rows are deleted and the delete commits in
+    // the same transaction as the read, so a failure never loses readings; at
+    // worst a reading exists in both places and the table copy is archived again.
+    if (!execSQL("BEGIN IMMEDIATE;")) {
+        return -1;
+    }
+    std::int64_t moved = 0;
+    bool success = true;
+    {
+        const char* sqlQuery =
+            "SELECT carbonDioxide, methane, ammonia, inductivity, reflectance, timestamp, user FROM readings "
+            "WHERE timestamp < ? ORDER BY user, timestamp;";
+        Statement stmt = statements.acquire(sqlQuery);
+        if (!stmt) {
+            std::cerr << "Error preparing archiveOlderThan: " << sqlite3_errmsg(db) << std::endl;
+            execSQL("ROLLBACK;");
+            return -1;
+        }
+        sqlite3_bind_int64(stmt, 1, cutoff);
+
+        std::string user;
+        std::vector<Reading> rows;
+        int stepVal = SQLITE_DONE;
+        while (success && (stepVal = sqlite3_step(stmt)) == SQLITE_ROW) {
+            const std::string_view rowUser = columnText(stmt, 6);
+            if (rowUser != user || rows.size() == ReadingArchive::MaxSegmentRows) {
+                success = rows.empty() || archive->writeSegments(user, rows);
+                moved += static_cast<std::int64_t>(rows.size());
+                rows.clear();
+                user = rowUser;
+            }
+            rows.push_back(ReadingRow{stmt}.toReading());
+        }
+        if (success && stepVal != SQLITE_DONE) {
+            std::cerr << "Error executing archiveOlderThan: " << sqlite3_errmsg(db) << std::endl;
+            success = false;
+        }
+        if (success && !rows.empty()) {
+            success = archive->writeSegments(user, rows);
+            moved += static_cast<std::int64_t>(rows.size());
+        }
+    }
+    if (success) {
+        Statement stmt = statements.acquire("DELETE FROM readings WHERE timestamp < ?;");
+        sqlite3_bind_int64(stmt, 1, cutoff);
+        success = stmt && sqlite3_step(stmt) == SQLITE_DONE;
+    }
+    if (!success) {
+        execSQL("ROLLBACK;");
+        return -1;
+    }
+    return execSQL("COMMIT;") ? moved : -1;
+}
+
+std::vector<std::string> DatabaseManager::getReadingUsers() const {
+    std::vector<std::string> users;
+    Statement stmt = statements.acquire("SELECT DISTINCT user FROM readings ORDER BY user;");
+    if (!stmt) {
+        std::cerr << "Error preparing getReadingUsers: " << sqlite3_errmsg(db) << std::endl;
+        return users;
+    }
+    int stepVal;
+    while ((stepVal = sqlite3_step(stmt)) == SQLITE_ROW) {
+        users.emplace_back(columnText(stmt, 0));
+    }
+    if (stepVal != SQLITE_DONE) {
+        std::cerr << "Error executing getReadingUsers: " << sqlite3_errmsg(db) << std::endl;
+    }
+    return users;
+}
+
+std::vector<Reading> DatabaseManager::getReadings(const std::string& user) const {
+    return getReadings(user, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(),
+                       std::numeric_limits<std::size_t>::max()).readings;
+}
+
+ReadingPage DatabaseManager::getReadings(const std::string& user, const std::int64_t from, const std::int64_t to, const std::size_t limit) const {
+    ReadingPage page{{}, to, false};
+    // Rows inserted with explicit timestamps can be older than archived ones,
+    // so the first limit + 1 rows of the archive and of the table are merged
+    // by timestamp. The extra row tells us whether another page follows;
+    // SIZE_MAX means no limit and gets none.
+    const std::size_t probe = limit == std::numeric_limits<std::size_t>::max() ? limit : limit + 1;
+    std::vector<Reading> archived;
+    if (archive != nullptr) {
+        archived = archive->read(user, from, to, probe);
+    }
+    std::size_t next = 0;
+    auto rows = streamReadings(user, from, to, probe);
+    auto row = rows.begin();
+    bool lastArchived = false;
+    while (page.readings.size() <= limit) {
+        Reading reading;
+        bool fromArchive;
+        if (row != rows.end() && (next == archived.size() || (*row).timestamp() < archived[next].timestamp)) {
+            reading = (*row).toReading();
+            fromArchive = false;
+            ++row;
+        }
+        else if (next < archived.size()) {
+            reading = archived[next++];
+            fromArchive = true;
+        }
+        else {
+            break;
+        }
+        // An archived reading with the timestamp of a table row is that row,
+        // left in the table by an interrupted archiveOlderThan. Rows from the
+        // same source are never collapsed.
+        if (!page.readings.empty() && page.readings.back().timestamp == reading.timestamp && lastArchived != fromArchive) {
+            continue;
+        }
+        page.readings.push_back(reading);
+        lastArchived = fromArchive;
+    }
+    if (page.readings.size() > limit) {
+        page.readings.resize(limit);
+        page.hasMore = true;
+        page.nextFrom = limit > 0 ? page.readings.back().timestamp + 1 : from;
+    }
+    return page;
+}
+
+Cursor<ReadingRow> DatabaseManager::streamReadings(const std::string& user) const {
+    return streamReadings(user, std::numeric_limits<std::int64_t>::min(), std::numeric_limits<std::int64_t>::max(),
+                          std::numeric_limits<std::size_t>::max());
+}
+
+Cursor<ReadingRow> DatabaseManager::streamReadings(const std::string& user, const std::int64_t from, const std::int64_t to, const std::size_t limit) const {
+    const char* sqlQuery =
+        "SELECT carbonDioxide, methane, ammonia, inductivity, reflectance, timestamp FROM readings "
+        "WHERE user = ? AND timestamp >= ? AND timestamp < ? ORDER BY timestamp LIMIT ?;";
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing streamReadings: " << sqlite3_errmsg(db) << std::endl;
+        return {};
+    }
+    sqlite3_bind_text(stmt, 1, user.c_str(), static_cast<int>(user.size()), SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, from);
+    sqlite3_bind_int64(stmt, 3, to);
+    sqlite3_bind_int64(stmt, 4, limit > static_cast<std::size_t>(std::numeric_limits<std::int64_t>::max())
+                                    ? -1 : static_cast<std::int64_t>(limit));
+    return Cursor<ReadingRow>(std::move(stmt));
+}
+
+StatementCacheStats DatabaseManager::statementCacheStats() const {
+    return statements.stats();
+}
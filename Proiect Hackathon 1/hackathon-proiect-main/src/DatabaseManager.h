@@ -1,10 +1,19 @@
 #pragma once
 #include "sqlite3.h"
+#include "Cursor.h"
+#include "MonitorScheduler.h"
+#include "StatementCache.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
 #include <string>
 #include <vector>
 
 struct Reading {
-    std::string timestamp;
+    std::int64_t timestamp; // microseconds since the Unix epoch
     double carbonDioxide;
     double methane;
     double ammonia;
@@ -12,9 +21,86 @@ struct Reading {
     double reflectance;
 };
 
+// View of the current row of a readings cursor.
+struct ReadingRow {
+    sqlite3_stmt* stmt;
+
+    double carbonDioxide() const { return sqlite3_column_double(stmt, 0); }
+    double methane() const { return sqlite3_column_double(stmt, 1); }
+    double ammonia() const { return sqlite3_column_double(stmt, 2); }
+    double inductivity() const { return sqlite3_column_double(stmt, 3); }
+    double reflectance() const { return sqlite3_column_double(stmt, 4); }
+    std::int64_t timestamp() const { return sqlite3_column_int64(stmt, 5); }
+
+    Reading toReading() const {
+        Reading r;
+        r.timestamp = timestamp();
+        r.carbonDioxide = carbonDioxide();
+        r.methane = methane();
+        r.ammonia = ammonia();
+        r.inductivity = inductivity();
+        r.reflectance = reflectance();
+        return r;
+    }
+};
+
+struct ReadingInput {
+    double carbonDioxide;
+    double methane;
+    double ammonia;
+    double inductivity;
+    double reflectance;
+    std::string user;
+    std::int64_t timestamp = 0; // microseconds since the Unix epoch, 0 = stamp on insert
+};
+
+// One page of a time-range query. Pass nextFrom as the next call's `from` to
+// continue after the last returned reading.
+struct ReadingPage {
+    std::vector<Reading> readings;
+    std::int64_t nextFrom;
+    bool hasMore;
+};
+
+// Receives every batch of readings after it has been committed by a
+// DatabaseManager, with the timestamps the manager assigned to them.
+class ReadingObserver {
+public:
+    virtual ~ReadingObserver() = default;
+    virtual void onReadings(std::span<const ReadingInput> readings, std::span<const std::int64_t> timestamps) = 0;
+};
+
+class ReadingArchive;
+
 class DatabaseManager {
     sqlite3 *db;
     std::string dbName;
+    mutable StatementCache statements;
+
+    // Readings are committed in transactions of at most batchSize rows. Buffered
+    // readings (queueReading) are flushed once the batch is full or flushInterval
+    // has passed since the last flush; once attached to a scheduler, also every
+    // flushInterval, so a device that stops sending is not left uncommitted.
+    std::size_t batchSize = 256;
+    std::chrono::milliseconds flushInterval{1000};
+    std::mutex pendingMutex;  // pending and lastFlush, shared with the scheduled flush
+    std::vector<ReadingInput> pending;
+    std::chrono::steady_clock::time_point lastFlush = std::chrono::steady_clock::now();
+    // One transaction at a time on the connection: inserts, the scheduled flush
+    // and archiveOlderThan (run from ReadingArchiver's thread) all write.
+    mutable std::mutex writeMutex;
+    MonitorScheduler* scheduler = nullptr;
+    MonitorScheduler::TaskId flushTask = MonitorScheduler::InvalidTask;
+
+    std::vector<ReadingObserver*> observers;
+    ReadingArchive* archive = nullptr;
+    mutable std::atomic<std::int64_t> lastTimestamp{0};
+
+    bool execSQL(const char* sql) const;
+    bool migrateReadings() const;
+    bool insertBatch(sqlite3_stmt* stmt, std::span<const ReadingInput> readings) const;
+    // Caller holds pendingMutex.
+    bool flushPending();
 public:
     explicit DatabaseManager(const std::string &dbName);
     ~DatabaseManager();
@@ -24,6 +110,39 @@ public:
     bool closeDB() const;
 
     bool addReading(float carbon, float methane, float ammonia, float induct, float reflect, const std::string& email) const;
+    bool addReadings(std::span<const ReadingInput> readings) const;
+    // Like addReadings, but returns the rows committed: a prefix of
+    // `readings`, less than all of them when a later batch failed.
+    std::size_t commitReadings(std::span<const ReadingInput> readings) const;
+    // `requested`, or for 0 the current time in microseconds, bumped past the
+    // last stamp so stamps never repeat or go back. Safe from any thread.
+    std::int64_t stampReading(std::int64_t requested) const;
+
+    bool queueReading(const ReadingInput& reading);
+    bool flushReadings();
+    void setBatchSize(std::size_t size);
+    void setFlushInterval(std::chrono::milliseconds interval);
+    // Flushes queued readings every flushInterval on a scheduler worker.
+    void attach(MonitorScheduler& scheduler);
+    void detach();
 
+    void addObserver(ReadingObserver* observer);
+
+    // Readings moved to the archive stay visible through getReadings; the
+    // streamReadings cursors only cover rows still in the readings table.
+    void attachArchive(ReadingArchive* archive);
+    // Moves every reading with timestamp < cutoff into the attached archive and
+    // deletes it from the table. Returns the number of readings moved, -1 on error.
+    std::int64_t archiveOlderThan(std::int64_t cutoff);
+
+    // Every user with readings still in the table.
+    std::vector<std::string> getReadingUsers() const;
     std::vector<Reading> getReadings(const std::string& user) const;
+    // Readings of `user` with from <= timestamp < to, oldest first, at most limit
+    // per page (keyset pagination on timestamp).
+    ReadingPage getReadings(const std::string& user, std::int64_t from, std::int64_t to, std::size_t limit) const;
+    Cursor<ReadingRow> streamReadings(const std::string& user) const;
+    Cursor<ReadingRow> streamReadings(const std::string& user, std::int64_t from, std::int64_t to, std::size_t limit) const;
+
+    StatementCacheStats statementCacheStats() const;
 };
\ No newline at end of file
@@ -1,38 +1,64 @@
 #pragma once
 #include "Dumbster.h"
+#include "DumbsterEventBus.h"
+#include "FillForecaster.h"
+#include "FillHistory.h"
+#include "IngestQueue.h"
 
 void Dumbster::startMonitoring() {
+    startMonitoring(MonitorScheduler::shared());
+}
+
+void Dumbster::startMonitoring(MonitorScheduler& scheduler) {
     if (running) return; // already running
     running = true;
-    monitorThread = std::jthread(&Dumbster::monitorLoop, this);
+    this->scheduler = &scheduler;
+    monitorTask = scheduler.schedule(samplingPeriod, std::chrono::milliseconds(0), [this] { sample(); });
     std::cout << "[Monitor] Started monitoring dumpster ID: " << id << "\n";
 }
 
 void Dumbster::stopMonitoring() {
     if (!running) return;
     running = false;
-    monitorThread.request_stop(); // ask thread to stop
+    scheduler->cancel(monitorTask); // waits for a sample in progress
+    monitorTask = MonitorScheduler::InvalidTask;
+    if (events != nullptr) events->forget(id);
     std::cout << "[Monitor] Stopped monitoring dumpster ID: " << id << "\n";
 }
 
-void Dumbster::monitorLoop(std::stop_token stopToken) {
-    std::default_random_engine gen(std::random_device{}());
-    std::uniform_real_distribution<float> dist(0.0f, 100.0f);
+void Dumbster::sample() {
+    fullness = simulateSensorReading();
+    std::cout << "[Sensor] Dumpster " << id
+              << " fullness: " << fullness << "%\n";
 
-    while (!stopToken.stop_requested() && running) {
-        fullness = simulateSensorReading();
-        std::cout << "[Sensor] Dumpster " << id
-                  << " fullness: " << fullness << "%\n";
-
-        bool isFull = fullness >= 80.0f;
-        database.updateDumbsterFull(id, isFull);
+    if (forecaster != nullptr || history != nullptr) {
+        const auto now = std::chrono::system_clock::now().time_since_epoch();
+        const std::int64_t seconds = std::chrono::duration_cast<std::chrono::seconds>(now).count();
+        if (forecaster != nullptr) forecaster->observe(id, seconds, fullness);
+        if (history != nullptr) history->record(id, seconds, fullness);
+    }
 
-        std::this_thread::sleep_for(std::chrono::seconds(3));
+    if (tracker != nullptr) {
+        const bool full = tracker->report(id, fullness);
+        if (events != nullptr) events->report(id, full, fullness);
+        return;
+    }
+    const bool wasFull = isFull;
+    isFull = nextFullState(isFull, fullness, FullnessThresholds{});
+    if (events != nullptr) events->report(id, isFull, fullness);
+    if (persistedKnown && isFull == wasFull) {
+        return;
+    }
+    if (ingest != nullptr) {
+        persistedKnown = ingest->submitFullness(id, isFull);
+    }
+    else {
+        persistedKnown = database.updateDumbsterFull(id, isFull);
     }
 }
 
 float Dumbster::simulateSensorReading() {
-    static std::default_random_engine gen(std::random_device{}());
-    static std::uniform_real_distribution<float> dist(0.0f, 100.0f);
+    thread_local std::default_random_engine gen(std::random_device{}());
+    thread_local std::uniform_real_distribution<float> dist(0.0f, 100.0f);
     return dist(gen);
 }
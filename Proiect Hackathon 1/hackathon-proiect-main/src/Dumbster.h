@@ -1,30 +1,88 @@
 #pragma once
 #include "DumbsterDatabaseManager.h"
+#include "FullnessTracker.h"
+#include "MonitorScheduler.h"
 #include <atomic>
 #include <thread>
 #include <chrono>
 #include <random>
 #include <iostream>
 
+class IngestQueue;
+class FillForecaster;
+class FillHistory;
+class DumbsterEventBus;
+
 class Dumbster {
-    DumbsterDatabaseManager database;
-    std::string dbName;
+    DumbsterDatabaseManager& database;
     int id;
 
     float fullness = 0.0f;//
     std::atomic<bool> running{false};
-    std::jthread monitorThread;
+    MonitorScheduler* scheduler = nullptr;
+    MonitorScheduler::TaskId monitorTask = MonitorScheduler::InvalidTask;
+    std::chrono::milliseconds samplingPeriod{3000};
+    IngestQueue* ingest = nullptr;
+    FullnessTracker* tracker = nullptr;
+    FillForecaster* forecaster = nullptr;
+    FillHistory* history = nullptr;
+    DumbsterEventBus* events = nullptr;
+
+    // Without a tracker the dumpster applies the same hysteresis and
+    // change-only rule itself.
+    bool isFull = false;
+    bool persistedKnown = false;
 
 public:
-    Dumbster(const std::string& dbName, int id)
-        : dbName(dbName), database(dbName), id(id) {}
+    // Fullness is written through `database`, shared by the fleet, so a
+    // DumbsterCache or geo index attached to it sees every change.
+    Dumbster(DumbsterDatabaseManager& database, int id)
+        : database(database), id(id) {}
+    ~Dumbster() {
+        stopMonitoring();
+    }
 
+    // Samples the sensor every samplingPeriod on a shared scheduler instead of
+    // a thread per dumpster; without one, MonitorScheduler::shared() is used.
     void startMonitoring();
+    void startMonitoring(MonitorScheduler& scheduler);
     void stopMonitoring();
+    void setSamplingPeriod(std::chrono::milliseconds period) {
+        samplingPeriod = period;
+    }
     float getFullness() const {
         return fullness;
+    }
+
+    // Hands fullness updates to a write-behind queue instead of writing them
+    // from the monitor thread. Pass nullptr to write synchronously again.
+    void setIngestQueue(IngestQueue* queue) {
+        ingest = queue;
+    }
+
+    // Reports samples to a shared tracker that writes only state changes,
+    // coalesced per scheduler tick. Takes precedence over the ingest queue.
+    void setFullnessTracker(FullnessTracker* fullnessTracker) {
+        tracker = fullnessTracker;
+    }
+
+    // Feeds every sample to a shared time-to-full forecaster.
+    void setFillForecaster(FillForecaster* fillForecaster) {
+        forecaster = fillForecaster;
+    }
+
+    // Records every sample in a shared fill-history ring.
+    void setFillHistory(FillHistory* fillHistory) {
+        history = fillHistory;
+    }
+
+    // Reports each sample's full state to an event bus, which publishes the
+    // transitions to its subscribers.
+    void setEventBus(DumbsterEventBus* eventBus) {
+        events = eventBus;
+    }
 
 private:
-    void monitorLoop(std::stop_token stopToken);
+    void sample();
     static float simulateSensorReading();
 };
\ No newline at end of file
@@ -0,0 +1,252 @@
+#pragma once
+#include "DumbsterCache.h"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+// Listing orders over record ids, with ties broken by id so they are
+// deterministic. Equal names share a pool id, so ids are compared first.
+struct ByName {
+    const std::vector<DumbsterRecord>& rows;
+    const StringPool& names;
+    std::uint32_t DumbsterRecord::*field;
+
+    bool operator()(const int a, const int b) const {
+        const std::uint32_t x = rows[a].*field;
+        const std::uint32_t y = rows[b].*field;
+        if (x == y) return a < b;
+        return names.view(x) < names.view(y);
+    }
+};
+
+struct ByStreetNumber {
+    const std::vector<DumbsterRecord>& rows;
+
+    bool operator()(const int a, const int b) const {
+        const std::int32_t x = rows[a].streetNumber;
+        const std::int32_t y = rows[b].streetNumber;
+        return x != y ? x < y : a < b;
+    }
+};
+
+template <typename Less>
+void insertSorted(std::vector<int>& ids, const int id, Less less) {
+    ids.insert(std::lower_bound(ids.begin(), ids.end(), id, less), id);
+}
+
+template <typename Less>
+void removeSorted(std::vector<int>& ids, const int id, Less less) {
+    auto position = std::lower_bound(ids.begin(), ids.end(), id, less);
+    if (position != ids.end() && *position == id) ids.erase(position);
+}
+
+}
+
+DumbsterRecord* DumbsterCache::slot(const int id) {
+    if (id < 0 || static_cast<std::size_t>(id) >= rows.size() || !rows[id].live()) return nullptr;
+    return &rows[id];
+}
+
+const DumbsterRecord* DumbsterCache::slot(const int id) const {
+    if (id < 0 || static_cast<std::size_t>(id) >= rows.size() || !rows[id].live()) return nullptr;
+    return &rows[id];
+}
+
+DumbsterRecord DumbsterCache::makeRecord(const std::string& city, const std::string& county, const std::string& street,
+                                         const int streetNumber, const bool isFull, const int useNumber,
+                                         const std::optional<GeoPoint>& location) {
+    DumbsterRecord record;
+    record.city = names.intern(city);
+    record.county = names.intern(county);
+    record.street = names.intern(street);
+    record.streetNumber = streetNumber;
+    record.useNumber = useNumber;
+    record.flags = DumbsterRecord::Live | (isFull ? DumbsterRecord::Full : 0) | (location ? DumbsterRecord::Located : 0);
+    record.location = location.value_or(GeoPoint());
+    if (cityIndex.size() < names.size()) {
+        cityIndex.resize(names.size());
+        countyIndex.resize(names.size());
+        streetIndex.resize(names.size());
+    }
+    return record;
+}
+
+DumbsterData DumbsterCache::materialize(const int id) const {
+    const DumbsterRecord& record = rows[id];
+    DumbsterData data(std::string(names.view(record.city)), std::string(names.view(record.county)),
+                      std::string(names.view(record.street)), record.streetNumber);
+    data.id = id;
+    data.isFull = record.isFull();
+    data.useNumber = record.useNumber;
+    if (record.located()) data.location = record.location;
+    return data;
+}
+
+// Must run while rows[id] still holds the values it was indexed under.
+void DumbsterCache::unindexRow(const int id) {
+    const DumbsterRecord& row = rows[id];
+    removeSorted(cityIndex[row.city], id, ByName{rows, names, &DumbsterRecord::street});
+    removeSorted(countyIndex[row.county], id, ByName{rows, names, &DumbsterRecord::city});
+    removeSorted(streetIndex[row.street], id, ByStreetNumber{rows});
+}
+
+void DumbsterCache::indexRow(const int id) {
+    const DumbsterRecord& row = rows[id];
+    insertSorted(cityIndex[row.city], id, ByName{rows, names, &DumbsterRecord::street});
+    insertSorted(countyIndex[row.county], id, ByName{rows, names, &DumbsterRecord::city});
+    insertSorted(streetIndex[row.street], id, ByStreetNumber{rows});
+}
+
+void DumbsterCache::rebuildIndexes() {
+    cityIndex.assign(names.size(), {});
+    countyIndex.assign(names.size(), {});
+    streetIndex.assign(names.size(), {});
+    for (std::size_t id = 0; id < rows.size(); id++) {
+        const DumbsterRecord& row = rows[id];
+        if (!row.live()) continue;
+        cityIndex[row.city].push_back(static_cast<int>(id));
+        countyIndex[row.county].push_back(static_cast<int>(id));
+        streetIndex[row.street].push_back(static_cast<int>(id));
+    }
+    for (auto& ids : cityIndex) std::sort(ids.begin(), ids.end(), ByName{rows, names, &DumbsterRecord::street});
+    for (auto& ids : countyIndex) std::sort(ids.begin(), ids.end(), ByName{rows, names, &DumbsterRecord::city});
+    for (auto& ids : streetIndex) std::sort(ids.begin(), ids.end(), ByStreetNumber{rows});
+}
+
+void DumbsterCache::clear() {
+    std::unique_lock lock(mutex);
+    names = StringPool();
+    rows.clear();
+    count = 0;
+    rebuildIndexes();
+}
+
+void DumbsterCache::assign(const std::vector<DumbsterData>& data) {
+    std::unique_lock lock(mutex);
+    names = StringPool();
+    rows.clear();
+    count = 0;
+    for (const DumbsterData& row : data) {
+        if (row.id < 0) continue;
+        const auto index = static_cast<std::size_t>(row.id);
+        if (index >= rows.size()) {
+            rows.resize(index + 1);
+        }
+        if (!rows[index].live()) count++;
+        rows[index] = makeRecord(row.city, row.county, row.street, row.streetNumber, row.isFull, row.useNumber, row.location);
+    }
+    rebuildIndexes();
+}
+
+void DumbsterCache::put(const DumbsterData& data) {
+    if (data.id < 0) return;
+    std::unique_lock lock(mutex);
+    const auto index = static_cast<std::size_t>(data.id);
+    if (index >= rows.size()) {
+        // Ids come from AUTOINCREMENT, so the table stays dense.
+        rows.resize(index + 1);
+    }
+    if (rows[index].live()) {
+        unindexRow(data.id);
+    }
+    else {
+        count++;
+    }
+    rows[index] = makeRecord(data.city, data.county, data.street, data.streetNumber, data.isFull, data.useNumber, data.location);
+    indexRow(data.id);
+}
+
+bool DumbsterCache::erase(const int id) {
+    std::unique_lock lock(mutex);
+    DumbsterRecord* row = slot(id);
+    if (row == nullptr) return false;
+    unindexRow(id);
+    *row = DumbsterRecord();
+    count--;
+    return true;
+}
+
+bool DumbsterCache::update(const int id, const std::string& city, const std::string& county, const std::string& street, const int streetNumber) {
+    std::unique_lock lock(mutex);
+    DumbsterRecord* row = slot(id);
+    if (row == nullptr) return false;
+    unindexRow(id);
+    std::optional<GeoPoint> location;
+    if (row->located()) location = row->location;
+    *row = makeRecord(city, county, street, streetNumber, row->isFull(), row->useNumber, location);
+    indexRow(id);
+    return true;
+}
+
+bool DumbsterCache::setFull(const int id, const bool isFull) {
+    std::unique_lock lock(mutex);
+    DumbsterRecord* row = slot(id);
+    if (row == nullptr) return false;
+    row->flags = isFull ? row->flags | DumbsterRecord::Full : row->flags & ~DumbsterRecord::Full;
+    return true;
+}
+
+bool DumbsterCache::setLocation(const int id, const GeoPoint& location) {
+    std::unique_lock lock(mutex);
+    DumbsterRecord* row = slot(id);
+    if (row == nullptr) return false;
+    row->location = location;
+    row->flags |= DumbsterRecord::Located;
+    return true;
+}
+
+std::optional<DumbsterData> DumbsterCache::find(const int id) const {
+    std::shared_lock lock(mutex);
+    if (slot(id) == nullptr) return std::nullopt;
+    return materialize(id);
+}
+
+std::optional<bool> DumbsterCache::isFull(const int id) const {
+    std::shared_lock lock(mutex);
+    const DumbsterRecord* row = slot(id);
+    if (row == nullptr) return std::nullopt;
+    return row->isFull();
+}
+
+std::size_t DumbsterCache::size() const {
+    std::shared_lock lock(mutex);
+    return count;
+}
+
+std::vector<DumbsterData> DumbsterCache::list(const std::vector<std::vector<int>>& index, const std::string_view key) const {
+    std::vector<DumbsterData> data;
+    std::shared_lock lock(mutex);
+    const std::optional<std::uint32_t> name = names.find(key);
+    if (!name || *name >= index.size()) return data;
+    const std::vector<int>& ids = index[*name];
+    data.reserve(ids.size());
+    for (const int id : ids) {
+        data.push_back(materialize(id));
+    }
+    return data;
+}
+
+std::vector<DumbsterData> DumbsterCache::listCity(const std::string_view city) const {
+    return list(cityIndex, city);
+}
+
+std::vector<DumbsterData> DumbsterCache::listCounty(const std::string_view county) const {
+    return list(countyIndex, county);
+}
+
+std::vector<DumbsterData> DumbsterCache::listStreet(const std::string_view street) const {
+    return list(streetIndex, street);
+}
+
+DumbsterCacheMemory DumbsterCache::memoryUsage() const {
+    std::shared_lock lock(mutex);
+    DumbsterCacheMemory memory{count, rows.capacity() * sizeof(DumbsterRecord), names.bytes(), 0};
+    for (const auto* index : {&cityIndex, &countyIndex, &streetIndex}) {
+        memory.indexBytes += index->capacity() * sizeof(std::vector<int>);
+        for (const std::vector<int>& ids : *index) {
+            memory.indexBytes += ids.capacity() * sizeof(int);
+        }
+    }
+    return memory;
+}
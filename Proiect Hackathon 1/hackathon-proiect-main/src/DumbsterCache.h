@@ -0,0 +1,92 @@
+#pragma once
+#include "DumbsterDatabaseManager.h"
+#include "StringPool.h"
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Fixed-size form of one dumpster: names are StringPool ids shared by every
+// dumpster with the same city/county/street, and the id is the record's index.
+struct DumbsterRecord {
+    static constexpr std::uint32_t Live = 1;
+    static constexpr std::uint32_t Full = 2;
+    static constexpr std::uint32_t Located = 4;
+
+    std::uint32_t city = 0;
+    std::uint32_t county = 0;
+    std::uint32_t street = 0;
+    std::int32_t streetNumber = 0;
+    std::int32_t useNumber = 0;
+    std::uint32_t flags = 0;
+    GeoPoint location;
+
+    bool live() const { return (flags & Live) != 0; }
+    bool isFull() const { return (flags & Full) != 0; }
+    bool located() const { return (flags & Located) != 0; }
+};
+
+struct DumbsterCacheMemory {
+    std::size_t dumpsters;
+    std::size_t recordBytes;
+    std::size_t stringBytes;
+    std::size_t indexBytes;
+
+    std::size_t total() const { return recordBytes + stringBytes + indexBytes; }
+};
+
+// In-memory copy of the dumbster table as a dense table indexed by id.
+// DumbsterDatabaseManager::attachCache loads it and then updates it after
+// every successful write (write-through), so reads through any manager the
+// cache is attached to see that process's own writes immediately. Writes made
+// by other processes are not picked up until the cache is loaded again.
+//
+// Rows are DumbsterRecords over an interned string pool; DumbsterData is only
+// built when a row leaves the cache. Secondary indexes map each city, county
+// and street (by pool id) to its dumpster ids, presorted in the order the
+// listings return them (city by street, county by city, street by
+// streetNumber; ties by id), so a listing costs one lookup plus the rows it
+// returns.
+class DumbsterCache {
+    mutable std::shared_mutex mutex;
+    StringPool names;
+    std::vector<DumbsterRecord> rows;
+    std::size_t count = 0;
+
+    // Indexed by pool id; names that are not a city (etc.) have empty lists.
+    std::vector<std::vector<int>> cityIndex;    // sorted by street
+    std::vector<std::vector<int>> countyIndex;  // sorted by city
+    std::vector<std::vector<int>> streetIndex;  // sorted by streetNumber
+
+    DumbsterRecord* slot(int id);
+    const DumbsterRecord* slot(int id) const;
+    DumbsterRecord makeRecord(const std::string& city, const std::string& county, const std::string& street,
+                              int streetNumber, bool isFull, int useNumber, const std::optional<GeoPoint>& location);
+    DumbsterData materialize(int id) const;
+    void indexRow(int id);
+    void unindexRow(int id);
+    void rebuildIndexes();
+    std::vector<DumbsterData> list(const std::vector<std::vector<int>>& index, std::string_view key) const;
+public:
+    void clear();
+    // Replaces the contents with `data` in one pass.
+    void assign(const std::vector<DumbsterData>& data);
+    void put(const DumbsterData& data);
+    bool erase(int id);
+    bool update(int id, const std::string& city, const std::string& county, const std::string& street, int streetNumber);
+    bool setFull(int id, bool isFull);
+    bool setLocation(int id, const GeoPoint& location);
+
+    std::optional<DumbsterData> find(int id) const;
+    std::optional<bool> isFull(int id) const;
+    std::size_t size() const;
+
+    std::vector<DumbsterData> listCity(std::string_view city) const;
+    std::vector<DumbsterData> listCounty(std::string_view county) const;
+    std::vector<DumbsterData> listStreet(std::string_view street) const;
+
+    DumbsterCacheMemory memoryUsage() const;
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include "DumbsterDatabaseManager.h"
+#include "DumbsterCache.h"
+#include <algorithm>
 #include <ostream>
 #include <iostream>
 
@@ -29,11 +31,13 @@ bool DumbsterDatabaseManager::openDB() {
         std::cerr << "Error opening database " << this->dbName << std::endl;
         return false;
     }
+    statements.attach(db);
     std::cout << "Opened database " << this->dbName << std::endl;
     return true;
 }
 
 bool DumbsterDatabaseManager::closeDB() const {
+    statements.clear();
     bool closeStatus = sqlite3_close(this->db);
     if (closeStatus != SQLITE_OK) {
         std::cerr << "Error closing database, rolling back " << this->dbName << std::endl;
@@ -57,7 +61,9 @@ bool DumbsterDatabaseManager::setupDB() const {
         "street TEXT NOT NULL,"
         "streetNumber INTEGER NOT NULL,"
         "isFull BOOLEAN,"
-        "useNumber INTEGER"
+        "useNumber INTEGER,"
+        "latitude REAL,"
+        "longitude REAL"
         ");";
     char* errMsg = nullptr;
     int execStatus = sqlite3_exec(this->db, sqlQuery, nullptr, nullptr, &errMsg);
@@ -66,17 +72,53 @@ bool DumbsterDatabaseManager::setupDB() const {
         sqlite3_free(errMsg);
         return false;
     }
+    // Tables created before dumpsters had a location get the columns added.
+    for (const char* column : {"latitude", "longitude"}) {
+        Statement stmt = statements.acquire("SELECT 1 FROM pragma_table_info('dumbster') WHERE name = ?;");
+        if (!stmt) {
+            std::cerr << "Error preparing setupDB " << sqlite3_errmsg(db) << std::endl;
+            return false;
+        }
+        sqlite3_bind_text(stmt, 1, column, -1, SQLITE_STATIC);
+        if (sqlite3_step(stmt) != SQLITE_ROW) {
+            const std::string sql = std::string("ALTER TABLE dumbster ADD COLUMN ") + column + " REAL;";
+            if (!execSQL(sql.c_str())) {
+                return false;
+            }
+        }
+    }
+    // Cover the listing filters together with their ORDER BY columns so the
+    // stream* queries are index range scans without a sort.
+    if (!execSQL("CREATE INDEX IF NOT EXISTS dumbster_city ON dumbster (city, street);")
+        || !execSQL("CREATE INDEX IF NOT EXISTS dumbster_county ON dumbster (county, city);")
+        || !execSQL("CREATE INDEX IF NOT EXISTS dumbster_street ON dumbster (street, streetNumber);")) {
+        return false;
+    }
+    if (!execSQL("CREATE TABLE IF NOT EXISTS fill_history ("
+                 "dumbsterId INTEGER NOT NULL, "
+                 "bucketStart INTEGER NOT NULL, "
+                 "minimum REAL NOT NULL, "
+                 "maximum REAL NOT NULL, "
+                 "mean REAL NOT NULL, "
+                 "samples INTEGER NOT NULL, "
+                 "PRIMARY KEY (dumbsterId, bucketStart)"
+                 ") WITHOUT ROWID;")) {
+        return false;
+    }
     std::cout << "Created database " << this->dbName << std::endl;
     return true;
 }
 
-bool DumbsterDatabaseManager::newDumbster(const std::string& city, const std::string& county, const std::string& street, int streetNumber) const {
-    const char* sqlQuery = "INSERT INTO dumbster (city, county, street, streetNumber, isFull, useNumber) VALUES (?, ?, ?, ?, FALSE, 0);";
-    sqlite3_stmt *stmt = nullptr;
+bool DumbsterDatabaseManager::newDumbster(const std::string& city, const std::string& county, const std::string& street, int streetNumber,
+                                          const std::optional<GeoPoint>& location) const {
+    const char* sqlQuery =
+        "INSERT INTO dumbster (city, county, street, streetNumber, isFull, useNumber, latitude, longitude) "
+        "VALUES (?, ?, ?, ?, FALSE, 0, ?, ?);";
+    std::lock_guard lock(writeMutex);
+    Statement stmt = statements.acquire(sqlQuery);
 
-    if (sqlite3_prepare(this->db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+    if (!stmt) {
         std::cerr << "Error preparing newDumbster " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
@@ -84,25 +126,41 @@ bool DumbsterDatabaseManager::newDumbster(const std::string& city, const std::st
     sqlite3_bind_text(stmt, 2, county.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 3, street.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int(stmt, 4, streetNumber);
+    if (location) {
+        sqlite3_bind_double(stmt, 5, location->latitude);
+        sqlite3_bind_double(stmt, 6, location->longitude);
+    }
+    else {
+        sqlite3_bind_null(stmt, 5);
+        sqlite3_bind_null(stmt, 6);
+    }
 
     int stepVal = sqlite3_step(stmt);
     bool success = stepVal == SQLITE_DONE;
     if (!success) {
         std::cerr << "Error adding dumbster " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
-    sqlite3_finalize(stmt);
+    const int id = static_cast<int>(sqlite3_last_insert_rowid(db));
+    if (cache != nullptr) {
+        DumbsterData data(city, county, street, streetNumber);
+        data.id = id;
+        data.location = location;
+        cache->put(data);
+    }
+    if (geoIndex != nullptr && location) {
+        geoIndex->put({id, *location, false});
+    }
     std::cout << "Added dumbster" << std::endl;
     return true;
 }
 
 bool DumbsterDatabaseManager::deleteDumbster(const int id) const {
     const char* sqlQuery = "DELETE FROM dumbster WHERE id = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+    std::lock_guard lock(writeMutex);
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
         std::cerr << "Error preparing deleteDumbster " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
@@ -112,17 +170,20 @@ bool DumbsterDatabaseManager::deleteDumbster(const int id) const {
     if (!success) {
         std::cerr << "Error deleting dumbster " << sqlite3_errmsg(db) << std::endl;
     }
-    sqlite3_finalize(stmt);
+    else {
+        if (cache != nullptr) cache->erase(id);
+        if (geoIndex != nullptr) geoIndex->erase(id);
+    }
 
     return success;
 }
 
 bool DumbsterDatabaseManager::updateDumbster(const int id, const std::string& city, const std::string& county, const std::string& street, const int streetNumber) const {
     const char* sqlQuery = "UPDATE dumbster SET city = ?, county = ?, street = ?, streetNumber = ? WHERE id = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+    std::lock_guard lock(writeMutex);
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
         std::cerr << "Error preparing updateDumbster " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
@@ -136,20 +197,57 @@ bool DumbsterDatabaseManager::updateDumbster(const int id, const std::string& ci
     bool success = stepVal == SQLITE_DONE;
     if (!success) {
         std::cerr << "Error updating dumbster " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
-    sqlite3_finalize(stmt);
+    if (cache != nullptr) {
+        cache->update(id, city, county, street, streetNumber);
+    }
     std::cout << "Updated dumbster " << std::endl;
     return true;
 }
 
+bool DumbsterDatabaseManager::setDumbsterLocation(const int id, const GeoPoint& location) const {
+    const char* sqlQuery = "UPDATE dumbster SET latitude = ?, longitude = ? WHERE id = ?;";
+    std::lock_guard lock(writeMutex);
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing setDumbsterLocation " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    sqlite3_bind_double(stmt, 1, location.latitude);
+    sqlite3_bind_double(stmt, 2, location.longitude);
+    sqlite3_bind_int(stmt, 3, id);
+
+    if (sqlite3_step(stmt) != SQLITE_DONE) {
+        std::cerr << "Error updating dumbster location " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    if (sqlite3_changes(db) == 0) {
+        std::cerr << "Dumbster not found: " << id << std::endl;
+        return false;
+    }
+    if (cache != nullptr) {
+        cache->setLocation(id, location);
+    }
+    if (geoIndex != nullptr && !geoIndex->relocate(id, location)) {
+        geoIndex->put({id, location, isDumbsterFull(id)});
+    }
+    return true;
+}
+
 bool DumbsterDatabaseManager::isDumbsterFull(const int id) const {
+    if (cache != nullptr) {
+        std::optional<bool> isFull = cache->isFull(id);
+        if (!isFull) {
+            std::cerr << "Dumbster not found" << std::endl;
+        }
+        return isFull.value_or(false);
+    }
     const char* sqlQuery = "SELECT isFull FROM dumbster WHERE id = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
         std::cerr << "Error preparing isDumbsterFull " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
@@ -159,7 +257,6 @@ bool DumbsterDatabaseManager::isDumbsterFull(const int id) const {
 
     if (stepCheck == SQLITE_ROW) {
         int val = sqlite3_column_int(stmt, 0);
-        sqlite3_finalize(stmt);
         return val == 1;
     }
     else if (stepCheck == SQLITE_DONE) {
@@ -168,18 +265,24 @@ bool DumbsterDatabaseManager::isDumbsterFull(const int id) const {
     else {
         std::cerr << "Error isDumbsterFull " << sqlite3_errmsg(db) << std::endl;
     }
-    sqlite3_finalize(stmt);
     return false;
 }
 
 DumbsterData DumbsterDatabaseManager::getDumbster(const int id) const {
+    if (cache != nullptr) {
+        std::optional<DumbsterData> cached = cache->find(id);
+        if (!cached) {
+            std::cerr << "Dumbster not found: " << id << std::endl;
+            return DumbsterData();
+        }
+        return *cached;
+    }
     DumbsterData data;
     const char* sqlQuery =
-        "SELECT * FROM dumbster WHERE id = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare(this->db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+        "SELECT id, city, county, street, streetNumber, isFull, useNumber, latitude, longitude FROM dumbster WHERE id = ?;";
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
         std::cerr << "Error preparing getDumbster: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return data;
     }
 
@@ -188,13 +291,7 @@ DumbsterData DumbsterDatabaseManager::getDumbster(const int id) const {
     int stepCheck = sqlite3_step(stmt);
 
     if (stepCheck == SQLITE_ROW) {
-        data.id = sqlite3_column_int(stmt, 0);
-        data.city = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        data.county = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        data.street = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        data.streetNumber = sqlite3_column_int(stmt, 4);
-        data.isFull = sqlite3_column_int(stmt, 5) == 1;
-        data.useNumber = sqlite3_column_int(stmt, 6);
+        data = DumbsterRow{stmt}.toData();
     }
     else if (stepCheck == SQLITE_DONE) {
         std::cerr << "Dumbster not found: " << id << std::endl;
@@ -202,114 +299,307 @@ DumbsterData DumbsterDatabaseManager::getDumbster(const int id) const {
     else {
         std::cerr << "Error getting dumbster " << sqlite3_errmsg(db) << std::endl;
     }
-    sqlite3_finalize(stmt);
     return data;
 }
 
-std::vector<DumbsterData> DumbsterDatabaseManager::getDumbstersCity(const std::string& city) const {
-    std::vector<DumbsterData> data;
-    DumbsterData temp;
-    const char* sqlQuery =
-        "SELECT * FROM dumbster WHERE city = ? ORDER BY street;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare(this->db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Error preparing getDumbstersCity: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
-        return data;
+Cursor<DumbsterRow> DumbsterDatabaseManager::streamDumbsters(const char* sqlQuery, const std::string& key) const {
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing dumbster listing: " << sqlite3_errmsg(db) << std::endl;
+        return {};
     }
+    sqlite3_bind_text(stmt, 1, key.c_str(), static_cast<int>(key.size()), SQLITE_TRANSIENT);
+    return Cursor<DumbsterRow>(std::move(stmt));
+}
 
-    sqlite3_bind_text(stmt, 1, city.c_str(), -1, SQLITE_TRANSIENT);
+Cursor<DumbsterRow> DumbsterDatabaseManager::streamDumbstersCity(const std::string& city) const {
+    return streamDumbsters(
+        "SELECT id, city, county, street, streetNumber, isFull, useNumber, latitude, longitude FROM dumbster WHERE city = ? ORDER BY street;",
+        city);
+}
 
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        temp.id = sqlite3_column_int(stmt, 0);
-        temp.city = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        temp.county = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        temp.street = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        temp.streetNumber = sqlite3_column_int(stmt, 4);
-        temp.isFull = sqlite3_column_int(stmt, 5) == 1;
-        temp.useNumber = sqlite3_column_int(stmt, 6);
-        data.push_back(temp);
-    }
-    sqlite3_finalize(stmt);
-    return data;
+Cursor<DumbsterRow> DumbsterDatabaseManager::streamDumbstersCounty(const std::string& county) const {
+    return streamDumbsters(
+        "SELECT id, city, county, street, streetNumber, isFull, useNumber, latitude, longitude FROM dumbster WHERE county = ? ORDER BY city;",
+        county);
 }
 
-std::vector<DumbsterData> DumbsterDatabaseManager::getDumbstersStreet(const std::string& street) const {
+Cursor<DumbsterRow> DumbsterDatabaseManager::streamDumbstersStreet(const std::string& street) const {
+    return streamDumbsters(
+        "SELECT id, city, county, street, streetNumber, isFull, useNumber, latitude, longitude FROM dumbster WHERE street = ? ORDER BY streetNumber;",
+        street);
+}
+
+std::vector<DumbsterData> DumbsterDatabaseManager::getDumbstersCity(const std::string& city) const {
+    if (cache != nullptr) {
+        return cache->listCity(city);
+    }
     std::vector<DumbsterData> data;
-    DumbsterData temp;
-    const char* sqlQuery =
-        "SELECT * FROM dumbster WHERE street = ? ORDER BY streetNumber;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare(this->db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Error preparing getDumbstersStreet: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
-        return data;
+    for (const DumbsterRow& row : streamDumbstersCity(city)) {
+        data.push_back(row.toData());
     }
+    return data;
+}
 
-    sqlite3_bind_text(stmt, 1, street.c_str(), -1, SQLITE_TRANSIENT);
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        temp.id = sqlite3_column_int(stmt, 0);
-        temp.city = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        temp.county = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        temp.street = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        temp.streetNumber = sqlite3_column_int(stmt, 4);
-        temp.isFull = sqlite3_column_int(stmt, 5) == 1;
-        temp.useNumber = sqlite3_column_int(stmt, 6);
-        data.push_back(temp);
+std::vector<DumbsterData> DumbsterDatabaseManager::getDumbstersStreet(const std::string& street) const {
+    if (cache != nullptr) {
+        return cache->listStreet(street);
+    }
+    std::vector<DumbsterData> data;
+    for (const DumbsterRow& row : streamDumbstersStreet(street)) {
+        data.push_back(row.toData());
     }
-    sqlite3_finalize(stmt);
     return data;
 }
 
 std::vector<DumbsterData> DumbsterDatabaseManager::getDumbstersCounty(const std::string& county) const {
-    std::vector<DumbsterData> data;
-    DumbsterData temp;
-    const char* sqlQuery =
-        "SELECT * FROM dumbster WHERE county = ? ORDER BY city;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare(this->db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
-        std::cerr << "Error preparing getDumbstersCounty: " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
-        return data;
+    if (cache != nullptr) {
+        return cache->listCounty(county);
     }
-
-    sqlite3_bind_text(stmt, 1, county.c_str(), -1, SQLITE_TRANSIENT);
-
-    while (sqlite3_step(stmt) == SQLITE_ROW) {
-        temp.id = sqlite3_column_int(stmt, 0);
-        temp.city = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 1));
-        temp.county = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2));
-        temp.street = reinterpret_cast<const char*>(sqlite3_column_text(stmt, 3));
-        temp.streetNumber = sqlite3_column_int(stmt, 4);
-        temp.isFull = sqlite3_column_int(stmt, 5) == 1;
-        temp.useNumber = sqlite3_column_int(stmt, 6);
-        data.push_back(temp);
+    std::vector<DumbsterData> data;
+    for (const DumbsterRow& row : streamDumbstersCounty(county)) {
+        data.push_back(row.toData());
     }
-    sqlite3_finalize(stmt);
     return data;
 }
 
 bool DumbsterDatabaseManager::updateDumbsterFull(int id, const bool isFull) const {
     const char* sqlQuery = "UPDATE dumbster SET isFull = ? WHERE id = ?;";
-    sqlite3_stmt *stmt = nullptr;
-    if (sqlite3_prepare_v2(db, sqlQuery, -1, &stmt, nullptr) != SQLITE_OK) {
+    std::lock_guard lock(writeMutex);
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
         std::cerr << "Error preparing updateDumbster " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
 
-    sqlite3_bind_int(stmt, 1, id);
-    sqlite3_bind_int(stmt, 2, isFull);
+    sqlite3_bind_int(stmt, 1, isFull);
+    sqlite3_bind_int(stmt, 2, id);
 
     int stepVal = sqlite3_step(stmt);
     bool success = stepVal == SQLITE_DONE;
     if (!success) {
         std::cerr << "Error updating dumbster " << sqlite3_errmsg(db) << std::endl;
-        sqlite3_finalize(stmt);
         return false;
     }
-    sqlite3_finalize(stmt);
+    if (cache != nullptr) {
+        cache->setFull(id, isFull);
+    }
+    if (geoIndex != nullptr) {
+        geoIndex->setFull(id, isFull);
+    }
     std::cout << "Updated dumbsterFull " << std::endl;
     return true;
 }
+
+bool DumbsterDatabaseManager::execSQL(const char* sql) const {
+    char* errMsg = nullptr;
+    if (sqlite3_exec(db, sql, nullptr, nullptr, &errMsg) != SQLITE_OK) {
+        std::cerr << "Error executing " << sql << " " << errMsg << std::endl;
+        sqlite3_free(errMsg);
+        return false;
+    }
+    return true;
+}
+
+bool DumbsterDatabaseManager::updateDumbstersFull(std::span<const DumbsterFullUpdate> updates, const bool oneTransaction) const {
+    if (updates.empty()) {
+        return true;
+    }
+    const char* sqlQuery = "UPDATE dumbster SET isFull = ? WHERE id = ?;";
+    std::lock_guard lock(writeMutex);
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing updateDumbstersFull " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+
+    const std::size_t step = batchSize > 0 && !oneTransaction ? batchSize : updates.size();
+    for (std::size_t offset = 0; offset < updates.size(); offset += step) {
+        if (!execSQL("BEGIN IMMEDIATE;")) {
+            return false;
+        }
+        const std::size_t end = std::min(offset + step, updates.size());
+        for (std::size_t i = offset; i < end; i++) {
+            sqlite3_bind_int(stmt, 1, updates[i].isFull);
+            sqlite3_bind_int(stmt, 2, updates[i].id);
+            int stepVal = sqlite3_step(stmt);
+            sqlite3_reset(stmt);
+            if (stepVal != SQLITE_DONE) {
+                std::cerr << "Error updating dumbsters " << sqlite3_errmsg(db) << std::endl;
+                execSQL("ROLLBACK;");
+                return false;
+            }
+        }
+        if (!execSQL("COMMIT;")) {
+            return false;
+        }
+        for (std::size_t i = offset; i < end; i++) {
+            if (cache != nullptr) cache->setFull(updates[i].id, updates[i].isFull);
+            if (geoIndex != nullptr) geoIndex->setFull(updates[i].id, updates[i].isFull);
+        }
+    }
+    return true;
+}
+
+void DumbsterDatabaseManager::setBatchSize(const std::size_t size) {
+    batchSize = size;
+}
+
+bool DumbsterDatabaseManager::attachCache(DumbsterCache* cache) {
+    this->cache = nullptr;
+    if (cache == nullptr) {
+        return true;
+    }
+    const char* sqlQuery = "SELECT id, city, county, street, streetNumber, isFull, useNumber, latitude, longitude FROM dumbster;";
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing attachCache " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    std::vector<DumbsterData> rows;
+    int stepVal;
+    while ((stepVal = sqlite3_step(stmt)) == SQLITE_ROW) {
+        rows.push_back(DumbsterRow{stmt}.toData());
+    }
+    if (stepVal != SQLITE_DONE) {
+        std::cerr << "Error loading dumbster cache " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    cache->assign(std::move(rows));
+    this->cache = cache;
+    return true;
+}
+
+bool DumbsterDatabaseManager::attachGeoIndex(DumbsterGeoIndex* index) {
+    geoIndex = nullptr;
+    if (index == nullptr) {
+        return true;
+    }
+    std::vector<DumbsterLocation> locations;
+    if (!readLocations(locations)) {
+        return false;
+    }
+    index->assign(locations);
+    geoIndex = index;
+    return true;
+}
+
+bool DumbsterDatabaseManager::readLocations(std::vector<DumbsterLocation>& locations) const {
+    const char* sqlQuery =
+        "SELECT id, latitude, longitude, isFull FROM dumbster WHERE latitude IS NOT NULL AND longitude IS NOT NULL;";
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing dumbster locations " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    int stepVal;
+    while ((stepVal = sqlite3_step(stmt)) == SQLITE_ROW) {
+        locations.push_back({sqlite3_column_int(stmt, 0),
+                             {sqlite3_column_double(stmt, 1), sqlite3_column_double(stmt, 2)},
+                             sqlite3_column_int(stmt, 3) == 1});
+    }
+    if (stepVal != SQLITE_DONE) {
+        std::cerr << "Error reading dumbster locations " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    return true;
+}
+
+std::vector<GeoMatch> DumbsterDatabaseManager::getDumbstersNearest(const GeoPoint& point, const std::size_t k, const FullFilter filter) const {
+    if (geoIndex != nullptr) {
+        return geoIndex->nearest(point, k, filter);
+    }
+    // Without an attached index, load the located dumpsters into a throwaway
+    // one; building it is a single pass, like a scan.
+    std::vector<DumbsterLocation> locations;
+    readLocations(locations);
+    DumbsterGeoIndex scan;
+    scan.assign(locations);
+    return scan.nearest(point, k, filter);
+}
+
+std::vector<GeoMatch> DumbsterDatabaseManager::getDumbstersWithin(const GeoPoint& point, const double radiusMeters, const FullFilter filter) const {
+    if (geoIndex != nullptr) {
+        return geoIndex->within(point, radiusMeters, filter);
+    }
+    std::vector<DumbsterLocation> locations;
+    readLocations(locations);
+    DumbsterGeoIndex scan;
+    scan.assign(locations);
+    return scan.within(point, radiusMeters, filter);
+}
+
+std::vector<DumbsterLocation> DumbsterDatabaseManager::getDumbsterLocations(const FullFilter filter) const {
+    std::vector<DumbsterLocation> locations;
+    readLocations(locations);
+    if (filter != FullFilter::Any) {
+        const bool isFull = filter == FullFilter::Full;
+        std::erase_if(locations, [&](const DumbsterLocation& location) { return location.isFull != isFull; });
+    }
+    return locations;
+}
+
+bool DumbsterDatabaseManager::saveFillSeries(std::span<const FillBucket> buckets) const {
+    if (buckets.empty()) {
+        return true;
+    }
+    const char* sqlQuery =
+        "INSERT OR REPLACE INTO fill_history (dumbsterId, bucketStart, minimum, maximum, mean, samples) "
+        "VALUES (?, ?, ?, ?, ?, ?);";
+    std::lock_guard lock(writeMutex);
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing saveFillSeries " << sqlite3_errmsg(db) << std::endl;
+        return false;
+    }
+    if (!execSQL("BEGIN IMMEDIATE;")) {
+        return false;
+    }
+    for (const FillBucket& bucket : buckets) {
+        sqlite3_bind_int(stmt, 1, bucket.dumbsterId);
+        sqlite3_bind_int64(stmt, 2, bucket.start);
+        sqlite3_bind_double(stmt, 3, bucket.minimum);
+        sqlite3_bind_double(stmt, 4, bucket.maximum);
+        sqlite3_bind_double(stmt, 5, bucket.mean);
+        sqlite3_bind_int64(stmt, 6, bucket.samples);
+        int stepVal = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        if (stepVal != SQLITE_DONE) {
+            std::cerr << "Error saving fill history " << sqlite3_errmsg(db) << std::endl;
+            execSQL("ROLLBACK;");
+            return false;
+        }
+    }
+    return execSQL("COMMIT;");
+}
+
+std::vector<FillBucket> DumbsterDatabaseManager::getFillSeries(const int id, const std::int64_t from, const std::int64_t to) const {
+    std::vector<FillBucket> buckets;
+    const char* sqlQuery =
+        "SELECT bucketStart, minimum, maximum, mean, samples FROM fill_history "
+        "WHERE dumbsterId = ? AND bucketStart >= ? AND bucketStart < ? ORDER BY bucketStart;";
+    Statement stmt = statements.acquire(sqlQuery);
+    if (!stmt) {
+        std::cerr << "Error preparing getFillSeries " << sqlite3_errmsg(db) << std::endl;
+        return buckets;
+    }
+    sqlite3_bind_int(stmt, 1, id);
+    sqlite3_bind_int64(stmt, 2, from);
+    sqlite3_bind_int64(stmt, 3, to);
+    int stepVal;
+    while ((stepVal = sqlite3_step(stmt)) == SQLITE_ROW) {
+        buckets.push_back({id, sqlite3_column_int64(stmt, 0),
+                           static_cast<float>(sqlite3_column_double(stmt, 1)),
+                           static_cast<float>(sqlite3_column_double(stmt, 2)),
+                           static_cast<float>(sqlite3_column_double(stmt, 3)),
+                           static_cast<std::uint32_t>(sqlite3_column_int64(stmt, 4))});
+    }
+    if (stepVal != SQLITE_DONE) {
+        std::cerr << "Error reading fill history " << sqlite3_errmsg(db) << std::endl;
+    }
+    return buckets;
+}
+
+StatementCacheStats DumbsterDatabaseManager::statementCacheStats() const {
+    return statements.stats();
+}
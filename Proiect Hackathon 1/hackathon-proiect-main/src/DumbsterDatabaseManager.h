@@ -1,6 +1,16 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
 #include "sqlite3.h"
+#include "Cursor.h"
+#include "DumbsterGeoIndex.h"
+#include "GeoPoint.h"
+#include "StatementCache.h"
+#include <string_view>
 #include <vector>
 
 struct DumbsterData {
@@ -11,6 +21,7 @@ struct DumbsterData {
     int streetNumber;
     bool isFull;
     int useNumber;
+    std::optional<GeoPoint> location;
     DumbsterData() {
         id = 0;
         city = "";
@@ -30,9 +41,68 @@ struct DumbsterData {
     }
 };
 
+// View of the current row of a dumpster cursor; the string views stay valid
+// until the cursor advances. toData() copies the row out.
+struct DumbsterRow {
+    sqlite3_stmt* stmt;
+
+    int id() const { return sqlite3_column_int(stmt, 0); }
+    std::string_view city() const { return columnText(stmt, 1); }
+    std::string_view county() const { return columnText(stmt, 2); }
+    std::string_view street() const { return columnText(stmt, 3); }
+    int streetNumber() const { return sqlite3_column_int(stmt, 4); }
+    bool isFull() const { return sqlite3_column_int(stmt, 5) == 1; }
+    int useNumber() const { return sqlite3_column_int(stmt, 6); }
+    std::optional<GeoPoint> location() const {
+        if (sqlite3_column_type(stmt, 7) == SQLITE_NULL || sqlite3_column_type(stmt, 8) == SQLITE_NULL) {
+            return std::nullopt;
+        }
+        return GeoPoint{sqlite3_column_double(stmt, 7), sqlite3_column_double(stmt, 8)};
+    }
+
+    DumbsterData toData() const {
+        DumbsterData data(std::string(city()), std::string(county()), std::string(street()), streetNumber());
+        data.id = id();
+        data.isFull = isFull();
+        data.useNumber = useNumber();
+        data.location = location();
+        return data;
+    }
+};
+
+struct DumbsterFullUpdate {
+    int id;
+    bool isFull;
+};
+
+// Fullness of one dumpster over [start, start + bucket length), downsampled
+// from `samples` readings.
+struct FillBucket {
+    int dumbsterId;
+    std::int64_t start;  // unix seconds
+    float minimum;
+    float maximum;
+    float mean;
+    std::uint32_t samples;
+};
+
+class DumbsterCache;
+
 class DumbsterDatabaseManager {
     sqlite3* db;
     std::string dbName;
+    mutable StatementCache statements;
+    std::size_t batchSize = 256;
+    DumbsterCache* cache = nullptr;
+    DumbsterGeoIndex* geoIndex = nullptr;
+    // Dumpsters, the fullness tracker, the ingest writer and fill history share
+    // one manager from different threads. Every write takes this, so a batch's
+    // transaction never takes in (or rolls back) another thread's statement.
+    mutable std::mutex writeMutex;
+
+    bool execSQL(const char* sql) const;
+    Cursor<DumbsterRow> streamDumbsters(const char* sqlQuery, const std::string& key) const;
+    bool readLocations(std::vector<DumbsterLocation>& locations) const;
 public:
     explicit DumbsterDatabaseManager(const std::string& dbName);
     ~DumbsterDatabaseManager();
@@ -41,16 +111,51 @@ public:
     bool closeDB() const;
     bool setupDB() const;
 
-    bool newDumbster(const std::string& city, const std::string& county, const std::string& street, int streetNumber) const;
+    bool newDumbster(const std::string& city, const std::string& county, const std::string& street, int streetNumber,
+                     const std::optional<GeoPoint>& location = std::nullopt) const;
     bool deleteDumbster(int id) const;
     bool updateDumbster(int id, const std::string& city, const std::string& county, const std::string& street, int streetNumber) const;
+    bool setDumbsterLocation(int id, const GeoPoint& location) const;
 
     bool isDumbsterFull(int id) const;
     bool updateDumbsterFull(int id, bool isFull) const;
+    // Commits in transactions of at most batchSize updates, or all of them in
+    // one with oneTransaction, so they land together or not at all.
+    bool updateDumbstersFull(std::span<const DumbsterFullUpdate> updates, bool oneTransaction = false) const;
+    void setBatchSize(std::size_t size);
+
+    // Loads the whole table into `cache` and keeps it in step with every write
+    // made through this manager; getDumbster, isDumbsterFull and the
+    // getDumbsters* listings are then served from memory (the stream* cursors
+    // still read SQLite). One cache can be attached to several managers.
+    bool attachCache(DumbsterCache* cache);
+    // Loads every located dumpster into `index` and keeps it in step with
+    // writes made through this manager; the nearest/within queries below are
+    // then answered from the index instead of a table scan.
+    bool attachGeoIndex(DumbsterGeoIndex* index);
 
     DumbsterData getDumbster(int id) const;
     std::vector<DumbsterData> getDumbstersCity(const std::string& city) const;
     std::vector<DumbsterData> getDumbstersCounty(const std::string& county) const;
     std::vector<DumbsterData> getDumbstersStreet(const std::string& street) const;
 
-};
+    // Streaming variants of the listings above: rows are read lazily, in the
+    // same order, without materializing the result.
+    Cursor<DumbsterRow> streamDumbstersCity(const std::string& city) const;
+    Cursor<DumbsterRow> streamDumbstersCounty(const std::string& county) const;
+    Cursor<DumbsterRow> streamDumbstersStreet(const std::string& street) const;
+
+    // Dumpsters with a location, closest first. `filter` restricts the
+    // search to full or not-full dumpsters.
+    std::vector<GeoMatch> getDumbstersNearest(const GeoPoint& point, std::size_t k, FullFilter filter = FullFilter::Any) const;
+    std::vector<GeoMatch> getDumbstersWithin(const GeoPoint& point, double radiusMeters, FullFilter filter = FullFilter::Any) const;
+    // Every dumpster that has a location, read from SQLite.
+    std::vector<DumbsterLocation> getDumbsterLocations(FullFilter filter = FullFilter::Any) const;
+
+    // Writes (or overwrites) fill-history buckets in one transaction.
+    bool saveFillSeries(std::span<const FillBucket> buckets) const;
+    // Buckets of one dumpster starting in [from, to), oldest first.
+    std::vector<FillBucket> getFillSeries(int id, std::int64_t from, std::int64_t to) const;
+
+    StatementCacheStats statementCacheStats() const;
+};
\ No newline at end of file
@@ -0,0 +1,198 @@
+#pragma once
+#include "DumbsterEventBus.h"
+#include <algorithm>
+
+DumbsterEventQueue::DumbsterEventQueue(const std::size_t capacity, const DumbsterEventMask mask)
+    : buffer(capacity), mask(mask) {}
+
+void DumbsterEventQueue::push(const DumbsterEvent& event) {
+    if ((mask & static_cast<DumbsterEventMask>(event.type)) == 0) return;
+    DumbsterEvent copy = event;
+    if (buffer.tryPush(std::move(copy))) {
+        delivered.fetch_add(1, std::memory_order_relaxed);
+    }
+    else {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool DumbsterEventQueue::poll(DumbsterEvent& event) {
+    return buffer.tryPop(event);
+}
+
+std::size_t DumbsterEventQueue::drain(std::vector<DumbsterEvent>& events, const std::size_t max) {
+    std::size_t count = 0;
+    DumbsterEvent event;
+    while (count < max && buffer.tryPop(event)) {
+        events.push_back(event);
+        count++;
+    }
+    return count;
+}
+
+DumbsterEventQueueStats DumbsterEventQueue::stats() const {
+    return {delivered.load(std::memory_order_relaxed), dropped.load(std::memory_order_relaxed), buffer.size()};
+}
+
+DumbsterEventBus::DumbsterEventBus(const DumbsterEventBusConfig config) : config(config) {}
+
+DumbsterEventBus::~DumbsterEventBus() {
+    detach();
+}
+
+void DumbsterEventBus::attach(MonitorScheduler& scheduler) {
+    detach();
+    this->scheduler = &scheduler;
+    const auto silencePeriod = std::max<MonitorScheduler::Clock::duration>(config.silenceTimeout / 4, scheduler.tickDuration());
+    silenceTask = scheduler.schedule(silencePeriod, [this] { checkSilence(); });
+    dispatchTask = scheduler.schedule(scheduler.tickDuration(), [this] { dispatch(); });
+}
+
+void DumbsterEventBus::detach() {
+    if (scheduler != nullptr) {
+        scheduler->cancel(silenceTask);
+        scheduler->cancel(dispatchTask);
+        scheduler = nullptr;
+        silenceTask = MonitorScheduler::InvalidTask;
+        dispatchTask = MonitorScheduler::InvalidTask;
+    }
+}
+
+DumbsterEventBus::SubscriptionId DumbsterEventBus::add(std::shared_ptr<DumbsterEventQueue> queue, Callback callback) {
+    std::unique_lock lock(subscribersMutex);
+    const SubscriptionId id = nextId++;
+    subscribers.push_back({id, std::move(queue), std::move(callback)});
+    return id;
+}
+
+DumbsterEventBus::SubscriptionId DumbsterEventBus::subscribe(Callback callback, const DumbsterEventMask mask) {
+    return add(std::make_shared<DumbsterEventQueue>(config.bufferSize, mask), std::move(callback));
+}
+
+std::shared_ptr<DumbsterEventQueue> DumbsterEventBus::subscribeQueue(const DumbsterEventMask mask, SubscriptionId* id) {
+    auto queue = std::make_shared<DumbsterEventQueue>(config.bufferSize, mask);
+    const SubscriptionId added = add(queue, nullptr);
+    if (id != nullptr) *id = added;
+    return queue;
+}
+
+bool DumbsterEventBus::unsubscribe(const SubscriptionId id) {
+    bool isCallback = false;
+    {
+        std::unique_lock lock(subscribersMutex);
+        auto it = std::find_if(subscribers.begin(), subscribers.end(), [&](const Subscriber& s) { return s.id == id; });
+        if (it == subscribers.end()) return false;
+        const DumbsterEventQueueStats queueStats = it->queue->stats();
+        retiredDelivered += queueStats.delivered;
+        retiredDropped += queueStats.dropped;
+        isCallback = static_cast<bool>(it->callback);
+        subscribers.erase(it);
+    }
+    if (isCallback && dispatchingThread.load() != std::this_thread::get_id()) {
+        // Wait for a dispatch that may still hold the callback.
+        std::unique_lock wait(dispatchMutex);
+    }
+    return true;
+}
+
+void DumbsterEventBus::publish(const DumbsterEvent& event) {
+    std::shared_lock lock(subscribersMutex);
+    for (const Subscriber& subscriber : subscribers) {
+        subscriber.queue->push(event);
+    }
+}
+
+void DumbsterEventBus::report(const int id, const bool isFull, const float fullness) {
+    if (id < 0) return;
+    const auto now = MonitorScheduler::Clock::now();
+    bool changed = false;
+    {
+        std::unique_lock lock(mutex);
+        reports++;
+        const auto index = static_cast<std::size_t>(id);
+        if (index >= states.size()) states.resize(index + 1);
+        State& state = states[index];
+        changed = state.known && state.isFull != isFull;
+        if (changed) published++;
+        state.known = true;
+        state.isFull = isFull;
+        state.silent = false;
+        state.fullness = fullness;
+        state.lastSeen = now;
+    }
+    if (changed) {
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+        publish({id, isFull ? DumbsterEventType::BecameFull : DumbsterEventType::Emptied, fullness, seconds.count()});
+    }
+}
+
+void DumbsterEventBus::forget(const int id) {
+    std::unique_lock lock(mutex);
+    if (id >= 0 && static_cast<std::size_t>(id) < states.size()) {
+        states[id] = State();
+    }
+}
+
+std::size_t DumbsterEventBus::checkSilence() {
+    const auto now = MonitorScheduler::Clock::now();
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch());
+    std::vector<DumbsterEvent> events;
+    {
+        std::unique_lock lock(mutex);
+        for (std::size_t id = 0; id < states.size(); id++) {
+            State& state = states[id];
+            if (state.known && !state.silent && now - state.lastSeen >= config.silenceTimeout) {
+                state.silent = true;
+                events.push_back({static_cast<int>(id), DumbsterEventType::SensorSilent, state.fullness, seconds.count()});
+            }
+        }
+        published += events.size();
+    }
+    for (const DumbsterEvent& event : events) {
+        publish(event);
+    }
+    return events.size();
+}
+
+std::size_t DumbsterEventBus::dispatch() {
+    std::unique_lock dispatchLock(dispatchMutex);
+    dispatchingThread.store(std::this_thread::get_id());
+    std::vector<Subscriber> targets;
+    {
+        std::shared_lock lock(subscribersMutex);
+        for (const Subscriber& subscriber : subscribers) {
+            if (subscriber.callback) targets.push_back(subscriber);
+        }
+    }
+    std::size_t count = 0;
+    DumbsterEvent event;
+    for (Subscriber& subscriber : targets) {
+        // Bounded by what is buffered now, so a busy publisher cannot keep one
+        // subscriber's loop going forever.
+        for (std::size_t pending = subscriber.queue->stats().pending; pending > 0 && subscriber.queue->poll(event); pending--) {
+            subscriber.callback(event);
+            count++;
+        }
+    }
+    dispatchingThread.store(std::thread::id());
+    return count;
+}
+
+DumbsterEventBusStats DumbsterEventBus::stats() const {
+    DumbsterEventBusStats result{};
+    {
+        std::unique_lock lock(mutex);
+        result.reports = reports;
+        result.published = published;
+    }
+    std::shared_lock lock(subscribersMutex);
+    result.delivered = retiredDelivered;
+    result.dropped = retiredDropped;
+    for (const Subscriber& subscriber : subscribers) {
+        const DumbsterEventQueueStats queueStats = subscriber.queue->stats();
+        result.delivered += queueStats.delivered;
+        result.dropped += queueStats.dropped;
+    }
+    result.subscribers = subscribers.size();
+    return result;
+}
@@ -0,0 +1,157 @@
+#pragma once
+#include "MonitorScheduler.h"
+#include "MpscRingBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <vector>
+
+enum class DumbsterEventType : std::uint8_t {
+    BecameFull = 1,
+    Emptied = 2,
+    SensorSilent = 4
+};
+
+// Bitwise OR of DumbsterEventType values a subscriber wants.
+using DumbsterEventMask = std::uint8_t;
+constexpr DumbsterEventMask AllDumbsterEvents = 1 | 2 | 4;
+
+struct DumbsterEvent {
+    int id;
+    DumbsterEventType type;
+    float fullness;          // latest reading
+    std::int64_t timestamp;  // unix seconds
+};
+
+struct DumbsterEventQueueStats {
+    std::uint64_t delivered;
+    std::uint64_t dropped;   // events that found the buffer full
+    std::size_t pending;
+};
+
+// Pull end of a subscription: a bounded lock-free buffer the bus pushes into
+// and the subscriber drains from one thread. When it is full, new events are
+// dropped and counted rather than blocking the publisher.
+class DumbsterEventQueue {
+    MpscRingBuffer<DumbsterEvent> buffer;
+    DumbsterEventMask mask;
+    std::atomic<std::uint64_t> delivered{0};
+    std::atomic<std::uint64_t> dropped{0};
+
+    friend class DumbsterEventBus;
+    void push(const DumbsterEvent& event);
+public:
+    DumbsterEventQueue(std::size_t capacity, DumbsterEventMask mask);
+
+    bool poll(DumbsterEvent& event);
+    // Appends up to `max` pending events to `events`; returns how many.
+    std::size_t drain(std::vector<DumbsterEvent>& events, std::size_t max = SIZE_MAX);
+
+    DumbsterEventQueueStats stats() const;
+};
+
+struct DumbsterEventBusConfig {
+    std::chrono::milliseconds silenceTimeout{30000};  // no sample for this long is SensorSilent
+    std::size_t bufferSize = 1024;                    // per subscriber
+};
+
+struct DumbsterEventBusStats {
+    std::uint64_t reports;
+    std::uint64_t published;  // events, before fan-out
+    std::uint64_t delivered;  // summed over subscribers
+    std::uint64_t dropped;
+    std::size_t subscribers;
+};
+
+// Publishes dumpster state transitions so consumers do not have to poll
+// isDumbsterFull. The monitoring path reports every sample with its full
+// state; the bus remembers the last state per dumpster and publishes
+// BecameFull / Emptied when it changes, and SensorSilent once when a
+// dumpster has not reported for silenceTimeout (checked on the scheduler).
+//
+// Publishing never runs subscriber code: each event is pushed into every
+// interested subscriber's bounded buffer. Queue subscribers poll theirs;
+// callback subscribers are called from dispatch(), which runs every
+// scheduler tick once the bus is attached, one subscriber after another and
+// in publication order.
+class DumbsterEventBus {
+public:
+    using SubscriptionId = std::uint64_t;
+    using Callback = std::function<void(const DumbsterEvent&)>;
+private:
+    struct Subscriber {
+        SubscriptionId id;
+        std::shared_ptr<DumbsterEventQueue> queue;
+        Callback callback;  // empty for queue subscribers
+    };
+
+    struct State {
+        bool known = false;
+        bool isFull = false;
+        bool silent = false;
+        float fullness = 0.0f;
+        MonitorScheduler::Clock::time_point lastSeen;
+    };
+
+    DumbsterEventBusConfig config;
+
+    mutable std::mutex mutex;
+    std::vector<State> states;  // by dumpster id
+    std::uint64_t reports = 0;
+    std::uint64_t published = 0;
+
+    mutable std::shared_mutex subscribersMutex;
+    std::vector<Subscriber> subscribers;
+    SubscriptionId nextId = 1;
+    std::uint64_t retiredDelivered = 0;  // counters of unsubscribed queues
+    std::uint64_t retiredDropped = 0;
+
+    std::mutex dispatchMutex;
+    std::atomic<std::thread::id> dispatchingThread{};
+
+    MonitorScheduler* scheduler = nullptr;
+    MonitorScheduler::TaskId silenceTask = MonitorScheduler::InvalidTask;
+    MonitorScheduler::TaskId dispatchTask = MonitorScheduler::InvalidTask;
+
+    void publish(const DumbsterEvent& event);
+    SubscriptionId add(std::shared_ptr<DumbsterEventQueue> queue, Callback callback);
+public:
+    explicit DumbsterEventBus(DumbsterEventBusConfig config = {});
+    ~DumbsterEventBus();
+
+    DumbsterEventBus(const DumbsterEventBus&) = delete;
+    DumbsterEventBus& operator=(const DumbsterEventBus&) = delete;
+
+    // Checks for silent sensors every silenceTimeout / 4 and dispatches
+    // callbacks every scheduler tick.
+    void attach(MonitorScheduler& scheduler);
+    void detach();
+
+    SubscriptionId subscribe(Callback callback, DumbsterEventMask mask = AllDumbsterEvents);
+    // The queue stays usable after unsubscribe, it just receives nothing more.
+    std::shared_ptr<DumbsterEventQueue> subscribeQueue(DumbsterEventMask mask = AllDumbsterEvents,
+                                                       SubscriptionId* id = nullptr);
+    // Once this returns the callback is not running and will not run again,
+    // unless called from that callback.
+    bool unsubscribe(SubscriptionId id);
+
+    // Called from the monitoring path with the state decided for a sample.
+    // The first report of a dumpster sets its state without an event.
+    void report(int id, bool isFull, float fullness);
+    // Stops tracking a dumpster, e.g. when its monitoring stops, so it is not
+    // reported silent.
+    void forget(int id);
+
+    // Publishes SensorSilent for dumpsters quiet for silenceTimeout; returns how many.
+    std::size_t checkSilence();
+    // Runs callback subscribers on their buffered events; returns how many.
+    std::size_t dispatch();
+
+    DumbsterEventBusStats stats() const;
+};
@@ -0,0 +1,235 @@
+#pragma once
+#include "DumbsterGeoIndex.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+
+namespace {
+
+constexpr double MinCellDegrees = 1e-4;  // about 11 m
+constexpr std::size_t DumpstersPerCell = 4;
+
+bool accepts(const FullFilter filter, const bool isFull) {
+    return filter == FullFilter::Any || (filter == FullFilter::Full) == isFull;
+}
+
+bool closer(const GeoMatch& a, const GeoMatch& b) {
+    return a.distance != b.distance ? a.distance < b.distance : a.id < b.id;
+}
+
+int clampCell(const double position, const int limit) {
+    // Written so NaN lands in cell 0.
+    if (!(position >= 0)) return 0;
+    if (position >= limit - 1) return limit - 1;
+    return static_cast<int>(position);
+}
+
+}
+
+int DumbsterGeoIndex::column(const double longitude) const {
+    return clampCell(std::floor((longitude - origin.longitude) / cellLongitude), columns);
+}
+
+int DumbsterGeoIndex::row(const double latitude) const {
+    return clampCell(std::floor((latitude - origin.latitude) / cellLatitude), rows);
+}
+
+int DumbsterGeoIndex::cellIndex(const GeoPoint& point) const {
+    return row(point.latitude) * columns + column(point.longitude);
+}
+
+void DumbsterGeoIndex::layout(const std::vector<DumbsterLocation>& locations) {
+    origin = GeoPoint();
+    cellLatitude = 1;
+    cellLongitude = 1;
+    columns = 1;
+    rows = 1;
+    if (!locations.empty()) {
+        GeoPoint low = locations.front().point;
+        GeoPoint high = low;
+        for (const DumbsterLocation& location : locations) {
+            low.latitude = std::min(low.latitude, location.point.latitude);
+            low.longitude = std::min(low.longitude, location.point.longitude);
+            high.latitude = std::max(high.latitude, location.point.latitude);
+            high.longitude = std::max(high.longitude, location.point.longitude);
+        }
+        const double height = std::max(high.latitude - low.latitude, MinCellDegrees);
+        const double width = std::max(high.longitude - low.longitude, MinCellDegrees);
+        const double widening = 1 / std::max(std::cos((low.latitude + high.latitude) / 2 * DegreesToRadians), 0.01);
+        const std::size_t targetCells = std::max<std::size_t>(1, locations.size() / DumpstersPerCell);
+
+        origin = low;
+        cellLatitude = std::max(std::sqrt(height * width / widening / static_cast<double>(targetCells)), MinCellDegrees);
+        // A degenerate (line-shaped) fleet would otherwise get one cell per MinCellDegrees.
+        while (true) {
+            cellLongitude = cellLatitude * widening;
+            rows = static_cast<int>(height / cellLatitude) + 1;
+            columns = static_cast<int>(width / cellLongitude) + 1;
+            if (static_cast<std::size_t>(rows) * columns <= 4 * targetCells + 1) break;
+            cellLatitude *= 2;
+        }
+    }
+    cells.assign(static_cast<std::size_t>(rows) * columns, {});
+}
+
+void DumbsterGeoIndex::insert(const DumbsterLocation& location) {
+    if (location.id < 0) return;
+    const auto id = static_cast<std::size_t>(location.id);
+    if (id >= cellOf.size()) {
+        cellOf.resize(id + 1, -1);
+    }
+    const int cell = cellIndex(location.point);
+    cells[cell].push_back(location);
+    cellOf[id] = cell;
+    count++;
+}
+
+bool DumbsterGeoIndex::remove(const int id) {
+    if (id < 0 || static_cast<std::size_t>(id) >= cellOf.size() || cellOf[id] < 0) return false;
+    std::vector<DumbsterLocation>& cell = cells[cellOf[id]];
+    for (DumbsterLocation& location : cell) {
+        if (location.id == id) {
+            location = cell.back();
+            cell.pop_back();
+            break;
+        }
+    }
+    cellOf[id] = -1;
+    count--;
+    return true;
+}
+
+void DumbsterGeoIndex::clear() {
+    std::unique_lock lock(mutex);
+    layout({});
+    cellOf.clear();
+    count = 0;
+}
+
+void DumbsterGeoIndex::assign(const std::vector<DumbsterLocation>& locations) {
+    std::unique_lock lock(mutex);
+    layout(locations);
+    cellOf.clear();
+    count = 0;
+    std::vector<std::size_t> sizes(cells.size(), 0);
+    for (const DumbsterLocation& location : locations) {
+        sizes[cellIndex(location.point)]++;
+    }
+    for (std::size_t cell = 0; cell < cells.size(); cell++) {
+        cells[cell].reserve(sizes[cell]);
+    }
+    for (const DumbsterLocation& location : locations) {
+        remove(location.id);
+        insert(location);
+    }
+}
+
+void DumbsterGeoIndex::put(const DumbsterLocation& location) {
+    std::unique_lock lock(mutex);
+    remove(location.id);
+    insert(location);
+}
+
+bool DumbsterGeoIndex::relocate(const int id, const GeoPoint& point) {
+    std::unique_lock lock(mutex);
+    if (id < 0 || static_cast<std::size_t>(id) >= cellOf.size() || cellOf[id] < 0) return false;
+    for (const DumbsterLocation& location : cells[cellOf[id]]) {
+        if (location.id == id) {
+            const bool isFull = location.isFull;
+            remove(id);
+            insert({id, point, isFull});
+            return true;
+        }
+    }
+    return false;
+}
+
+bool DumbsterGeoIndex::erase(const int id) {
+    std::unique_lock lock(mutex);
+    return remove(id);
+}
+
+bool DumbsterGeoIndex::setFull(const int id, const bool isFull) {
+    std::unique_lock lock(mutex);
+    if (id < 0 || static_cast<std::size_t>(id) >= cellOf.size() || cellOf[id] < 0) return false;
+    for (DumbsterLocation& location : cells[cellOf[id]]) {
+        if (location.id == id) {
+            location.isFull = isFull;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::size_t DumbsterGeoIndex::size() const {
+    std::shared_lock lock(mutex);
+    return count;
+}
+
+bool DumbsterGeoIndex::collect(const GeoPoint& center, const double radius, const FullFilter filter,
+                               std::vector<GeoMatch>& matches) const {
+    // Bounding box of the spherical cap, exact at any latitude.
+    const double angle = radius / EarthRadiusMeters;
+    const double latitude = center.latitude * DegreesToRadians;
+    const double halfPi = DegreesToRadians * 90;
+    int firstRow = 0;
+    int lastRow = rows - 1;
+    int firstColumn = 0;
+    int lastColumn = columns - 1;
+    if (latitude - angle > -halfPi && latitude + angle < halfPi) {
+        firstRow = row(center.latitude - angle / DegreesToRadians);
+        lastRow = row(center.latitude + angle / DegreesToRadians);
+        const double spread = std::asin(std::sin(angle) / std::cos(latitude)) / DegreesToRadians;
+        if (center.longitude - spread >= -180 && center.longitude + spread <= 180) {
+            firstColumn = column(center.longitude - spread);
+            lastColumn = column(center.longitude + spread);
+        }
+    }
+    for (int r = firstRow; r <= lastRow; r++) {
+        for (int c = firstColumn; c <= lastColumn; c++) {
+            for (const DumbsterLocation& location : cells[static_cast<std::size_t>(r) * columns + c]) {
+                if (!accepts(filter, location.isFull)) continue;
+                const double distance = distanceMeters(center, location.point);
+                if (distance <= radius) {
+                    matches.push_back({location.id, distance});
+                }
+            }
+        }
+    }
+    return firstRow == 0 && lastRow == rows - 1 && firstColumn == 0 && lastColumn == columns - 1;
+}
+
+std::vector<GeoMatch> DumbsterGeoIndex::nearest(const GeoPoint& center, const std::size_t k, const FullFilter filter) const {
+    std::vector<GeoMatch> matches;
+    if (k == 0) return matches;
+    std::shared_lock lock(mutex);
+    // Grow a radius query until it holds k matches; the k closest of those
+    // are then the k nearest overall.
+    double radius = cellLatitude * DegreesToRadians * EarthRadiusMeters
+                  * std::sqrt(static_cast<double>(std::max(k, DumpstersPerCell)) / DumpstersPerCell);
+    while (true) {
+        matches.clear();
+        const bool covered = collect(center, radius, filter, matches);
+        if (matches.size() >= k) break;
+        if (covered) {
+            // Every cell was visited, so fewer than k dumpsters match at all.
+            matches.clear();
+            collect(center, std::numeric_limits<double>::infinity(), filter, matches);
+            break;
+        }
+        radius *= 2;
+    }
+    const std::size_t size = std::min(k, matches.size());
+    std::partial_sort(matches.begin(), matches.begin() + size, matches.end(), closer);
+    matches.resize(size);
+    return matches;
+}
+
+std::vector<GeoMatch> DumbsterGeoIndex::within(const GeoPoint& center, const double radiusMeters, const FullFilter filter) const {
+    std::vector<GeoMatch> matches;
+    std::shared_lock lock(mutex);
+    collect(center, radiusMeters, filter, matches);
+    std::sort(matches.begin(), matches.end(), closer);
+    return matches;
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include "GeoPoint.h"
+#include <cstddef>
+#include <shared_mutex>
+#include <vector>
+
+enum class FullFilter {
+    Any,
+    Full,
+    NotFull,
+};
+
+struct DumbsterLocation {
+    int id;
+    GeoPoint point;
+    bool isFull;
+};
+
+struct GeoMatch {
+    int id;
+    double distance;  // meters
+};
+
+// Uniform grid over latitude/longitude answering k-nearest and within-radius
+// queries for located dumpsters, optionally restricted to full (or not full)
+// ones. Cells are square on the ground (the longitude step is widened by
+// 1/cos(latitude) at the centre of the fleet) and sized by assign() for about
+// four dumpsters per cell. Distances are great-circle distances.
+//
+// Points added after assign() outside the loaded bounds land in the edge
+// cells: results stay exact but those cells get slower, so reload after the
+// fleet grows elsewhere. DumbsterDatabaseManager::attachGeoIndex loads the
+// index and keeps it in step with writes, like DumbsterCache.
+class DumbsterGeoIndex {
+    mutable std::shared_mutex mutex;
+    GeoPoint origin;  // south-west corner of cell 0
+    double cellLatitude = 1;
+    double cellLongitude = 1;
+    int columns = 1;
+    int rows = 1;
+    std::vector<std::vector<DumbsterLocation>> cells{1};
+    std::vector<int> cellOf;  // by dumpster id, -1 when not indexed
+    std::size_t count = 0;
+
+    int column(double longitude) const;
+    int row(double latitude) const;
+    int cellIndex(const GeoPoint& point) const;
+    void layout(const std::vector<DumbsterLocation>& locations);
+    void insert(const DumbsterLocation& location);
+    bool remove(int id);
+    // Appends every match within `radius` meters; returns true when the
+    // search box already covered the whole grid.
+    bool collect(const GeoPoint& center, double radius, FullFilter filter, std::vector<GeoMatch>& matches) const;
+public:
+    void clear();
+    // Replaces the contents and re-fits the grid to `locations`.
+    void assign(const std::vector<DumbsterLocation>& locations);
+    void put(const DumbsterLocation& location);
+    // Moves an indexed dumpster; false if `id` is not indexed.
+    bool relocate(int id, const GeoPoint& point);
+    bool erase(int id);
+    bool setFull(int id, bool isFull);
+    std::size_t size() const;
+
+    // Results are ordered by distance, then id.
+    std::vector<GeoMatch> nearest(const GeoPoint& center, std::size_t k, FullFilter filter = FullFilter::Any) const;
+    std::vector<GeoMatch> within(const GeoPoint& center, double radiusMeters, FullFilter filter = FullFilter::Any) const;
+};
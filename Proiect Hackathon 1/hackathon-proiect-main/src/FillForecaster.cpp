@@ -0,0 +1,241 @@
+#pragma once
+#include "FillForecaster.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr std::int64_t SecondsPerDay = 86400;
+constexpr double SecondsPerHour = 3600.0;
+constexpr int ForecastHorizonDays = 8 * 7;
+constexpr std::size_t RecomputeChunk = 1024;
+
+// The slope is only trusted once the fit spans some time (variance of the
+// sample clock in hours squared, about a 30-minute spread).
+constexpr double MinTimeVariance = 0.25;
+
+double hoursBetween(const std::int64_t from, const std::int64_t to) {
+    return static_cast<double>(to - from) / SecondsPerHour;
+}
+
+std::size_t historyCapacity(const FillForecasterConfig& config) {
+    const double horizonHours = std::max(config.regressionHalfLifeHours, config.profileHalfLifeHours * 7)
+        * config.historyHalfLives;
+    const double steps = horizonHours * SecondsPerHour / static_cast<double>(std::max<std::int64_t>(config.historyStepSeconds, 1));
+    return static_cast<std::size_t>(std::clamp(std::ceil(steps), 1.0, 1e6));
+}
+
+}
+
+FillForecaster::FillForecaster(const FillForecasterConfig config) : config(config), history(historyCapacity(config)) {
+    this->config.historyStepSeconds = std::max<std::int64_t>(config.historyStepSeconds, 1);
+}
+
+int FillForecaster::weekday(const std::int64_t timestamp) const {
+    const std::int64_t local = timestamp + config.utcOffsetSeconds;
+    std::int64_t days = local / SecondsPerDay;
+    if (local % SecondsPerDay < 0) days--;
+    // 1970-01-01 was a Thursday.
+    return static_cast<int>(((days + 4) % 7 + 7) % 7);
+}
+
+std::array<double, 7> FillForecaster::weekdayFactors(const Model& model) const {
+    std::array<double, 7> factors;
+    factors.fill(1.0);
+    double rise = 0;
+    double hours = 0;
+    for (int day = 0; day < 7; day++) {
+        rise += model.rise[day];
+        hours += model.hours[day];
+    }
+    if (hours <= 0 || rise <= 0) return factors;
+    for (int day = 0; day < 7; day++) {
+        if (model.hours[day] >= config.minWeekdayHours) {
+            factors[day] = std::clamp((model.rise[day] / model.hours[day]) / (rise / hours), 0.0, 10.0);
+        }
+    }
+    return factors;
+}
+
+void FillForecaster::update(Model& model, const FillSample& sample) const {
+    if (!model.started) {
+        model.started = true;
+    }
+    else if (sample.timestamp < model.lastTime) {
+        return;
+    }
+    else if (sample.fullness < model.lastFullness - config.emptyDrop) {
+        // Emptied: start a new fit, keep the weekday profile.
+        model.clock = 0;
+        model.weight = model.sumT = model.sumF = model.sumTT = model.sumTF = 0;
+    }
+    else if (sample.timestamp > model.lastTime) {
+        // Credit the rise to the weekday of the interval's midpoint; the sum
+        // of rises telescopes, so sensor noise cancels out over a day.
+        const double elapsed = hoursBetween(model.lastTime, sample.timestamp);
+        const int day = weekday(model.lastTime + (sample.timestamp - model.lastTime) / 2);
+        model.clock += elapsed * weekdayFactors(model)[day];
+        const double decay = std::exp2(-elapsed / config.profileHalfLifeHours);
+        model.rise[day] = model.rise[day] * decay + (sample.fullness - model.lastFullness);
+        model.hours[day] = model.hours[day] * decay + elapsed;
+
+        const double fade = std::exp2(-elapsed / config.regressionHalfLifeHours);
+        model.weight *= fade;
+        model.sumT *= fade;
+        model.sumF *= fade;
+        model.sumTT *= fade;
+        model.sumTF *= fade;
+    }
+    const double t = model.clock;
+    model.weight += 1;
+    model.sumT += t;
+    model.sumF += sample.fullness;
+    model.sumTT += t * t;
+    model.sumTF += t * sample.fullness;
+    model.lastTime = sample.timestamp;
+    model.lastFullness = sample.fullness;
+}
+
+FillForecast FillForecaster::forecast(const int id, const Model& model, const std::int64_t now) const {
+    FillForecast result{id, model.lastFullness, 0, std::numeric_limits<double>::infinity(),
+                        std::numeric_limits<std::int64_t>::max()};
+    const int today = weekday(now);
+    const std::array<double, 7> factors = weekdayFactors(model);
+
+    double slope = 0;
+    bool fitted = false;
+    if (model.weight > 0) {
+        const double meanT = model.sumT / model.weight;
+        const double meanF = model.sumF / model.weight;
+        const double varianceT = model.sumTT / model.weight - meanT * meanT;
+        if (varianceT > MinTimeVariance) {
+            slope = (model.sumTF / model.weight - meanT * meanF) / varianceT;
+            const double clock = model.clock + std::max(hoursBetween(model.lastTime, now), 0.0) * factors[today];
+            result.level = static_cast<float>(meanF + slope * (clock - meanT));
+            fitted = true;
+        }
+    }
+    result.level = std::clamp(result.level, 0.0f, 100.0f);
+
+    // Rate per seasonal hour; without a usable fit, the profile's overall rate.
+    double baseRate = 0;
+    if (fitted) {
+        baseRate = slope;
+    }
+    else {
+        double rise = 0;
+        double hours = 0;
+        for (int d = 0; d < 7; d++) {
+            rise += model.rise[d];
+            hours += model.hours[d];
+        }
+        baseRate = hours > 0 ? rise / hours : 0;
+    }
+    result.rate = baseRate * factors[today];
+
+    if (result.level >= config.fullThreshold) {
+        result.hoursToFull = 0;
+        result.fullAt = now;
+        return result;
+    }
+    if (baseRate <= 0) return result;
+
+    double remaining = config.fullThreshold - result.level;
+    double hours = 0;
+    std::int64_t cursor = now;
+    int day = today;
+    for (int step = 0; step < ForecastHorizonDays; step++, day = (day + 1) % 7) {
+        const std::int64_t local = cursor + config.utcOffsetSeconds;
+        const std::int64_t intoDay = ((local % SecondsPerDay) + SecondsPerDay) % SecondsPerDay;
+        const double dayLeft = static_cast<double>(SecondsPerDay - intoDay) / SecondsPerHour;
+        const double rate = baseRate * factors[day];
+        if (rate > 0 && rate * dayLeft >= remaining) {
+            hours += remaining / rate;
+            result.hoursToFull = hours;
+            result.fullAt = now + static_cast<std::int64_t>(hours * SecondsPerHour);
+            return result;
+        }
+        remaining -= std::max(rate, 0.0) * dayLeft;
+        hours += dayLeft;
+        cursor += SecondsPerDay - intoDay;
+    }
+    return result;
+}
+
+void FillForecaster::observe(const int id, const std::int64_t timestamp, const float fullness) {
+    if (id < 0) return;
+    std::unique_lock lock(mutex);
+    const auto index = static_cast<std::size_t>(id);
+    if (index >= models.size()) {
+        models.resize(index + 1);
+    }
+    const FillSample sample{timestamp, fullness};
+    // Downsample: one kept sample, the latest, per history step.
+    if (history.size(id) == 0) {
+        history.push(id, sample);
+    }
+    else if (const std::int64_t newest = history.newest(id).timestamp; timestamp >= newest) {
+        if (timestamp / config.historyStepSeconds == newest / config.historyStepSeconds) history.replaceNewest(id, sample);
+        else history.push(id, sample);
+    }
+    Model& model = models[index];
+    update(model, sample);
+    model.forecast = forecast(id, model, timestamp);
+}
+
+void FillForecaster::recompute(const std::int64_t now) {
+    std::unique_lock lock(mutex);
+    const std::size_t chunks = (models.size() + RecomputeChunk - 1) / RecomputeChunk;
+    parallelFor(chunks, config.threads, [&](const std::size_t chunk) {
+        const std::size_t end = std::min(models.size(), (chunk + 1) * RecomputeChunk);
+        for (std::size_t id = chunk * RecomputeChunk; id < end; id++) {
+            Model& model = models[id];
+            model = Model();
+            history.forEach(static_cast<int>(id), [&](const FillSample& sample) { update(model, sample); });
+            if (model.started) {
+                model.forecast = forecast(static_cast<int>(id), model, now);
+            }
+        }
+    });
+}
+
+std::size_t FillForecaster::historyBytes() const {
+    std::unique_lock lock(mutex);
+    return history.bytes();
+}
+
+std::optional<FillForecast> FillForecaster::forecast(const int id) const {
+    std::unique_lock lock(mutex);
+    if (id < 0 || static_cast<std::size_t>(id) >= models.size() || !models[id].started) return std::nullopt;
+    return models[id].forecast;
+}
+
+std::vector<FillForecast> FillForecaster::soonest(const std::size_t count) const {
+    std::vector<FillForecast> forecasts;
+    {
+        std::unique_lock lock(mutex);
+        for (const Model& model : models) {
+            if (model.started && model.forecast.fullAt != std::numeric_limits<std::int64_t>::max()) {
+                forecasts.push_back(model.forecast);
+            }
+        }
+    }
+    auto sooner = [](const FillForecast& a, const FillForecast& b) {
+        return a.fullAt != b.fullAt ? a.fullAt < b.fullAt : a.id < b.id;
+    };
+    const std::size_t size = std::min(count, forecasts.size());
+    std::partial_sort(forecasts.begin(), forecasts.begin() + static_cast<std::ptrdiff_t>(size), forecasts.end(), sooner);
+    forecasts.resize(size);
+    return forecasts;
+}
+
+std::size_t FillForecaster::size() const {
+    std::unique_lock lock(mutex);
+    std::size_t count = 0;
+    for (const Model& model : models) {
+        if (model.started) count++;
+    }
+    return count;
+}
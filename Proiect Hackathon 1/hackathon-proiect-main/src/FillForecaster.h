@@ -0,0 +1,91 @@
+#pragma once
+#include "FillSampleArena.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+struct FillForecasterConfig {
+    float fullThreshold = 80.0f;          // percent at which a bin counts as full
+    float emptyDrop = 20.0f;              // a fall of this many points is an emptying
+    double regressionHalfLifeHours = 24;  // older samples fade out of the fill-rate fit
+    double profileHalfLifeHours = 72;     // per weekday, so about three weeks
+    double minWeekdayHours = 6;           // observed hours before a weekday gets its own factor
+    std::int64_t utcOffsetSeconds = 0;    // local time zone, for weekday boundaries
+    // recompute() keeps this many half-lives of the slower model, the weekday
+    // profile (whose half-life passes once a week per weekday hour), at the
+    // latest sample per historyStepSeconds: three weeks of hourly samples.
+    double historyHalfLives = 1;
+    std::int64_t historyStepSeconds = 3600;
+    std::size_t threads = std::thread::hardware_concurrency();
+};
+
+struct FillForecast {
+    int id;
+    float level;           // fitted fullness at the forecast time
+    double rate;           // current fill rate, percent per hour
+    double hoursToFull;    // infinity when the bin is not filling
+    std::int64_t fullAt;   // unix seconds; INT64_MAX when not filling
+};
+
+// Predicts when each dumpster will reach fullThreshold from its fullness
+// samples. Per dumpster it keeps, per weekday, the decayed rise in fullness
+// and hours observed, which give that weekday's fill rate relative to the
+// overall one, and a time-decayed least-squares fit of fullness over the
+// current fill cycle (reset when the bin is emptied). The fit runs against a
+// seasonal clock that advances by each weekday's factor per hour, so its
+// slope is the deseasonalized fill rate. A sample updates both in O(1) and
+// refreshes the forecast, which walks that rate forward day by day, scaled by
+// each weekday's factor, until the bin is predicted full.
+//
+// The latest sample of each historyStepSeconds over the model horizon is kept
+// in a ring arena, about 4 KB per observed dumpster by default, so recompute()
+// can rebuild every model (after a config change, say) and re-forecast from a
+// new "now"; it splits the fleet across worker threads. Samples finer than
+// the step are folded into the fit as they arrive but not replayed.
+class FillForecaster {
+    struct Model {
+        bool started = false;
+        double clock = 0;  // seasonal hours since the cycle started
+        std::int64_t lastTime = 0;
+        float lastFullness = 0;
+        // Weighted sums of (clock, fullness) for the current cycle.
+        double weight = 0;
+        double sumT = 0;
+        double sumF = 0;
+        double sumTT = 0;
+        double sumTF = 0;
+        // Decayed fullness rise and elapsed hours, by weekday (0 = Sunday).
+        std::array<double, 7> rise{};
+        std::array<double, 7> hours{};
+        FillForecast forecast{};
+    };
+
+    FillForecasterConfig config;
+    mutable std::mutex mutex;
+    std::vector<Model> models;  // by dumpster id
+    FillSampleArena history;
+
+    int weekday(std::int64_t timestamp) const;
+    // Each weekday's fill rate relative to the overall one (1 without enough data).
+    std::array<double, 7> weekdayFactors(const Model& model) const;
+    void update(Model& model, const FillSample& sample) const;
+    FillForecast forecast(int id, const Model& model, std::int64_t now) const;
+public:
+    explicit FillForecaster(FillForecasterConfig config = {});
+
+    void observe(int id, std::int64_t timestamp, float fullness);
+
+    // Rebuilds every model from the kept samples and forecasts as of `now`.
+    void recompute(std::int64_t now);
+    std::size_t historyBytes() const;
+
+    std::optional<FillForecast> forecast(int id) const;
+    // The `count` dumpsters predicted to be full soonest, soonest first.
+    // Bins that are not filling are left out.
+    std::vector<FillForecast> soonest(std::size_t count) const;
+    std::size_t size() const;
+};
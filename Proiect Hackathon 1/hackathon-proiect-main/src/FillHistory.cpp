@@ -0,0 +1,146 @@
+#pragma once
+#include "FillHistory.h"
+#include <algorithm>
+#include <iostream>
+#include <limits>
+#include <ostream>
+
+FillHistory::FillHistory(const std::string& dbName, const FillHistoryConfig config)
+    : database(dbName), config(config), arena(config.samplesPerDumpster) {
+    if (this->config.bucketSeconds <= 0) this->config.bucketSeconds = 1;
+}
+
+FillHistory::~FillHistory() {
+    detach();
+    if (!flush(true)) {
+        std::cerr << "Error flushing fill history" << std::endl;
+    }
+}
+
+void FillHistory::attach(MonitorScheduler& scheduler) {
+    detach();
+    this->scheduler = &scheduler;
+    flushTask = scheduler.schedule(config.flushPeriod, [this] { flush(); });
+}
+
+void FillHistory::detach() {
+    if (scheduler != nullptr) {
+        scheduler->cancel(flushTask);
+        scheduler = nullptr;
+        flushTask = MonitorScheduler::InvalidTask;
+    }
+}
+
+std::int64_t FillHistory::bucketOf(const std::int64_t timestamp) const {
+    return timestamp - timestamp % config.bucketSeconds;
+}
+
+void FillHistory::reserve(const std::size_t dumpsters) {
+    std::unique_lock lock(mutex);
+    arena.reserve(dumpsters);
+    if (persistedUntil.size() < dumpsters) persistedUntil.resize(dumpsters, 0);
+}
+
+bool FillHistory::record(const int id, const std::int64_t timestamp, const float fullness) {
+    std::unique_lock lock(mutex);
+    if (id < 0 || timestamp < 0 || timestamp > std::numeric_limits<std::uint32_t>::max()
+        || (arena.size(id) > 0 && timestamp < arena.newest(id).timestamp)) {
+        rejected++;
+        return false;
+    }
+    const auto index = static_cast<std::size_t>(id);
+    if (index >= persistedUntil.size()) {
+        persistedUntil.resize(std::max(index + 1, persistedUntil.size() + persistedUntil.size() / 2), 0);
+    }
+    if (arena.size(id) == arena.ringCapacity() && arena.ringCapacity() > 0
+        && arena.oldest(id).timestamp >= persistedUntil[index]) {
+        lost++;
+    }
+    arena.push(id, {timestamp, fullness});
+    recorded++;
+    return true;
+}
+
+bool FillHistory::flush(const bool includeOpen) {
+    std::unique_lock flushLock(flushMutex);
+    std::vector<FillBucket> batch;
+    std::vector<std::pair<int, std::int64_t>> marks;
+    {
+        std::unique_lock lock(mutex);
+        for (std::size_t index = 0; index < arena.dumpsters(); index++) {
+            const int id = static_cast<int>(index);
+            if (arena.size(id) == 0) continue;
+            const std::int64_t open = bucketOf(arena.newest(id).timestamp);
+            const std::int64_t from = persistedUntil[index];
+            if (open <= from && !includeOpen) continue;
+            const std::size_t first = batch.size();
+            double sum = 0;
+            arena.forEach(id, [&](const FillSample& sample) {
+                if (sample.timestamp < from) return;
+                const std::int64_t start = bucketOf(sample.timestamp);
+                if (start == open && !includeOpen) return;
+                if (batch.size() == first || batch.back().start != start) {
+                    if (batch.size() > first) batch.back().mean = static_cast<float>(sum / batch.back().samples);
+                    batch.push_back({id, start, sample.fullness, sample.fullness, 0, 0});
+                    sum = 0;
+                }
+                FillBucket& bucket = batch.back();
+                bucket.minimum = std::min(bucket.minimum, sample.fullness);
+                bucket.maximum = std::max(bucket.maximum, sample.fullness);
+                bucket.samples++;
+                sum += sample.fullness;
+            });
+            if (batch.size() > first) batch.back().mean = static_cast<float>(sum / batch.back().samples);
+            // The open bucket is only ever written whole, so the mark stops before it.
+            if (open > from) marks.emplace_back(id, open);
+        }
+    }
+    if (batch.empty()) {
+        return true;
+    }
+    const bool success = database.saveFillSeries(batch);
+
+    std::unique_lock lock(mutex);
+    flushes++;
+    if (!success) {
+        failedWrites += batch.size();
+        return false;
+    }
+    bucketsWritten += batch.size();
+    for (const auto& [id, mark] : marks) {
+        persistedUntil[id] = std::max(persistedUntil[id], mark);
+    }
+    return true;
+}
+
+std::vector<FillBucket> FillHistory::curve(const int id, const std::int64_t from, const std::int64_t to) const {
+    std::vector<FillBucket> raw;
+    // Stored buckets are used up to where flush() has actually written them,
+    // raw samples from there on; a sample is never in both.
+    std::int64_t boundary = to;
+    {
+        std::unique_lock lock(mutex);
+        const std::int64_t persisted = id >= 0 && static_cast<std::size_t>(id) < persistedUntil.size() ? persistedUntil[id] : 0;
+        boundary = std::min(to, persisted);
+        if (arena.size(id) > 0) {
+            arena.forEach(id, [&](const FillSample& sample) {
+                if (sample.timestamp >= std::max(from, boundary) && sample.timestamp < to) {
+                    raw.push_back({id, sample.timestamp, sample.fullness, sample.fullness, sample.fullness, 1});
+                }
+            });
+        }
+    }
+    std::vector<FillBucket> buckets;
+    if (from < boundary) {
+        std::unique_lock flushLock(flushMutex);
+        buckets = database.getFillSeries(id, from, boundary);
+    }
+    buckets.insert(buckets.end(), raw.begin(), raw.end());
+    return buckets;
+}
+
+FillHistoryStats FillHistory::stats() const {
+    std::unique_lock lock(mutex);
+    return {recorded, rejected, lost, bucketsWritten, flushes, failedWrites,
+            arena.bytes() + persistedUntil.capacity() * sizeof(std::int64_t)};
+}
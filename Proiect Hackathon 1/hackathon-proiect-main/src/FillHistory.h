@@ -0,0 +1,79 @@
+#pragma once
+#include "DumbsterDatabaseManager.h"
+#include "FillSampleArena.h"
+#include "MonitorScheduler.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct FillHistoryConfig {
+    std::size_t samplesPerDumpster = 512;            // raw samples kept in memory
+    std::int64_t bucketSeconds = 900;                 // length of a persisted bucket
+    std::chrono::milliseconds flushPeriod{60000};    // when attached to a scheduler
+};
+
+struct FillHistoryStats {
+    std::uint64_t recorded;
+    std::uint64_t rejected;        // older than the dumpster's latest sample
+    std::uint64_t lost;            // overwritten in the ring before being persisted
+    std::uint64_t bucketsWritten;
+    std::uint64_t flushes;
+    std::uint64_t failedWrites;    // buckets
+    std::size_t memoryBytes;
+};
+
+// Fill curve of every dumpster. The latest samplesPerDumpster raw samples of
+// each dumpster sit in one FillSampleArena; flush() downsamples those not yet
+// persisted into fixed buckets (min, max, mean, count) and writes them to the
+// fill_history table. A bucket is written once a later sample shows it is
+// complete, so the stored series never has to be merged back. Attached to a
+// MonitorScheduler it flushes every flushPeriod; the destructor also writes
+// the open buckets.
+class FillHistory {
+    DumbsterDatabaseManager database;
+    FillHistoryConfig config;
+
+    mutable std::mutex mutex;
+    FillSampleArena arena;
+    std::vector<std::int64_t> persistedUntil;  // by id, samples before it are stored
+    mutable std::mutex flushMutex;
+
+    std::uint64_t recorded = 0;
+    std::uint64_t rejected = 0;
+    std::uint64_t lost = 0;
+    std::uint64_t bucketsWritten = 0;
+    std::uint64_t flushes = 0;
+    std::uint64_t failedWrites = 0;
+
+    MonitorScheduler* scheduler = nullptr;
+    MonitorScheduler::TaskId flushTask = MonitorScheduler::InvalidTask;
+
+    std::int64_t bucketOf(std::int64_t timestamp) const;
+public:
+    // Opens its own connection to dbName; flushes run on scheduler workers.
+    explicit FillHistory(const std::string& dbName, FillHistoryConfig config = {});
+    ~FillHistory();
+
+    void attach(MonitorScheduler& scheduler);
+    void detach();
+
+    // Sizes the arena for ids below `dumpsters` up front; it otherwise grows
+    // by half as new ids arrive.
+    void reserve(std::size_t dumpsters);
+
+    // Returns false for a sample older than the dumpster's latest one.
+    bool record(int id, std::int64_t timestamp, float fullness);
+    // Persists the completed buckets; includeOpen also writes each dumpster's
+    // current bucket, which is rewritten by later flushes.
+    bool flush(bool includeOpen = false);
+
+    // The fill curve of `id` over [from, to), oldest first: stored buckets up
+    // to where flush() has persisted them, then each raw sample in memory
+    // after that as a one-sample bucket.
+    std::vector<FillBucket> curve(int id, std::int64_t from, std::int64_t to) const;
+
+    FillHistoryStats stats() const;
+};
@@ -0,0 +1,116 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct FillSample {
+    std::int64_t timestamp;  // unix seconds
+    float fullness;          // percent
+};
+
+// Fixed-size ring of the latest fill samples for every dumpster, all in one
+// contiguous allocation: a dumpster gets a block of `capacity` slots when its
+// first sample arrives, so memory follows the dumpsters actually recorded
+// rather than the largest id. Samples are packed to 8 bytes (unsigned 32-bit
+// seconds, good until 2106). Pushing into a full ring overwrites its oldest
+// sample. Not synchronized; the owner locks.
+class FillSampleArena {
+    static constexpr std::uint32_t NoBlock = 0xffffffffu;
+
+    struct Packed {
+        std::uint32_t timestamp;
+        float fullness;
+    };
+
+    std::size_t capacity;
+    std::vector<Packed> slots;
+    std::vector<std::uint32_t> block;  // by id, its block of slots or NoBlock
+    std::vector<std::uint32_t> next;   // by id, index of the next write
+    std::vector<std::uint32_t> count;  // by id
+
+    std::size_t base(const int id) const { return static_cast<std::size_t>(block[id]) * capacity; }
+
+    void grow(const std::size_t ids) {
+        if (ids <= count.size()) return;
+        // Grow geometrically so a fleet added one id at a time copies the tables O(log n) times.
+        const std::size_t size = std::max(ids, count.size() + count.size() / 2);
+        block.resize(size, NoBlock);
+        next.resize(size, 0);
+        count.resize(size, 0);
+    }
+public:
+    explicit FillSampleArena(const std::size_t capacity) : capacity(capacity) {}
+
+    std::size_t ringCapacity() const { return capacity; }
+    std::size_t dumpsters() const { return count.size(); }
+    std::size_t size(const int id) const {
+        return id >= 0 && static_cast<std::size_t>(id) < count.size() ? count[id] : 0;
+    }
+    std::size_t bytes() const {
+        return slots.capacity() * sizeof(Packed)
+            + (block.capacity() + next.capacity() + count.capacity()) * sizeof(std::uint32_t);
+    }
+
+    // Makes room for ids below `dumpsters` and reserves their slots up front.
+    void reserve(const std::size_t dumpsters) {
+        grow(dumpsters);
+        slots.reserve(dumpsters * capacity);
+    }
+
+    // Oldest sample of the ring, which the next push into a full ring replaces;
+    // the ring must not be empty.
+    FillSample oldest(const int id) const {
+        const std::size_t start = count[id] < capacity ? 0 : next[id];
+        const Packed& sample = slots[base(id) + start];
+        return {sample.timestamp, sample.fullness};
+    }
+
+    // Latest sample of the ring; the ring must not be empty.
+    FillSample newest(const int id) const {
+        const std::size_t last = (next[id] + capacity - 1) % capacity;
+        const Packed& sample = slots[base(id) + last];
+        return {sample.timestamp, sample.fullness};
+    }
+
+    void push(const int id, const FillSample& sample) {
+        if (id < 0 || capacity == 0) return;
+        grow(static_cast<std::size_t>(id) + 1);
+        if (block[id] == NoBlock) {
+            block[id] = static_cast<std::uint32_t>(slots.size() / capacity);
+            if (slots.size() == slots.capacity()) {
+                // Grow by a quarter rather than doubling: at most 25% of the slots sit unused.
+                slots.reserve(slots.size() + std::max(capacity, slots.size() / 4 / capacity * capacity));
+            }
+            slots.resize(slots.size() + capacity);
+        }
+        slots[base(id) + next[id]] = {static_cast<std::uint32_t>(sample.timestamp), sample.fullness};
+        next[id] = static_cast<std::uint32_t>((next[id] + 1) % capacity);
+        if (count[id] < capacity) count[id]++;
+    }
+
+    // Overwrites the latest sample; the ring must not be empty.
+    void replaceNewest(const int id, const FillSample& sample) {
+        const std::size_t last = (next[id] + capacity - 1) % capacity;
+        slots[base(id) + last] = {static_cast<std::uint32_t>(sample.timestamp), sample.fullness};
+    }
+
+    void clear(const int id) {
+        if (id < 0 || static_cast<std::size_t>(id) >= count.size()) return;
+        next[id] = 0;
+        count[id] = 0;
+    }
+
+    // Calls fn(const FillSample&) for each sample of `id`, oldest first.
+    template <typename Fn>
+    void forEach(const int id, Fn&& fn) const {
+        const std::size_t size = this->size(id);
+        if (size == 0) return;
+        const std::size_t first = base(id);
+        const std::size_t start = size < capacity ? 0 : next[id];
+        for (std::size_t i = 0; i < size; i++) {
+            const Packed& sample = slots[first + (start + i) % capacity];
+            fn(FillSample{sample.timestamp, sample.fullness});
+        }
+    }
+};
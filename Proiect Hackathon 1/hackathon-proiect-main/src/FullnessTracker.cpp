@@ -0,0 +1,94 @@
+#pragma once
+#include "FullnessTracker.h"
+#include <iostream>
+#include <ostream>
+#include <vector>
+
+FullnessTracker::FullnessTracker(DumbsterDatabaseManager& database, const FullnessThresholds thresholds)
+    : database(database), thresholds(thresholds) {}
+
+FullnessTracker::~FullnessTracker() {
+    detach();
+    if (!flush()) {
+        std::cerr << "Error flushing fullness updates" << std::endl;
+    }
+}
+
+void FullnessTracker::attach(MonitorScheduler& scheduler) {
+    detach();
+    this->scheduler = &scheduler;
+    flushTask = scheduler.schedule(scheduler.tickDuration(), [this] { flush(); });
+}
+
+void FullnessTracker::detach() {
+    if (scheduler != nullptr) {
+        scheduler->cancel(flushTask);
+        scheduler = nullptr;
+        flushTask = MonitorScheduler::InvalidTask;
+    }
+}
+
+bool FullnessTracker::report(const int id, const float fullness) {
+    std::unique_lock lock(mutex);
+    reports++;
+    State& state = states[id];
+    state.current = nextFullState(state.current, fullness, thresholds);
+    auto queued = pending.find(id);
+    if (state.known && state.persisted == state.current) {
+        // Back where the database already is; drop any write still queued.
+        if (queued != pending.end()) pending.erase(queued);
+        suppressed++;
+    }
+    else if (queued != pending.end() && queued->second == state.current) {
+        suppressed++;
+    }
+    else {
+        pending[id] = state.current;
+    }
+    return state.current;
+}
+
+bool FullnessTracker::flush() {
+    std::unique_lock flushLock(flushMutex);
+    std::vector<DumbsterFullUpdate> batch;
+    {
+        std::unique_lock lock(mutex);
+        batch.reserve(pending.size());
+        for (const auto& [id, isFull] : pending) {
+            batch.push_back({id, isFull});
+        }
+        pending.clear();
+    }
+    if (batch.empty()) {
+        return true;
+    }
+    // A flush is one transaction however many dumpsters changed.
+    const bool success = database.updateDumbstersFull(batch, true);
+
+    std::unique_lock lock(mutex);
+    if (success) {
+        written += batch.size();
+        transactions++;
+    }
+    else {
+        failedWrites += batch.size();
+    }
+    for (const DumbsterFullUpdate& update : batch) {
+        State& state = states[update.id];
+        if (success) {
+            state.persisted = update.isFull;
+            state.known = true;
+        }
+        // Reports that arrived during the write (or a failed write) still
+        // need the latest state stored.
+        if (!pending.contains(update.id) && !(state.known && state.persisted == state.current)) {
+            pending[update.id] = state.current;
+        }
+    }
+    return success;
+}
+
+FullnessTrackerStats FullnessTracker::stats() const {
+    std::unique_lock lock(mutex);
+    return {reports, suppressed, written, transactions, failedWrites};
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include "DumbsterDatabaseManager.h"
+#include "MonitorScheduler.h"
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// A dumpster turns full at threshold + hysteresis/2 and empty again below
+// threshold - hysteresis/2, so readings hovering around the threshold do not
+// flip the stored state on every sample. hysteresis = 0 is a plain cut-off.
+struct FullnessThresholds {
+    float threshold = 80.0f;
+    float hysteresis = 5.0f;
+};
+
+inline bool nextFullState(const bool wasFull, const float fullness, const FullnessThresholds& thresholds) {
+    const float band = thresholds.hysteresis / 2.0f;
+    return wasFull ? fullness >= thresholds.threshold - band : fullness >= thresholds.threshold + band;
+}
+
+struct FullnessTrackerStats {
+    std::uint64_t reports;
+    std::uint64_t suppressed;    // reports that did not change the stored state
+    std::uint64_t written;       // rows updated
+    std::uint64_t transactions;
+    std::uint64_t failedWrites;
+};
+
+// Change-only writer for dumpster fullness. It remembers the state last
+// persisted for each dumpster, queues a write only when a report crosses the
+// hysteresis band, and commits everything queued since the previous flush in
+// one transaction, whatever the manager's batch size. Attached to a
+// MonitorScheduler it flushes once per tick. Writes go through the manager it is given, so a DumbsterCache or geo
+// index attached to that manager stays in step.
+class FullnessTracker {
+    struct State {
+        bool persisted = false;
+        bool known = false;    // persisted is meaningless until the first write
+        bool current = false;  // latest state decided from reports
+    };
+
+    DumbsterDatabaseManager& database;
+    FullnessThresholds thresholds;
+
+    mutable std::mutex mutex;
+    std::unordered_map<int, State> states;
+    std::unordered_map<int, bool> pending;
+    std::mutex flushMutex;
+
+    std::uint64_t reports = 0;
+    std::uint64_t suppressed = 0;
+    std::uint64_t written = 0;
+    std::uint64_t transactions = 0;
+    std::uint64_t failedWrites = 0;
+
+    MonitorScheduler* scheduler = nullptr;
+    MonitorScheduler::TaskId flushTask = MonitorScheduler::InvalidTask;
+public:
+    // `database` must outlive the tracker; flushes run on scheduler workers.
+    explicit FullnessTracker(DumbsterDatabaseManager& database, FullnessThresholds thresholds = {});
+    ~FullnessTracker();
+
+    void attach(MonitorScheduler& scheduler);
+    void detach();
+
+    // Returns the dumpster's current full state after this reading.
+    bool report(int id, float fullness);
+    bool flush();
+
+    FullnessTrackerStats stats() const;
+};
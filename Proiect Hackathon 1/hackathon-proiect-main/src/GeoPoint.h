@@ -0,0 +1,22 @@
+#pragma once
+#include <cmath>
+
+// WGS84 coordinates in degrees.
+struct GeoPoint {
+    double latitude = 0;
+    double longitude = 0;
+};
+
+inline constexpr double EarthRadiusMeters = 6371008.8;
+inline constexpr double DegreesToRadians = 3.14159265358979323846 / 180.0;
+
+// Great-circle (haversine) distance in meters.
+inline double distanceMeters(const GeoPoint& a, const GeoPoint& b) {
+    const double dLat = (b.latitude - a.latitude) * DegreesToRadians;
+    const double dLon = (b.longitude - a.longitude) * DegreesToRadians;
+    const double sinLat = std::sin(dLat / 2);
+    const double sinLon = std::sin(dLon / 2);
+    const double h = sinLat * sinLat
+                   + std::cos(a.latitude * DegreesToRadians) * std::cos(b.latitude * DegreesToRadians) * sinLon * sinLon;
+    return 2 * EarthRadiusMeters * std::asin(std::sqrt(std::fmin(1.0, h)));
+}
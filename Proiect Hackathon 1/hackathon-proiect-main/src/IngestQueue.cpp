@@ -0,0 +1,256 @@
+#pragma once
+#include "IngestQueue.h"
+#include <algorithm>
+#include <iostream>
+#include <ostream>
+
+IngestQueue::IngestQueue(DatabaseManager& readingsDb, DumbsterDatabaseManager& dumbstersDb,
+                         const std::size_t capacity, const BackpressurePolicy policy,
+                         const std::chrono::milliseconds flushInterval)
+    : readingsDb(readingsDb), dumbstersDb(dumbstersDb), policy(policy), flushInterval(flushInterval),
+      maxBatch(std::max<std::size_t>(capacity / 2, 1)), readings(capacity), fullness(capacity) {
+    writer = std::jthread([this](std::stop_token stopToken) { writerLoop(stopToken); });
+}
+
+IngestQueue::~IngestQueue() {
+    stop();
+}
+
+std::size_t IngestQueue::depth() const {
+    return readings.size() + fullness.size() + parked.load();
+}
+
+void IngestQueue::notifyWriter() {
+    if (writerIdle.load()) {
+        std::lock_guard lock(wakeMutex);
+        wake.notify_one();
+    }
+}
+
+template <typename T, typename Key>
+bool IngestQueue::submit(MpscRingBuffer<Entry<T>>& ring, std::unordered_map<Key, Entry<T>>& side, const Key& key, T&& value) {
+    if (stopped.load()) {
+        return false;
+    }
+    Entry<T> entry{std::move(value), nextSeq.fetch_add(1), std::chrono::steady_clock::now()};
+    while (!ring.tryPush(std::move(entry))) {
+        if (policy == BackpressurePolicy::Block) {
+            std::uint64_t epoch = drainEpoch.load();
+            notifyWriter();
+            if (stopped.load()) {
+                return false;
+            }
+            if (ring.size() >= ring.capacity()) {
+                drainEpoch.wait(epoch);
+            }
+        }
+        else if (policy == BackpressurePolicy::DropOldest) {
+            Entry<T> victim;
+            if (ring.tryPop(victim)) {
+                dropped.fetch_add(1);
+            }
+        }
+        else {
+            std::lock_guard lock(coalesceMutex);
+            auto [it, inserted] = side.try_emplace(key, std::move(entry));
+            if (inserted) {
+                parked.fetch_add(1);
+            }
+            else {
+                it->second = std::move(entry);
+                coalesced.fetch_add(1);
+            }
+            break;
+        }
+    }
+    enqueued.fetch_add(1);
+
+    std::size_t current = depth();
+    std::size_t seen = maxDepth.load();
+    while (current > seen && !maxDepth.compare_exchange_weak(seen, current)) {}
+    if (current >= maxBatch) {
+        notifyWriter();
+    }
+    return true;
+}
+
+bool IngestQueue::submitReading(ReadingInput reading) {
+    // Stamped now rather than when the writer gets to it, so a reading held
+    // back in the ring or the coalescing table keeps its submission time.
+    reading.timestamp = readingsDb.stampReading(reading.timestamp);
+    std::string key = reading.user;
+    return submit(readings, coalescedReadings, key, std::move(reading));
+}
+
+bool IngestQueue::submitFullness(const int id, const bool isFull) {
+    return submit(fullness, coalescedFullness, id, DumbsterFullUpdate{id, isFull});
+}
+
+void IngestQueue::recordLatency(const std::chrono::steady_clock::time_point submitted, const std::chrono::steady_clock::time_point committed) {
+    auto micros = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(committed - submitted).count());
+    latencySumMicros.fetch_add(micros, std::memory_order_relaxed);
+    std::uint64_t seen = latencyMaxMicros.load(std::memory_order_relaxed);
+    while (micros > seen && !latencyMaxMicros.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {}
+}
+
+bool IngestQueue::drainOnce() {
+    draining.store(true);
+    readingBatch.clear();
+    fullnessBatch.clear();
+
+    Entry<ReadingInput> reading;
+    while (readingBatch.size() < maxBatch && readings.tryPop(reading)) {
+        readingBatch.push_back(std::move(reading));
+    }
+    Entry<DumbsterFullUpdate> update;
+    while (fullnessBatch.size() < maxBatch && fullness.tryPop(update)) {
+        fullnessBatch.push_back(update);
+    }
+    {
+        std::lock_guard lock(coalesceMutex);
+        for (auto& [user, entry] : coalescedReadings) {
+            readingBatch.push_back(std::move(entry));
+        }
+        for (auto& [id, entry] : coalescedFullness) {
+            fullnessBatch.push_back(entry);
+        }
+        coalescedReadings.clear();
+        coalescedFullness.clear();
+        parked.store(0);
+    }
+
+    if (readingBatch.empty() && fullnessBatch.empty()) {
+        draining.store(false);
+        return false;
+    }
+
+    std::size_t readingsWritten = 0;
+    if (!readingBatch.empty()) {
+        std::sort(readingBatch.begin(), readingBatch.end(),
+                  [](const auto& a, const auto& b) { return a.seq < b.seq; });
+        readingRows.clear();
+        for (auto& entry : readingBatch) {
+            readingRows.push_back(std::move(entry.value));
+        }
+        readingsWritten = readingsDb.commitReadings(readingRows);
+        if (readingsWritten < readingRows.size()) {
+            std::cerr << "IngestQueue: failed to write " << readingRows.size() - readingsWritten << " readings" << std::endl;
+            failedWrites.fetch_add(readingRows.size() - readingsWritten);
+        }
+    }
+    if (!fullnessBatch.empty()) {
+        // Entries parked in the coalescing table may be newer than ones still
+        // in the ring; apply them in submission order so the latest state wins.
+        // Across drains, updates older than one already written are dropped.
+        std::sort(fullnessBatch.begin(), fullnessBatch.end(),
+                  [](const auto& a, const auto& b) { return a.seq < b.seq; });
+        std::size_t kept = 0;
+        for (auto& entry : fullnessBatch) {
+            auto it = fullnessWrittenSeq.find(entry.value.id);
+            if (it != fullnessWrittenSeq.end() && entry.seq < it->second) {
+                coalesced.fetch_add(1);
+                continue;
+            }
+            fullnessBatch[kept++] = entry;
+        }
+        fullnessBatch.resize(kept);
+        fullnessRows.clear();
+        for (const auto& entry : fullnessBatch) {
+            fullnessRows.push_back(entry.value);
+        }
+    }
+    // One transaction, so the updates are either all written or none.
+    std::size_t fullnessWritten = 0;
+    if (!fullnessBatch.empty()) {
+        if (dumbstersDb.updateDumbstersFull(fullnessRows, true)) {
+            fullnessWritten = fullnessBatch.size();
+            for (const auto& entry : fullnessBatch) {
+                fullnessWrittenSeq[entry.value.id] = entry.seq;  // ascending, so the newest stays
+            }
+        }
+        else {
+            std::cerr << "IngestQueue: failed to write " << fullnessRows.size() << " fullness updates" << std::endl;
+            failedWrites.fetch_add(fullnessRows.size());
+        }
+    }
+
+    // Only rows that were committed count as written and have a latency.
+    auto committed = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < readingsWritten; i++) {
+        recordLatency(readingBatch[i].submitted, committed);
+    }
+    for (std::size_t i = 0; i < fullnessWritten; i++) {
+        recordLatency(fullnessBatch[i].submitted, committed);
+    }
+    written.fetch_add(readingsWritten + fullnessWritten);
+
+    draining.store(false);
+    return true;
+}
+
+void IngestQueue::finishCycle() {
+    drainEpoch.fetch_add(1);
+    drainEpoch.notify_all();
+}
+
+void IngestQueue::writerLoop(std::stop_token stopToken) {
+    while (!stopToken.stop_requested()) {
+        if (depth() >= maxBatch && drainOnce()) {
+            finishCycle();
+            continue;
+        }
+        writerIdle.store(true);
+        {
+            std::unique_lock lock(wakeMutex);
+            wake.wait_for(lock, stopToken, flushInterval,
+                          [this] { return flushRequested.load() || depth() >= maxBatch; });
+        }
+        writerIdle.store(false);
+        flushRequested.store(false);
+        drainOnce();
+        finishCycle();
+    }
+    while (drainOnce()) {}
+    finishCycle();
+}
+
+void IngestQueue::flush() {
+    for (;;) {
+        std::uint64_t epoch = drainEpoch.load();
+        if (stopped.load() || (depth() == 0 && !draining.load())) {
+            return;
+        }
+        {
+            std::lock_guard lock(wakeMutex);
+            flushRequested.store(true);
+            wake.notify_one();
+        }
+        drainEpoch.wait(epoch);
+    }
+}
+
+void IngestQueue::stop() {
+    if (stopped.exchange(true)) {
+        return;
+    }
+    writer.request_stop();
+    if (writer.joinable()) {
+        writer.join();
+    }
+}
+
+IngestQueueStats IngestQueue::stats() const {
+    std::uint64_t count = written.load();
+    return {
+        depth(),
+        maxDepth.load(),
+        enqueued.load(),
+        count,
+        dropped.load(),
+        coalesced.load(),
+        failedWrites.load(),
+        count > 0 ? static_cast<double>(latencySumMicros.load()) / static_cast<double>(count) : 0.0,
+        static_cast<double>(latencyMaxMicros.load())
+    };
+}
@@ -0,0 +1,121 @@
+#pragma once
+#include "DatabaseManager.h"
+#include "DumbsterDatabaseManager.h"
+#include "MpscRingBuffer.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// What submit* does when the ring is full.
+//  Block      - wait for the writer to make room.
+//  DropOldest - evict the oldest queued entry of the same kind.
+//  Coalesce   - park the entry in a side table keyed by user / dumpster id,
+//               keeping only the latest one per key until the writer drains it.
+enum class BackpressurePolicy {
+    Block,
+    DropOldest,
+    Coalesce
+};
+
+struct IngestQueueStats {
+    std::size_t depth;
+    std::size_t maxDepth;
+    std::uint64_t enqueued;
+    std::uint64_t written;
+    std::uint64_t dropped;
+    std::uint64_t coalesced;
+    std::uint64_t failedWrites;
+    double avgLatencyMicros;  // submit -> commit
+    double maxLatencyMicros;
+};
+
+// Write-behind queue in front of DatabaseManager and DumbsterDatabaseManager.
+// Producers hand readings and fullness updates to lock-free rings; a single
+// writer thread drains them and commits each drained batch in one transaction
+// per table. The managers passed in are written from the writer thread only.
+class IngestQueue {
+    template <typename T>
+    struct Entry {
+        T value;
+        std::uint64_t seq = 0;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    DatabaseManager& readingsDb;
+    DumbsterDatabaseManager& dumbstersDb;
+    BackpressurePolicy policy;
+    std::chrono::milliseconds flushInterval;
+    std::size_t maxBatch;
+
+    MpscRingBuffer<Entry<ReadingInput>> readings;
+    MpscRingBuffer<Entry<DumbsterFullUpdate>> fullness;
+
+    std::mutex coalesceMutex;
+    std::unordered_map<std::string, Entry<ReadingInput>> coalescedReadings;
+    std::unordered_map<int, Entry<DumbsterFullUpdate>> coalescedFullness;
+    // Entries in both tables, changed under coalesceMutex, so depth() can be
+    // read on the producer path without taking it.
+    std::atomic<std::size_t> parked{0};
+
+    std::mutex wakeMutex;
+    std::condition_variable_any wake;
+    std::atomic<bool> writerIdle{false};
+    std::atomic<bool> draining{false};
+    std::atomic<bool> stopped{false};
+    std::atomic<bool> flushRequested{false};
+    std::atomic<std::uint64_t> drainEpoch{0};
+    std::atomic<std::uint64_t> nextSeq{0};
+
+    std::atomic<std::uint64_t> enqueued{0};
+    std::atomic<std::uint64_t> written{0};
+    std::atomic<std::uint64_t> dropped{0};
+    std::atomic<std::uint64_t> coalesced{0};
+    std::atomic<std::uint64_t> failedWrites{0};
+    std::atomic<std::uint64_t> latencySumMicros{0};
+    std::atomic<std::uint64_t> latencyMaxMicros{0};
+    std::atomic<std::size_t> maxDepth{0};
+
+    // Writer-thread scratch space, reused between drains.
+    std::vector<Entry<ReadingInput>> readingBatch;
+    std::vector<Entry<DumbsterFullUpdate>> fullnessBatch;
+    std::vector<ReadingInput> readingRows;
+    std::vector<DumbsterFullUpdate> fullnessRows;
+    // Newest seq written per dumpster. An update parked in the coalescing table
+    // can be written while older ones are still in the ring; those are stale.
+    std::unordered_map<int, std::uint64_t> fullnessWrittenSeq;
+
+    std::jthread writer;
+
+    std::size_t depth() const;
+    template <typename T, typename Key>
+    bool submit(MpscRingBuffer<Entry<T>>& ring, std::unordered_map<Key, Entry<T>>& side, const Key& key, T&& value);
+    void notifyWriter();
+    void recordLatency(std::chrono::steady_clock::time_point submitted, std::chrono::steady_clock::time_point committed);
+    bool drainOnce();
+    void finishCycle();
+    void writerLoop(std::stop_token stopToken);
+public:
+    IngestQueue(DatabaseManager& readingsDb, DumbsterDatabaseManager& dumbstersDb,
+                std::size_t capacity = 4096,
+                BackpressurePolicy policy = BackpressurePolicy::Block,
+                std::chrono::milliseconds flushInterval = std::chrono::milliseconds(100));
+    ~IngestQueue();
+
+    IngestQueue(const IngestQueue&) = delete;
+    IngestQueue& operator=(const IngestQueue&) = delete;
+
+    bool submitReading(ReadingInput reading);
+    bool submitFullness(int id, bool isFull);
+
+    // Blocks until everything submitted before the call has been committed.
+    void flush();
+    void stop();
+
+    IngestQueueStats stats() const;
+};
@@ -0,0 +1,69 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+struct LatencySummary {
+    std::uint64_t count;
+    double p50Micros;
+    double p99Micros;
+    double maxMicros;
+};
+
+// Lock-free latency histogram with power-of-two microsecond buckets: bucket b
+// counts samples in [2^(b-1), 2^b) us, so percentiles are accurate to within
+// a factor of two from 1 us to over an hour. record() is two relaxed atomic
+// adds, cheap enough for every request.
+class LatencyHistogram {
+    static constexpr std::size_t Buckets = 33;
+
+    std::array<std::atomic<std::uint64_t>, Buckets> counts{};
+    std::atomic<std::uint64_t> maxMicros{0};
+public:
+    void record(const std::chrono::steady_clock::duration elapsed) {
+        const auto micros = static_cast<std::uint64_t>(
+            std::max<std::int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count(), 0));
+        const std::size_t bucket = std::min<std::size_t>(std::bit_width(micros), Buckets - 1);
+        counts[bucket].fetch_add(1, std::memory_order_relaxed);
+        std::uint64_t seen = maxMicros.load(std::memory_order_relaxed);
+        while (micros > seen && !maxMicros.compare_exchange_weak(seen, micros, std::memory_order_relaxed)) {}
+    }
+
+    // The q-th quantile, capped at the largest sample seen.
+    double percentile(const double q) const {
+        std::array<std::uint64_t, Buckets> snapshot;
+        std::uint64_t total = 0;
+        for (std::size_t b = 0; b < Buckets; b++) {
+            snapshot[b] = counts[b].load(std::memory_order_relaxed);
+            total += snapshot[b];
+        }
+        if (total == 0) return 0;
+        const auto rank = static_cast<std::uint64_t>(q * static_cast<double>(total - 1)) + 1;
+        std::uint64_t seen = 0;
+        std::size_t b = 0;
+        for (; b < Buckets - 1; b++) {
+            seen += snapshot[b];
+            if (seen >= rank) break;
+        }
+        // Interpolated linearly within the bucket.
+        const double lower = b == 0 ? 0 : static_cast<double>(std::uint64_t{1} << (b - 1));
+        const auto upper = static_cast<double>(std::uint64_t{1} << b);
+        const double within = static_cast<double>(rank - (seen - snapshot[b])) / static_cast<double>(snapshot[b]);
+        return std::min(lower + within * (upper - lower), static_cast<double>(maxMicros.load(std::memory_order_relaxed)));
+    }
+
+    LatencySummary summary() const {
+        std::uint64_t total = 0;
+        for (const auto& count : counts) total += count.load(std::memory_order_relaxed);
+        return {total, percentile(0.5), percentile(0.99), static_cast<double>(maxMicros.load(std::memory_order_relaxed))};
+    }
+
+    void clear() {
+        for (auto& count : counts) count.store(0, std::memory_order_relaxed);
+        maxMicros.store(0, std::memory_order_relaxed);
+    }
+};
@@ -0,0 +1,254 @@
+#pragma once
+#include "MonitorScheduler.h"
+#include <algorithm>
+
+namespace {
+
+thread_local MonitorScheduler::TaskId runningTask = MonitorScheduler::InvalidTask;
+
+}
+
+MonitorScheduler::MonitorScheduler(const std::size_t workerCount, const Clock::duration resolution)
+    : resolution(resolution), epoch(Clock::now()) {
+    wheel.fill(NoNode);
+    for (std::size_t i = 0; i < std::max<std::size_t>(1, workerCount); i++) {
+        workers.emplace_back([this](std::stop_token token) { workerLoop(token); });
+    }
+    timer = std::jthread([this](std::stop_token token) { timerLoop(token); });
+}
+
+MonitorScheduler::~MonitorScheduler() {
+    stop();
+}
+
+MonitorScheduler& MonitorScheduler::shared() {
+    static MonitorScheduler scheduler;
+    return scheduler;
+}
+
+MonitorScheduler::TaskId MonitorScheduler::makeId(const std::uint32_t index, const std::uint32_t generation) {
+    return (static_cast<TaskId>(generation) << 32) | index;
+}
+
+MonitorScheduler::Node* MonitorScheduler::lookup(const TaskId id) {
+    const auto index = static_cast<std::uint32_t>(id);
+    if (index >= nodes.size()) return nullptr;
+    Node& node = nodes[index];
+    return node.active && node.generation == static_cast<std::uint32_t>(id >> 32) ? &node : nullptr;
+}
+
+std::uint64_t MonitorScheduler::tickFor(const Clock::time_point deadline) const {
+    // First tick at or after the deadline, never one that was already processed.
+    const auto elapsed = (deadline - epoch).count();
+    const std::uint64_t tick = elapsed <= 0 ? 0 : static_cast<std::uint64_t>((elapsed + resolution.count() - 1) / resolution.count());
+    return std::max(tick, currentTick + 1);
+}
+
+void MonitorScheduler::link(const std::uint32_t index) {
+    Node& node = nodes[index];
+    // Level L holds expiries less than 64^(L+1) ticks away, in slot
+    // (expiry >> 6L) & 63. Anything further out waits in the top level.
+    const std::uint64_t delta = node.expiryTick - currentTick;
+    int level = 0;
+    while (level < Levels - 1 && delta >= (std::uint64_t(1) << (SlotBits * (level + 1)))) {
+        level++;
+    }
+    const std::uint64_t placed = std::min(node.expiryTick, currentTick + (std::uint64_t(1) << (SlotBits * Levels)) - 1);
+    const auto slot = static_cast<std::int32_t>(level * Slots + ((placed >> (SlotBits * level)) & (Slots - 1)));
+    node.slot = slot;
+    node.prev = NoNode;
+    node.next = wheel[slot];
+    if (node.next != NoNode) nodes[node.next].prev = index;
+    wheel[slot] = index;
+}
+
+void MonitorScheduler::unlink(const std::uint32_t index) {
+    Node& node = nodes[index];
+    if (node.slot < 0) return;
+    if (node.prev != NoNode) nodes[node.prev].next = node.next;
+    else wheel[node.slot] = node.next;
+    if (node.next != NoNode) nodes[node.next].prev = node.prev;
+    node.slot = -1;
+    node.prev = node.next = NoNode;
+}
+
+void MonitorScheduler::release(const std::uint32_t index) {
+    Node& node = nodes[index];
+    node.callback = nullptr;
+    if (++node.generation == 0) node.generation = 1;
+    freeNodes.push_back(index);
+    runFinished.notify_all();
+}
+
+void MonitorScheduler::fire(const std::uint32_t index, const Clock::time_point now) {
+    Node& node = nodes[index];
+    if (node.running) {
+        overruns++;
+    }
+    else {
+        node.running = true;
+        ready.push_back(index);
+        workAvailable.notify_one();
+    }
+    // Next deadline stays on the original grid; periods that already passed
+    // while we were behind are skipped rather than run in a burst.
+    Clock::time_point next = node.deadline + node.period;
+    if (next <= now) {
+        const auto behind = (now - node.deadline) / node.period;
+        missed += static_cast<std::uint64_t>(behind);
+        next = node.deadline + (behind + 1) * node.period;
+    }
+    node.deadline = next;
+    node.expiryTick = tickFor(next);
+    link(index);
+}
+
+void MonitorScheduler::advanceTo(const std::uint64_t tick, const Clock::time_point now) {
+    currentTick = tick;
+    // Entering a new block of a level moves that block's slot one level down.
+    for (int level = 1; level < Levels; level++) {
+        if ((tick & ((std::uint64_t(1) << (SlotBits * level)) - 1)) != 0) break;
+        const auto slot = static_cast<std::int32_t>(level * Slots + ((tick >> (SlotBits * level)) & (Slots - 1)));
+        std::uint32_t index = wheel[slot];
+        wheel[slot] = NoNode;
+        while (index != NoNode) {
+            const std::uint32_t next = nodes[index].next;
+            nodes[index].slot = -1;
+            link(index);
+            index = next;
+        }
+    }
+    const auto slot = static_cast<std::int32_t>(tick & (Slots - 1));
+    std::uint32_t index = wheel[slot];
+    wheel[slot] = NoNode;
+    while (index != NoNode) {
+        const std::uint32_t next = nodes[index].next;
+        nodes[index].slot = -1;
+        if (nodes[index].expiryTick <= tick) {
+            fire(index, now);
+        }
+        else {
+            link(index);
+        }
+        index = next;
+    }
+}
+
+void MonitorScheduler::timerLoop(std::stop_token token) {
+    std::unique_lock lock(mutex);
+    while (!token.stop_requested()) {
+        const Clock::time_point now = Clock::now();
+        const auto target = static_cast<std::uint64_t>(std::max<Clock::rep>(0, (now - epoch) / resolution));
+        if (taskCount == 0) {
+            currentTick = std::max(currentTick, target);
+            timerWake.wait(lock, token, [this] { return taskCount > 0; });
+            continue;
+        }
+        while (currentTick < target) {
+            advanceTo(currentTick + 1, now);
+        }
+        timerWake.wait_until(lock, token, epoch + (currentTick + 1) * resolution, [] { return false; });
+    }
+}
+
+void MonitorScheduler::workerLoop(std::stop_token token) {
+    std::unique_lock lock(mutex);
+    while (true) {
+        if (!workAvailable.wait(lock, token, [this] { return !ready.empty(); })) {
+            return;
+        }
+        const std::uint32_t index = ready.front();
+        ready.pop_front();
+        Node& node = nodes[index];
+        if (node.active) {
+            runningTask = makeId(index, node.generation);
+            lock.unlock();
+            node.callback();
+            lock.lock();
+            runningTask = InvalidTask;
+            runs++;
+        }
+        node.running = false;
+        if (!node.active) {
+            release(index);
+        }
+    }
+}
+
+MonitorScheduler::TaskId MonitorScheduler::schedule(const Clock::duration period, std::function<void()> callback) {
+    return schedule(period, period, std::move(callback));
+}
+
+MonitorScheduler::TaskId MonitorScheduler::schedule(const Clock::duration period, const Clock::duration firstDelay, std::function<void()> callback) {
+    if (period <= Clock::duration::zero() || !callback) {
+        return InvalidTask;
+    }
+    std::unique_lock lock(mutex);
+    std::uint32_t index;
+    if (!freeNodes.empty()) {
+        index = freeNodes.back();
+        freeNodes.pop_back();
+    }
+    else {
+        index = static_cast<std::uint32_t>(nodes.size());
+        nodes.emplace_back();
+    }
+    Node& node = nodes[index];
+    node.callback = std::move(callback);
+    node.period = period;
+    node.deadline = Clock::now() + firstDelay;
+    node.expiryTick = tickFor(node.deadline);
+    node.active = true;
+    node.running = false;
+    link(index);
+    if (taskCount++ == 0) {
+        timerWake.notify_one();
+    }
+    return makeId(index, node.generation);
+}
+
+bool MonitorScheduler::cancel(const TaskId id) {
+    std::unique_lock lock(mutex);
+    Node* node = lookup(id);
+    if (node == nullptr) {
+        return false;
+    }
+    const auto index = static_cast<std::uint32_t>(id);
+    node->active = false;
+    unlink(index);
+    taskCount--;
+    if (!node->running) {
+        release(index);
+    }
+    else if (runningTask != id) {
+        // The worker releases the node once the run in progress returns.
+        const std::uint32_t generation = node->generation;
+        runFinished.wait(lock, [&] { return stopped || nodes[index].generation != generation; });
+    }
+    return true;
+}
+
+void MonitorScheduler::stop() {
+    {
+        std::unique_lock lock(mutex);
+        stopped = true;
+    }
+    runFinished.notify_all();
+    timer.request_stop();
+    for (std::jthread& worker : workers) {
+        worker.request_stop();
+    }
+    if (timer.joinable()) timer.join();
+    for (std::jthread& worker : workers) {
+        if (worker.joinable()) worker.join();
+    }
+}
+
+MonitorScheduler::Clock::duration MonitorScheduler::tickDuration() const {
+    return resolution;
+}
+
+MonitorSchedulerStats MonitorScheduler::stats() {
+    std::unique_lock lock(mutex);
+    return {taskCount, runs, missed, overruns};
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct MonitorSchedulerStats {
+    std::size_t tasks;
+    std::uint64_t runs;
+    std::uint64_t missed;    // periods skipped because the scheduler fell behind
+    std::uint64_t overruns;  // runs skipped because the previous one was still going
+};
+
+// Periodic task scheduler shared by the whole fleet: a hierarchical timer wheel
+// (4 levels x 64 slots) driven by one timer thread hands due tasks to a fixed
+// pool of workers, so monitoring N dumpsters costs N small wheel nodes instead
+// of N threads.
+//
+// Deadlines are drift-free: a task with period p started at t0 runs at
+// t0 + k*p, independent of how long each run takes. A task never runs
+// concurrently with itself. cancel() takes effect immediately and waits for a
+// run in progress to finish, so the callback's captures can be destroyed
+// right after it returns.
+class MonitorScheduler {
+public:
+    using Clock = std::chrono::steady_clock;
+    using TaskId = std::uint64_t;
+    static constexpr TaskId InvalidTask = 0;
+private:
+    static constexpr int Levels = 4;
+    static constexpr int SlotBits = 6;
+    static constexpr std::uint32_t Slots = 1u << SlotBits;
+    static constexpr std::uint32_t NoNode = 0xffffffffu;
+
+    struct Node {
+        std::function<void()> callback;
+        Clock::duration period{};
+        Clock::time_point deadline;
+        std::uint64_t expiryTick = 0;
+        std::uint32_t generation = 1;
+        std::uint32_t prev = NoNode;
+        std::uint32_t next = NoNode;
+        std::int32_t slot = -1;  // level * Slots + index while in the wheel
+        bool active = false;
+        bool running = false;
+    };
+
+    Clock::duration resolution;
+    Clock::time_point epoch;
+    std::uint64_t currentTick = 0;
+
+    std::mutex mutex;
+    std::condition_variable_any timerWake;
+    std::condition_variable_any workAvailable;
+    std::condition_variable runFinished;
+
+    // Nodes live in a deque so references stay valid while it grows.
+    std::deque<Node> nodes;
+    std::vector<std::uint32_t> freeNodes;
+    std::array<std::uint32_t, Levels * Slots> wheel;
+    std::deque<std::uint32_t> ready;
+
+    bool stopped = false;
+    std::size_t taskCount = 0;
+    std::uint64_t runs = 0;
+    std::uint64_t missed = 0;
+    std::uint64_t overruns = 0;
+
+    std::vector<std::jthread> workers;
+    std::jthread timer;
+
+    static TaskId makeId(std::uint32_t index, std::uint32_t generation);
+    Node* lookup(TaskId id);
+    std::uint64_t tickFor(Clock::time_point deadline) const;
+    void link(std::uint32_t index);
+    void unlink(std::uint32_t index);
+    void release(std::uint32_t index);
+    void advanceTo(std::uint64_t tick, Clock::time_point now);
+    void fire(std::uint32_t index, Clock::time_point now);
+
+    void timerLoop(std::stop_token token);
+    void workerLoop(std::stop_token token);
+public:
+    explicit MonitorScheduler(std::size_t workerCount = std::thread::hardware_concurrency(),
+                              Clock::duration resolution = std::chrono::milliseconds(10));
+    ~MonitorScheduler();
+
+    MonitorScheduler(const MonitorScheduler&) = delete;
+    MonitorScheduler& operator=(const MonitorScheduler&) = delete;
+
+    // Runs callback every period, first at now + firstDelay (default: one period).
+    TaskId schedule(Clock::duration period, std::function<void()> callback);
+    TaskId schedule(Clock::duration period, Clock::duration firstDelay, std::function<void()> callback);
+    // Safe to call from the task's own callback; it then does not wait.
+    bool cancel(TaskId id);
+    void stop();
+
+    MonitorSchedulerStats stats();
+    Clock::duration tickDuration() const;
+
+    // Process-wide scheduler used by Dumbster::startMonitoring() by default.
+    static MonitorScheduler& shared();
+};
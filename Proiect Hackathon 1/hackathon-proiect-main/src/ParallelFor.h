@@ -0,0 +1,23 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// Calls fn(i) for every i in [0, count) on up to `threads` threads (the
+// caller's included), handing out indices one at a time, and returns when all
+// calls have finished.
+template <typename Fn>
+void parallelFor(const std::size_t count, std::size_t threads, Fn&& fn) {
+    std::atomic<std::size_t> next{0};
+    auto work = [&] {
+        for (std::size_t i; (i = next.fetch_add(1)) < count;) fn(i);
+    };
+    threads = std::clamp<std::size_t>(threads, 1, std::max<std::size_t>(count, 1));
+    std::vector<std::jthread> workers;
+    for (std::size_t t = 1; t < threads; t++) {
+        workers.emplace_back(work);
+    }
+    work();
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include "PasswordHash.h"
+#include <algorithm>
+#include <random>
+
+namespace {
+
+constexpr std::size_t BlockSize = 64;
+constexpr std::size_t SaltBytes = 16;
+
+const uint8_t* bytes(std::string_view text) {
+    return reinterpret_cast<const uint8_t*>(text.data());
+}
+
+}
+
+HmacSha256::HmacSha256(std::string_view key) {
+    std::array<uint8_t, BlockSize> block{};
+    if (key.size() > BlockSize) {
+        SHA256 sha;
+        sha.update(bytes(key), key.size());
+        const Sha256Digest digest = sha.digest();
+        std::copy(digest.begin(), digest.end(), block.begin());
+    }
+    else {
+        std::copy(key.begin(), key.end(), block.begin());
+    }
+    std::array<uint8_t, BlockSize> pad;
+    for (std::size_t i = 0; i < BlockSize; i++) pad[i] = block[i] ^ 0x36;
+    inner.update(pad.data(), pad.size());
+    for (std::size_t i = 0; i < BlockSize; i++) pad[i] = block[i] ^ 0x5c;
+    outer.update(pad.data(), pad.size());
+}
+
+Sha256Digest HmacSha256::mac(std::string_view message) const {
+    SHA256 innerHash = inner;
+    innerHash.update(bytes(message), message.size());
+    const Sha256Digest innerDigest = innerHash.digest();
+    SHA256 outerHash = outer;
+    outerHash.update(innerDigest.data(), innerDigest.size());
+    return outerHash.digest();
+}
+
+Sha256Digest HmacSha256::mac(const Sha256Digest& message) const {
+    SHA256 innerHash = inner;
+    innerHash.update(message.data(), message.size());
+    const Sha256Digest innerDigest = innerHash.digest();
+    SHA256 outerHash = outer;
+    outerHash.update(innerDigest.data(), innerDigest.size());
+    return outerHash.digest();
+}
+
+Sha256Digest pbkdf2HmacSha256(std::string_view password, std::string_view salt, const std::uint32_t iterations) {
+    const HmacSha256 hmac(password);
+    // U1 = HMAC(password, salt || INT(1)); one output block is all we need.
+    std::string first(salt);
+    first += std::string("\0\0\0\1", 4);
+    Sha256Digest u = hmac.mac(std::string_view(first));
+    Sha256Digest result = u;
+    for (std::uint32_t i = 1; i < iterations; i++) {
+        u = hmac.mac(u);
+        for (std::size_t j = 0; j < result.size(); j++) result[j] ^= u[j];
+    }
+    return result;
+}
+
+std::string newPasswordSalt() {
+    static constexpr char hex[] = "0123456789abcdef";
+    std::random_device device;
+    std::string salt;
+    for (std::size_t i = 0; i < SaltBytes; i += 4) {
+        unsigned int random = device();
+        for (int j = 0; j < 4; j++, random >>= 8) {
+            salt += hex[(random >> 4) & 0xf];
+            salt += hex[random & 0xf];
+        }
+    }
+    return salt;
+}
+
+std::string hashPassword(std::string_view password, std::string_view salt, const std::uint32_t iterations) {
+    return SHA256::toString(pbkdf2HmacSha256(password, salt, iterations));
+}
+
+bool equalHashes(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    unsigned char difference = 0;
+    for (std::size_t i = 0; i < a.size(); i++) difference |= static_cast<unsigned char>(a[i] ^ b[i]);
+    return difference == 0;
+}
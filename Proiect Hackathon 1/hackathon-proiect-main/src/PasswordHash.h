@@ -0,0 +1,33 @@
+#pragma once
+#include "SHA256.h"
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+using Sha256Digest = std::array<uint8_t, 32>;
+
+// HMAC-SHA256 with the key's inner and outer pad blocks compressed once up
+// front: a MAC starts from copies of those two states, so a 32-byte message
+// (PBKDF2's inner loop) costs two compressions instead of four.
+class HmacSha256 {
+    SHA256 inner;
+    SHA256 outer;
+public:
+    explicit HmacSha256(std::string_view key);
+
+    Sha256Digest mac(std::string_view message) const;
+    Sha256Digest mac(const Sha256Digest& message) const;
+};
+
+// PBKDF2-HMAC-SHA256 (RFC 8018) with a 32-byte derived key.
+Sha256Digest pbkdf2HmacSha256(std::string_view password, std::string_view salt, std::uint32_t iterations);
+
+// Random salt for a new password, hex encoded.
+std::string newPasswordSalt();
+
+// Hex of pbkdf2HmacSha256, the form stored in accountData.
+std::string hashPassword(std::string_view password, std::string_view salt, std::uint32_t iterations);
+
+// Compares two hashes in time independent of where they differ.
+bool equalHashes(std::string_view a, std::string_view b);
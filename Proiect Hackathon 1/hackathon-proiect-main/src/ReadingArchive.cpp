@@ -0,0 +1,458 @@
+#pragma once
+#include "ReadingArchive.h"
+#include <algorithm>
+#include <bit>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <sstream>
+
+namespace {
+
+constexpr char SegmentMagic[4] = {'E', 'R', 'S', 'G'};
+constexpr std::uint32_t SegmentVersion = 1;
+constexpr std::size_t StreamCount = 6;
+constexpr std::size_t HeaderSize = 4 + 4 + 4 + 4 + 8 + 8 + 4 * StreamCount;
+
+class BitWriter {
+    std::vector<std::uint8_t> bytes;
+    int used = 8; // bits already used in bytes.back()
+public:
+    void write(const std::uint64_t value, int bits) {
+        while (bits > 0) {
+            if (used == 8) {
+                bytes.push_back(0);
+                used = 0;
+            }
+            const int n = std::min(8 - used, bits);
+            const auto chunk = static_cast<std::uint8_t>((value >> (bits - n)) & ((1u << n) - 1));
+            bytes.back() |= static_cast<std::uint8_t>(chunk << (8 - used - n));
+            used += n;
+            bits -= n;
+        }
+    }
+    const std::vector<std::uint8_t>& data() const { return bytes; }
+};
+
+class BitReader {
+    const std::uint8_t* bytes;
+    std::size_t bitLength;
+    std::size_t position = 0;
+public:
+    BitReader(const std::uint8_t* bytes, const std::size_t length) : bytes(bytes), bitLength(length * 8) {}
+
+    std::uint64_t read(int bits) {
+        std::uint64_t value = 0;
+        while (bits > 0) {
+            if (position >= bitLength) return value << bits; // truncated stream reads as zeros
+            const int offset = static_cast<int>(position % 8);
+            const int n = std::min(8 - offset, bits);
+            const std::uint8_t byte = bytes[position / 8];
+            value = (value << n) | ((byte >> (8 - offset - n)) & ((1u << n) - 1));
+            position += n;
+            bits -= n;
+        }
+        return value;
+    }
+    bool readBit() { return read(1) != 0; }
+};
+
+bool fitsSigned(const std::int64_t value, const int bits) {
+    const std::int64_t limit = std::int64_t(1) << (bits - 1);
+    return value >= -limit && value < limit;
+}
+
+std::int64_t signExtend(const std::uint64_t value, const int bits) {
+    const std::uint64_t sign = std::uint64_t(1) << (bits - 1);
+    return static_cast<std::int64_t>((value ^ sign) - sign);
+}
+
+// Delta-of-delta control codes: 0 | 10+7 | 110+9 | 1110+12 | 11110+32 | 11111+64 bits.
+struct DodBucket {
+    std::uint64_t prefix;
+    int prefixBits;
+    int valueBits;
+};
+constexpr DodBucket DodBuckets[] = {{0b10, 2, 7}, {0b110, 3, 9}, {0b1110, 4, 12}, {0b11110, 5, 32}, {0b11111, 5, 64}};
+
+std::vector<std::uint8_t> encodeTimestamps(std::span<const Reading> readings) {
+    BitWriter out;
+    std::int64_t previous = 0;
+    std::int64_t previousDelta = 0;
+    for (std::size_t i = 0; i < readings.size(); i++) {
+        const std::int64_t ts = readings[i].timestamp;
+        if (i == 0) {
+            out.write(static_cast<std::uint64_t>(ts), 64);
+        }
+        else if (i == 1) {
+            previousDelta = ts - previous;
+            out.write(static_cast<std::uint64_t>(previousDelta), 64);
+        }
+        else {
+            const std::int64_t delta = ts - previous;
+            const std::int64_t dod = delta - previousDelta;
+            if (dod == 0) {
+                out.write(0, 1);
+            }
+            else {
+                for (const DodBucket& bucket : DodBuckets) {
+                    if (bucket.valueBits == 64 || fitsSigned(dod, bucket.valueBits)) {
+                        out.write(bucket.prefix, bucket.prefixBits);
+                        out.write(static_cast<std::uint64_t>(dod), bucket.valueBits);
+                        break;
+                    }
+                }
+            }
+            previousDelta = delta;
+        }
+        previous = ts;
+    }
+    return out.data();
+}
+
+void decodeTimestamps(const std::uint8_t* bytes, const std::size_t length, const std::uint32_t count, std::vector<std::int64_t>& out) {
+    BitReader in(bytes, length);
+    out.resize(count);
+    std::int64_t delta = 0;
+    for (std::uint32_t i = 0; i < count; i++) {
+        if (i == 0) {
+            out[i] = static_cast<std::int64_t>(in.read(64));
+            continue;
+        }
+        if (i == 1) {
+            delta = static_cast<std::int64_t>(in.read(64));
+        }
+        else if (in.readBit()) {
+            int prefixBits = 1;
+            while (prefixBits < 5 && in.readBit()) {
+                prefixBits++;
+            }
+            const DodBucket& bucket = DodBuckets[prefixBits - 1];
+            delta += signExtend(in.read(bucket.valueBits), bucket.valueBits);
+        }
+        out[i] = out[i - 1] + delta;
+    }
+}
+
+// XOR against the previous value; reuse the previous leading/trailing-zero
+// window when the new meaningful bits fit inside it.
+std::vector<std::uint8_t> encodeChannel(std::span<const Reading> readings, double Reading::*channel) {
+    BitWriter out;
+    std::uint64_t previous = 0;
+    int windowLeading = -1;
+    int windowTrailing = 0;
+    for (std::size_t i = 0; i < readings.size(); i++) {
+        const auto bits = std::bit_cast<std::uint64_t>(readings[i].*channel);
+        if (i == 0) {
+            out.write(bits, 64);
+            previous = bits;
+            continue;
+        }
+        const std::uint64_t x = bits ^ previous;
+        previous = bits;
+        if (x == 0) {
+            out.write(0, 1);
+            continue;
+        }
+        out.write(1, 1);
+        const int leading = std::min(std::countl_zero(x), 31);
+        const int trailing = std::countr_zero(x);
+        if (windowLeading >= 0 && leading >= windowLeading && trailing >= windowTrailing) {
+            out.write(0, 1);
+            out.write(x >> windowTrailing, 64 - windowLeading - windowTrailing);
+        }
+        else {
+            const int meaningful = 64 - leading - trailing;
+            out.write(1, 1);
+            out.write(static_cast<std::uint64_t>(leading), 5);
+            out.write(static_cast<std::uint64_t>(meaningful - 1), 6);
+            out.write(x >> trailing, meaningful);
+            windowLeading = leading;
+            windowTrailing = trailing;
+        }
+    }
+    return out.data();
+}
+
+void decodeChannel(const std::uint8_t* bytes, const std::size_t length, const std::size_t first, const std::size_t end,
+                   std::span<Reading> out, double Reading::*channel) {
+    BitReader in(bytes, length);
+    std::uint64_t value = 0;
+    int windowLeading = 0;
+    int windowTrailing = 0;
+    for (std::size_t i = 0; i < end; i++) {
+        if (i == 0) {
+            value = in.read(64);
+        }
+        else if (in.readBit()) {
+            if (in.readBit()) {
+                windowLeading = static_cast<int>(in.read(5));
+                const int meaningful = static_cast<int>(in.read(6)) + 1;
+                windowTrailing = 64 - windowLeading - meaningful;
+            }
+            const int meaningful = 64 - windowLeading - windowTrailing;
+            value ^= in.read(meaningful) << windowTrailing;
+        }
+        if (i >= first) {
+            out[i - first].*channel = std::bit_cast<double>(value);
+        }
+    }
+}
+
+constexpr double Reading::*Channels[] = {
+    &Reading::carbonDioxide, &Reading::methane, &Reading::ammonia, &Reading::inductivity, &Reading::reflectance
+};
+
+template <typename T>
+void put(std::vector<std::uint8_t>& out, const T value) {
+    const auto* raw = reinterpret_cast<const std::uint8_t*>(&value);
+    out.insert(out.end(), raw, raw + sizeof(T));
+}
+
+template <typename T>
+T get(const std::uint8_t* bytes) {
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+}
+
+ReadingArchive::ReadingArchive(const std::filesystem::path& directory) : directory(directory) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        const std::string name = entry.path().stem().string();
+        // Anything but segment_<sequence>.seg is not ours.
+        if (entry.path().extension() != ".seg" || name.rfind("segment_", 0) != 0) {
+            continue;
+        }
+        std::uint64_t sequence = 0;
+        const char* end = name.data() + name.size();
+        const auto [parsed, error] = std::from_chars(name.data() + 8, end, sequence);
+        if (error != std::errc() || parsed != end) {
+            continue;
+        }
+        if (!loadSegment(entry.path())) {
+            std::cerr << "Skipping unreadable archive segment " << entry.path() << std::endl;
+        }
+        nextSequence = std::max<std::uint64_t>(nextSequence, sequence + 1);
+    }
+}
+
+bool ReadingArchive::loadSegment(const std::filesystem::path& path) {
+    auto file = std::make_shared<MappedFile>(path);
+    if (!file->isOpen() || file->size() < HeaderSize) {
+        return false;
+    }
+    const std::uint8_t* bytes = file->data();
+    if (std::memcmp(bytes, SegmentMagic, 4) != 0 || get<std::uint32_t>(bytes + 4) != SegmentVersion) {
+        return false;
+    }
+    Segment segment;
+    segment.count = get<std::uint32_t>(bytes + 8);
+    const auto userLength = get<std::uint32_t>(bytes + 12);
+    segment.minTimestamp = get<std::int64_t>(bytes + 16);
+    segment.maxTimestamp = get<std::int64_t>(bytes + 24);
+    std::size_t total = HeaderSize + userLength;
+    for (std::size_t s = 0; s < StreamCount; s++) {
+        total += get<std::uint32_t>(bytes + 32 + 4 * s);
+    }
+    if (total > file->size()) {
+        return false;
+    }
+    std::string user(reinterpret_cast<const char*>(bytes + HeaderSize), userLength);
+    segment.path = path;
+    segment.file = std::move(file);
+
+    std::unique_lock lock(mutex);
+    std::vector<Segment>& list = segments[user];
+    auto position = std::upper_bound(list.begin(), list.end(), segment.minTimestamp,
+                                     [](std::int64_t ts, const Segment& s) { return ts < s.minTimestamp; });
+    list.insert(position, std::move(segment));
+    return true;
+}
+
+bool ReadingArchive::writeSegments(const std::string& user, std::span<const Reading> readings) {
+    for (std::size_t offset = 0; offset < readings.size(); offset += MaxSegmentRows) {
+        std::span<const Reading> rows = readings.subspan(offset, std::min(MaxSegmentRows, readings.size() - offset));
+
+        std::vector<std::vector<std::uint8_t>> streams;
+        streams.push_back(encodeTimestamps(rows));
+        for (auto channel : Channels) {
+            streams.push_back(encodeChannel(rows, channel));
+        }
+
+        std::vector<std::uint8_t> bytes;
+        bytes.insert(bytes.end(), SegmentMagic, SegmentMagic + 4);
+        put<std::uint32_t>(bytes, SegmentVersion);
+        put<std::uint32_t>(bytes, static_cast<std::uint32_t>(rows.size()));
+        put<std::uint32_t>(bytes, static_cast<std::uint32_t>(user.size()));
+        put<std::int64_t>(bytes, rows.front().timestamp);
+        put<std::int64_t>(bytes, rows.back().timestamp);
+        for (const auto& stream : streams) {
+            put<std::uint32_t>(bytes, static_cast<std::uint32_t>(stream.size()));
+        }
+        bytes.insert(bytes.end(), user.begin(), user.end());
+        for (const auto& stream : streams) {
+            bytes.insert(bytes.end(), stream.begin(), stream.end());
+        }
+
+        std::uint64_t sequence;
+        {
+            std::unique_lock lock(mutex);
+            sequence = nextSequence++;
+        }
+        std::ostringstream name;
+        name << "segment_" << std::setw(12) << std::setfill('0') << sequence << ".seg";
+        const std::filesystem::path path = directory / name.str();
+        const std::filesystem::path temporary = directory / (name.str() + ".tmp");
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            out.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+            if (!out) {
+                std::cerr << "Error writing archive segment " << temporary << std::endl;
+                return false;
+            }
+        }
+        std::error_code error;
+        std::filesystem::rename(temporary, path, error);
+        if (error || !loadSegment(path)) {
+            std::cerr << "Error sealing archive segment " << path << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void ReadingArchive::decode(const Segment& segment, const std::int64_t from, const std::int64_t to, const std::size_t limit, std::vector<Reading>& out) {
+    const std::uint8_t* bytes = segment.file->data();
+    std::uint32_t streamBytes[StreamCount];
+    for (std::size_t s = 0; s < StreamCount; s++) {
+        streamBytes[s] = get<std::uint32_t>(bytes + 32 + 4 * s);
+    }
+    const std::uint8_t* stream = bytes + HeaderSize + get<std::uint32_t>(bytes + 12);
+
+    std::vector<std::int64_t> timestamps;
+    decodeTimestamps(stream, streamBytes[0], segment.count, timestamps);
+    const std::size_t lo = std::lower_bound(timestamps.begin(), timestamps.end(), from) - timestamps.begin();
+    const std::size_t hi = std::lower_bound(timestamps.begin(), timestamps.end(), to) - timestamps.begin();
+    if (lo >= hi) {
+        return;
+    }
+    const std::size_t n = std::min(hi - lo, limit);
+    const std::size_t base = out.size();
+    out.resize(base + n);
+    std::span<Reading> rows(out.data() + base, n);
+    for (std::size_t i = 0; i < n; i++) {
+        rows[i].timestamp = timestamps[lo + i];
+    }
+    stream += streamBytes[0];
+    for (std::size_t c = 0; c < std::size(Channels); c++) {
+        decodeChannel(stream, streamBytes[c + 1], lo, lo + n, rows, Channels[c]);
+        stream += streamBytes[c + 1];
+    }
+}
+
+std::vector<Reading> ReadingArchive::read(const std::string& user, const std::int64_t from, const std::int64_t to, const std::size_t limit) const {
+    std::vector<Reading> readings;
+    std::vector<Segment> candidates;
+    {
+        std::shared_lock lock(mutex);
+        auto found = segments.find(user);
+        if (found == segments.end()) {
+            return readings;
+        }
+        for (const Segment& segment : found->second) {
+            if (segment.maxTimestamp >= from && segment.minTimestamp < to) {
+                candidates.push_back(segment);
+            }
+        }
+    }
+    // Segments archived at different times can overlap, so each one's first
+    // `limit` matches are merged by timestamp rather than concatenated.
+    std::vector<std::vector<Reading>> runs;
+    for (const Segment& segment : candidates) {
+        std::vector<Reading> run;
+        decode(segment, from, to, limit, run);
+        if (!run.empty()) runs.push_back(std::move(run));
+    }
+    if (runs.size() == 1) {
+        return std::move(runs.front());
+    }
+    using Head = std::pair<std::int64_t, std::size_t>;  // timestamp, run
+    std::priority_queue<Head, std::vector<Head>, std::greater<>> heads;
+    std::vector<std::size_t> positions(runs.size(), 0);
+    std::size_t lastRun = runs.size();
+    for (std::size_t r = 0; r < runs.size(); r++) {
+        heads.emplace(runs[r].front().timestamp, r);
+    }
+    while (!heads.empty() && readings.size() < limit) {
+        const std::size_t r = heads.top().second;
+        heads.pop();
+        const Reading& next = runs[r][positions[r]++];
+        // A reading archived twice (see DatabaseManager::archiveOlderThan) sits
+        // in two segments and is returned once; one segment never repeats a row.
+        if (readings.empty() || readings.back().timestamp != next.timestamp || lastRun == r) {
+            readings.push_back(next);
+            lastRun = r;
+        }
+        if (positions[r] < runs[r].size()) {
+            heads.emplace(runs[r][positions[r]].timestamp, r);
+        }
+    }
+    return readings;
+}
+
+std::size_t ReadingArchive::segmentCount() const {
+    std::shared_lock lock(mutex);
+    std::size_t count = 0;
+    for (const auto& [user, list] : segments) {
+        count += list.size();
+    }
+    return count;
+}
+
+std::uintmax_t ReadingArchive::bytesOnDisk() const {
+    std::shared_lock lock(mutex);
+    std::uintmax_t total = 0;
+    for (const auto& [user, list] : segments) {
+        for (const Segment& segment : list) {
+            total += segment.file->size();
+        }
+    }
+    return total;
+}
+
+ReadingArchiver::ReadingArchiver(DatabaseManager& database, const std::chrono::microseconds maxAge, const std::chrono::milliseconds period)
+    : database(database), maxAge(maxAge), period(period) {
+    worker = std::jthread([this](std::stop_token token) { run(token); });
+}
+
+ReadingArchiver::~ReadingArchiver() {
+    stop();
+}
+
+void ReadingArchiver::stop() {
+    worker.request_stop();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void ReadingArchiver::run(std::stop_token token) {
+    while (!token.stop_requested()) {
+        const std::int64_t now = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        if (database.archiveOlderThan(now - maxAge.count()) < 0) {
+            std::cerr << "Error archiving readings" << std::endl;
+        }
+        std::unique_lock lock(wakeMutex);
+        wake.wait_for(lock, token, period, [] { return false; });
+    }
+}
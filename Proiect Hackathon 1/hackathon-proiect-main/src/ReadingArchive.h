@@ -0,0 +1,77 @@
+#pragma once
+#include "DatabaseManager.h"
+#include "MappedFile.h"
+#include <cstddef>
+#include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Append-only archive of sealed reading ranges. Each segment file holds one
+// user's readings, sorted by time: timestamps are delta-of-delta encoded and
+// every channel is XOR-compressed against the previous value (the Gorilla
+// scheme), one bit stream per column. Segments are memory-mapped for reads.
+//
+// Segment layout (little-endian):
+//   magic "ERSG", u32 version, u32 count, u32 userLength, i64 minTimestamp,
+//   i64 maxTimestamp, u32 streamBytes[6], user bytes, then the six streams
+//   (timestamps, carbonDioxide, methane, ammonia, inductivity, reflectance).
+class ReadingArchive {
+public:
+    static constexpr std::size_t MaxSegmentRows = 16384;
+private:
+    struct Segment {
+        std::int64_t minTimestamp;
+        std::int64_t maxTimestamp;
+        std::uint32_t count;
+        std::filesystem::path path;
+        std::shared_ptr<MappedFile> file;
+    };
+
+    std::filesystem::path directory;
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, std::vector<Segment>> segments;
+    std::uint64_t nextSequence = 0;
+
+    bool loadSegment(const std::filesystem::path& path);
+    static void decode(const Segment& segment, std::int64_t from, std::int64_t to, std::size_t limit, std::vector<Reading>& out);
+public:
+    explicit ReadingArchive(const std::filesystem::path& directory);
+
+    // Seals readings (sorted by timestamp, one user) into new segment files.
+    bool writeSegments(const std::string& user, std::span<const Reading> readings);
+
+    // Archived readings of `user` with from <= timestamp < to, oldest first.
+    std::vector<Reading> read(const std::string& user, std::int64_t from, std::int64_t to, std::size_t limit) const;
+
+    std::size_t segmentCount() const;
+    std::uintmax_t bytesOnDisk() const;
+};
+
+// Background job that periodically moves readings older than maxAge from the
+// readings table into the archive attached to `database`. The manager is used
+// from the job's thread only, so give it its own connection.
+class ReadingArchiver {
+    DatabaseManager& database;
+    std::chrono::microseconds maxAge;
+    std::chrono::milliseconds period;
+    std::mutex wakeMutex;
+    std::condition_variable_any wake;
+    std::jthread worker;
+
+    void run(std::stop_token token);
+public:
+    ReadingArchiver(DatabaseManager& database, std::chrono::microseconds maxAge,
+                    std::chrono::milliseconds period = std::chrono::minutes(10));
+    ~ReadingArchiver();
+
+    void stop();
+};
@@ -0,0 +1,241 @@
+#pragma once
+#include "ReadingColumnStore.h"
+#include "CpuFeatures.h"
+#include <algorithm>
+#include <mutex>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+struct RangeSummary {
+    double sum;
+    double min;
+    double max;
+};
+
+RangeSummary summarizeScalar(const double* values, const std::size_t count) {
+    RangeSummary out{0.0, values[0], values[0]};
+    for (std::size_t i = 0; i < count; i++) {
+        out.sum += values[i];
+        out.min = std::min(out.min, values[i]);
+        out.max = std::max(out.max, values[i]);
+    }
+    return out;
+}
+
+#if CPU_X86
+TARGET_SSE2 RangeSummary summarizeSse2(const double* values, const std::size_t count) {
+    __m128d sum0 = _mm_setzero_pd();
+    __m128d sum1 = _mm_setzero_pd();
+    __m128d min0 = _mm_set1_pd(values[0]);
+    __m128d min1 = min0;
+    __m128d max0 = min0;
+    __m128d max1 = min0;
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128d a = _mm_loadu_pd(values + i);
+        __m128d b = _mm_loadu_pd(values + i + 2);
+        sum0 = _mm_add_pd(sum0, a);
+        sum1 = _mm_add_pd(sum1, b);
+        min0 = _mm_min_pd(min0, a);
+        min1 = _mm_min_pd(min1, b);
+        max0 = _mm_max_pd(max0, a);
+        max1 = _mm_max_pd(max1, b);
+    }
+    alignas(16) double sums[2], mins[2], maxs[2];
+    _mm_store_pd(sums, _mm_add_pd(sum0, sum1));
+    _mm_store_pd(mins, _mm_min_pd(min0, min1));
+    _mm_store_pd(maxs, _mm_max_pd(max0, max1));
+    RangeSummary out{sums[0] + sums[1], std::min(mins[0], mins[1]), std::max(maxs[0], maxs[1])};
+    for (; i < count; i++) {
+        out.sum += values[i];
+        out.min = std::min(out.min, values[i]);
+        out.max = std::max(out.max, values[i]);
+    }
+    return out;
+}
+
+TARGET_AVX2 RangeSummary summarizeAvx2(const double* values, const std::size_t count) {
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d min0 = _mm256_set1_pd(values[0]);
+    __m256d min1 = min0;
+    __m256d max0 = min0;
+    __m256d max1 = min0;
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256d a = _mm256_loadu_pd(values + i);
+        __m256d b = _mm256_loadu_pd(values + i + 4);
+        sum0 = _mm256_add_pd(sum0, a);
+        sum1 = _mm256_add_pd(sum1, b);
+        min0 = _mm256_min_pd(min0, a);
+        min1 = _mm256_min_pd(min1, b);
+        max0 = _mm256_max_pd(max0, a);
+        max1 = _mm256_max_pd(max1, b);
+    }
+    alignas(32) double sums[4], mins[4], maxs[4];
+    _mm256_store_pd(sums, _mm256_add_pd(sum0, sum1));
+    _mm256_store_pd(mins, _mm256_min_pd(min0, min1));
+    _mm256_store_pd(maxs, _mm256_max_pd(max0, max1));
+    RangeSummary out{sums[0] + sums[1] + sums[2] + sums[3],
+                     std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3])),
+                     std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]))};
+    for (; i < count; i++) {
+        out.sum += values[i];
+        out.min = std::min(out.min, values[i]);
+        out.max = std::max(out.max, values[i]);
+    }
+    return out;
+}
+#endif
+
+using SummarizeFn = RangeSummary (*)(const double*, std::size_t);
+
+SummarizeFn selectSummarize() {
+#if CPU_X86
+    if (cpuFeatures().avx2) return summarizeAvx2;
+    if (cpuFeatures().sse2) return summarizeSse2;
+#endif
+    return summarizeScalar;
+}
+
+const SummarizeFn summarize = selectSummarize();
+
+void merge(ChannelAggregate& into, const std::size_t count, const double sum, const double min, const double max) {
+    if (count == 0) return;
+    if (into.count == 0) {
+        into.min = min;
+        into.max = max;
+    }
+    else {
+        into.min = std::min(into.min, min);
+        into.max = std::max(into.max, max);
+    }
+    into.count += count;
+    into.sum += sum;
+}
+
+}
+
+ReadingColumnStore::Chunk::Chunk() {
+    for (auto& channel : channels) {
+        channel.reset(new double[ChunkSize]);
+    }
+}
+
+void ReadingColumnStore::appendTo(Series& target, const std::int64_t timestamp, const std::array<double, ReadingChannelCount>& values) {
+    if (target.chunks.empty() || target.chunks.back()->size == ChunkSize) {
+        target.chunks.push_back(std::make_unique<Chunk>());
+    }
+    Chunk& chunk = *target.chunks.back();
+    const std::size_t row = chunk.size;
+    if (row == 0) {
+        chunk.minTimestamp = timestamp;
+        chunk.maxTimestamp = timestamp;
+    }
+    else {
+        chunk.sorted = chunk.sorted && timestamp >= chunk.timestamps[row - 1];
+        chunk.minTimestamp = std::min(chunk.minTimestamp, timestamp);
+        chunk.maxTimestamp = std::max(chunk.maxTimestamp, timestamp);
+    }
+    chunk.timestamps[row] = timestamp;
+    for (std::size_t c = 0; c < ReadingChannelCount; c++) {
+        const double value = values[c];
+        chunk.channels[c][row] = value;
+        ChannelSummary& summary = chunk.summary[c];
+        summary.sum += value;
+        summary.min = row == 0 ? value : std::min(summary.min, value);
+        summary.max = row == 0 ? value : std::max(summary.max, value);
+    }
+    chunk.size++;
+    target.size++;
+}
+
+std::size_t ReadingColumnStore::load(const DatabaseManager& database) {
+    // Built aside so aggregate() keeps answering from the old data meanwhile.
+    std::unordered_map<std::string, Series> loaded;
+    std::size_t rows = 0;
+    for (const std::string& user : database.getReadingUsers()) {
+        Series& target = loaded[user];
+        for (const ReadingRow& row : database.streamReadings(user)) {
+            appendTo(target, row.timestamp(),
+                     {row.carbonDioxide(), row.methane(), row.ammonia(), row.inductivity(), row.reflectance()});
+        }
+        rows += target.size;
+    }
+    std::unique_lock lock(mutex);
+    series = std::move(loaded);
+    return rows;
+}
+
+void ReadingColumnStore::append(const std::string& user, const std::int64_t timestamp, const std::array<double, ReadingChannelCount>& values) {
+    std::unique_lock lock(mutex);
+    appendTo(series[user], timestamp, values);
+}
+
+void ReadingColumnStore::onReadings(std::span<const ReadingInput> readings, std::span<const std::int64_t> timestamps) {
+    std::unique_lock lock(mutex);
+    Series* current = nullptr;
+    const std::string* currentUser = nullptr;
+    for (std::size_t i = 0; i < readings.size(); i++) {
+        const ReadingInput& r = readings[i];
+        if (currentUser == nullptr || *currentUser != r.user) {
+            current = &series[r.user];
+            currentUser = &r.user;
+        }
+        appendTo(*current, timestamps[i], {r.carbonDioxide, r.methane, r.ammonia, r.inductivity, r.reflectance});
+    }
+}
+
+ChannelAggregate ReadingColumnStore::aggregate(const std::string& user, const ReadingChannel channel, const std::int64_t from, const std::int64_t to) const {
+    ChannelAggregate result;
+    const auto c = static_cast<std::size_t>(channel);
+    std::shared_lock lock(mutex);
+    auto found = series.find(user);
+    if (found == series.end()) {
+        return result;
+    }
+
+    for (const auto& chunkPtr : found->second.chunks) {
+        const Chunk& chunk = *chunkPtr;
+        if (chunk.size == 0 || chunk.maxTimestamp < from || chunk.minTimestamp >= to) {
+            continue;
+        }
+        if (chunk.minTimestamp >= from && chunk.maxTimestamp < to) {
+            const ChannelSummary& s = chunk.summary[c];
+            merge(result, chunk.size, s.sum, s.min, s.max);
+        }
+        else if (chunk.sorted) {
+            const std::int64_t* begin = chunk.timestamps.get();
+            const std::int64_t* end = begin + chunk.size;
+            const std::size_t lo = std::lower_bound(begin, end, from) - begin;
+            const std::size_t hi = std::lower_bound(begin, end, to) - begin;
+            if (lo < hi) {
+                RangeSummary s = summarize(chunk.channels[c].get() + lo, hi - lo);
+                merge(result, hi - lo, s.sum, s.min, s.max);
+            }
+        }
+        else {
+            for (std::size_t i = 0; i < chunk.size; i++) {
+                const std::int64_t ts = chunk.timestamps[i];
+                if (ts >= from && ts < to) {
+                    const double value = chunk.channels[c][i];
+                    merge(result, 1, value, value, value);
+                }
+            }
+        }
+    }
+    if (result.count > 0) {
+        result.mean = result.sum / static_cast<double>(result.count);
+    }
+    return result;
+}
+
+std::size_t ReadingColumnStore::size(const std::string& user) const {
+    std::shared_lock lock(mutex);
+    auto found = series.find(user);
+    return found == series.end() ? 0 : found->second.size;
+}
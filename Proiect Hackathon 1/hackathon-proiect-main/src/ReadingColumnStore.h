@@ -0,0 +1,81 @@
+#pragma once
+#include "DatabaseManager.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class ReadingChannel {
+    CarbonDioxide,
+    Methane,
+    Ammonia,
+    Inductivity,
+    Reflectance
+};
+
+constexpr std::size_t ReadingChannelCount = 5;
+
+struct ChannelAggregate {
+    std::size_t count = 0;
+    double sum = 0.0;
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+};
+
+// In-process column store mirroring the readings table. Each user/device has
+// its own series of fixed-size chunks holding one array per sensor channel plus
+// the timestamps, so range aggregates run over contiguous doubles with SIMD.
+// Every chunk keeps min/max/sum per channel, which lets aggregate() answer fully
+// covered chunks without touching their rows.
+//
+// load() copies the rows already in the table; DatabaseManager::addObserver then
+// keeps the store in sync with later inserts. Call load() right before
+// addObserver, with no inserts through that manager in between, or rows are
+// missed or counted twice. Rows moved to a ReadingArchive are not included.
+class ReadingColumnStore : public ReadingObserver {
+public:
+    static constexpr std::size_t ChunkSize = 4096;
+private:
+    struct ChannelSummary {
+        double sum = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+    };
+
+    struct Chunk {
+        std::size_t size = 0;
+        bool sorted = true;
+        std::int64_t minTimestamp = 0;
+        std::int64_t maxTimestamp = 0;
+        std::unique_ptr<std::int64_t[]> timestamps{new std::int64_t[ChunkSize]};
+        std::array<std::unique_ptr<double[]>, ReadingChannelCount> channels;
+        std::array<ChannelSummary, ReadingChannelCount> summary;
+
+        Chunk();
+    };
+
+    struct Series {
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        std::size_t size = 0;
+    };
+
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, Series> series;
+
+    static void appendTo(Series& target, std::int64_t timestamp, const std::array<double, ReadingChannelCount>& values);
+public:
+    // Replaces the store's contents with every row of the readings table and
+    // returns how many rows that was.
+    std::size_t load(const DatabaseManager& database);
+    void append(const std::string& user, std::int64_t timestamp, const std::array<double, ReadingChannelCount>& values);
+    void onReadings(std::span<const ReadingInput> readings, std::span<const std::int64_t> timestamps) override;
+
+    // Aggregate of one channel over readings with from <= timestamp < to.
+    ChannelAggregate aggregate(const std::string& user, ReadingChannel channel, std::int64_t from, std::int64_t to) const;
+    std::size_t size(const std::string& user) const;
+};
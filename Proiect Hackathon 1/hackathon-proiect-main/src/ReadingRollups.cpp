@@ -0,0 +1,148 @@
+#pragma once
+#include "ReadingRollups.h"
+#include <algorithm>
+#include <mutex>
+
+namespace {
+
+std::int64_t floorTo(const std::int64_t timestamp, const std::int64_t width) {
+    std::int64_t bucket = timestamp / width;
+    if (timestamp % width < 0) bucket--;
+    return bucket * width;
+}
+
+}
+
+std::int64_t ReadingRollups::bucketWidth(const RollupResolution resolution) {
+    constexpr std::int64_t minute = 60LL * 1000000;
+    switch (resolution) {
+        case RollupResolution::Minute: return minute;
+        case RollupResolution::Hour: return 60 * minute;
+        case RollupResolution::Day: return 24 * 60 * minute;
+    }
+    return minute;
+}
+
+void ReadingRollups::addSample(UserRollups& user, const std::array<std::size_t, ResolutionCount>& retention,
+                               const std::int64_t timestamp, const std::array<double, ReadingChannelCount>& values) {
+    for (std::size_t r = 0; r < ResolutionCount; r++) {
+        const std::int64_t width = bucketWidth(static_cast<RollupResolution>(r));
+        const std::int64_t start = floorTo(timestamp, width);
+        for (std::size_t c = 0; c < ReadingChannelCount; c++) {
+            BucketMap& buckets = user.buckets[c][r];
+            // Samples nearly always land in the newest bucket, so try it first.
+            auto it = !buckets.empty() && std::prev(buckets.end())->first == start
+                ? std::prev(buckets.end())
+                : buckets.try_emplace(start).first;
+            Bucket& bucket = it->second;
+            const double value = values[c];
+            if (bucket.count == 0) {
+                bucket.min = value;
+                bucket.max = value;
+            }
+            else {
+                bucket.min = std::min(bucket.min, value);
+                bucket.max = std::max(bucket.max, value);
+            }
+            if (bucket.count == 0 || timestamp >= bucket.lastTimestamp) {
+                bucket.last = value;
+                bucket.lastTimestamp = timestamp;
+            }
+            bucket.count++;
+            bucket.sum += value;
+
+            while (buckets.size() > retention[r]) {
+                user.retainedFrom[r] = std::max(user.retainedFrom[r], buckets.begin()->first + width);
+                buckets.erase(buckets.begin());
+            }
+        }
+    }
+}
+
+std::size_t ReadingRollups::load(const DatabaseManager& database) {
+    std::array<std::size_t, ResolutionCount> retention;
+    {
+        std::shared_lock lock(mutex);
+        retention = maxBuckets;
+    }
+    // Built aside so queries keep answering from the old rollups meanwhile.
+    std::unordered_map<std::string, UserRollups> loaded;
+    std::size_t rows = 0;
+    for (const std::string& user : database.getReadingUsers()) {
+        UserRollups& target = loaded[user];
+        for (const ReadingRow& row : database.streamReadings(user)) {
+            addSample(target, retention, row.timestamp(),
+                      {row.carbonDioxide(), row.methane(), row.ammonia(), row.inductivity(), row.reflectance()});
+            rows++;
+        }
+    }
+    std::unique_lock lock(mutex);
+    rollups = std::move(loaded);
+    return rows;
+}
+
+void ReadingRollups::add(const std::string& user, const std::int64_t timestamp, const std::array<double, ReadingChannelCount>& values) {
+    std::unique_lock lock(mutex);
+    addSample(rollups[user], maxBuckets, timestamp, values);
+}
+
+void ReadingRollups::onReadings(std::span<const ReadingInput> readings, std::span<const std::int64_t> timestamps) {
+    std::unique_lock lock(mutex);
+    UserRollups* current = nullptr;
+    const std::string* currentUser = nullptr;
+    for (std::size_t i = 0; i < readings.size(); i++) {
+        const ReadingInput& r = readings[i];
+        if (currentUser == nullptr || *currentUser != r.user) {
+            current = &rollups[r.user];
+            currentUser = &r.user;
+        }
+        addSample(*current, maxBuckets, timestamps[i], {r.carbonDioxide, r.methane, r.ammonia, r.inductivity, r.reflectance});
+    }
+}
+
+void ReadingRollups::setRetention(const RollupResolution resolution, const std::size_t buckets) {
+    std::unique_lock lock(mutex);
+    maxBuckets[static_cast<std::size_t>(resolution)] = std::max<std::size_t>(buckets, 1);
+}
+
+RollupSeries ReadingRollups::query(const std::string& user, const ReadingChannel channel, const RollupResolution resolution,
+                                   const std::int64_t from, const std::int64_t to) const {
+    RollupSeries series{resolution, {}};
+    std::shared_lock lock(mutex);
+    auto found = rollups.find(user);
+    if (found == rollups.end() || from >= to) {
+        return series;
+    }
+    const BucketMap& buckets = found->second.buckets[static_cast<std::size_t>(channel)][static_cast<std::size_t>(resolution)];
+    const std::int64_t first = floorTo(from, bucketWidth(resolution));
+    for (auto it = buckets.lower_bound(first); it != buckets.end() && it->first < to; ++it) {
+        const Bucket& b = it->second;
+        series.points.push_back({it->first, b.count, b.sum, b.min, b.max, b.last});
+    }
+    return series;
+}
+
+RollupSeries ReadingRollups::query(const std::string& user, const ReadingChannel channel,
+                                   const std::int64_t from, const std::int64_t to, const std::size_t maxPoints) const {
+    std::array<std::int64_t, ResolutionCount> retainedFrom;
+    retainedFrom.fill(std::numeric_limits<std::int64_t>::min());
+    {
+        std::shared_lock lock(mutex);
+        if (auto found = rollups.find(user); found != rollups.end()) {
+            retainedFrom = found->second.retainedFrom;
+        }
+    }
+    RollupResolution chosen = RollupResolution::Day;
+    for (std::size_t r = 0; r < ResolutionCount; r++) {
+        const auto resolution = static_cast<RollupResolution>(r);
+        const std::int64_t width = bucketWidth(resolution);
+        const std::int64_t buckets = (floorTo(to - 1, width) - floorTo(from, width)) / width + 1;
+        // A finer resolution that has already evicted part of the range would
+        // silently return only its tail.
+        if (buckets <= static_cast<std::int64_t>(maxPoints) && floorTo(from, width) >= retainedFrom[r]) {
+            chosen = resolution;
+            break;
+        }
+    }
+    return query(user, channel, chosen, from, to);
+}
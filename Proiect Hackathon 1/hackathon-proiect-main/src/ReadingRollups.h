@@ -0,0 +1,94 @@
+#pragma once
+#include "DatabaseManager.h"
+#include "ReadingColumnStore.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class RollupResolution {
+    Minute,
+    Hour,
+    Day
+};
+
+struct RollupPoint {
+    std::int64_t bucketStart; // microseconds since the Unix epoch (UTC)
+    std::size_t count;
+    double sum;
+    double min;
+    double max;
+    double last;
+
+    double mean() const { return count > 0 ? sum / static_cast<double>(count) : 0.0; }
+};
+
+struct RollupSeries {
+    RollupResolution resolution;
+    std::vector<RollupPoint> points;
+};
+
+// 1-minute / 1-hour / 1-day summaries (count, sum, min, max, last) per user and
+// sensor channel, updated as readings are committed. Only the newest
+// maxBuckets buckets of each resolution are kept per series.
+//
+// load() rebuilds the rollups from the rows already in the table;
+// DatabaseManager::addObserver then keeps them in step with later inserts.
+// Call load() right before addObserver, with no inserts through that manager
+// in between, or rows are missed or counted twice. Rows moved to a
+// ReadingArchive are not included.
+class ReadingRollups : public ReadingObserver {
+public:
+    static constexpr std::size_t ResolutionCount = 3;
+private:
+    struct Bucket {
+        std::size_t count = 0;
+        double sum = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        double last = 0.0;
+        std::int64_t lastTimestamp = 0;
+    };
+
+    using BucketMap = std::map<std::int64_t, Bucket>;
+    struct UserRollups {
+        std::array<std::array<BucketMap, ResolutionCount>, ReadingChannelCount> buckets;
+        // Per resolution, the start of the oldest bucket still complete once
+        // older ones have been evicted.
+        std::array<std::int64_t, ResolutionCount> retainedFrom;
+
+        UserRollups() { retainedFrom.fill(std::numeric_limits<std::int64_t>::min()); }
+    };
+
+    std::array<std::size_t, ResolutionCount> maxBuckets{60 * 24 * 7, 24 * 365, 365 * 10};
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, UserRollups> rollups;
+
+    static void addSample(UserRollups& user, const std::array<std::size_t, ResolutionCount>& retention,
+                          std::int64_t timestamp, const std::array<double, ReadingChannelCount>& values);
+public:
+    static std::int64_t bucketWidth(RollupResolution resolution);
+
+    // Replaces the rollups with ones built from every row of the readings
+    // table and returns how many rows that was.
+    std::size_t load(const DatabaseManager& database);
+
+    void add(const std::string& user, std::int64_t timestamp, const std::array<double, ReadingChannelCount>& values);
+    void onReadings(std::span<const ReadingInput> readings, std::span<const std::int64_t> timestamps) override;
+
+    void setRetention(RollupResolution resolution, std::size_t buckets);
+
+    // Buckets overlapping [from, to) at one resolution.
+    RollupSeries query(const std::string& user, ReadingChannel channel, RollupResolution resolution,
+                       std::int64_t from, std::int64_t to) const;
+    // Same, at the finest resolution whose bucket count over [from, to) fits in
+    // maxPoints and which still retains buckets back to `from`; daily buckets
+    // when none does.
+    RollupSeries query(const std::string& user, ReadingChannel channel,
+                       std::int64_t from, std::int64_t to, std::size_t maxPoints) const;
+};
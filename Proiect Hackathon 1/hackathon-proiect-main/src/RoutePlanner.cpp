@@ -0,0 +1,474 @@
+#pragma once
+#include "RoutePlanner.h"
+#include "DumbsterGeoIndex.h"
+#include "ParallelFor.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <span>
+
+namespace {
+
+constexpr double Epsilon = 1e-7;
+constexpr int MaxOrOptSegment = 3;
+constexpr int KickSpan = 100;  // stops touched by one perturbation, at most
+
+// Node 0 is the depot and node i is stop i - 1. Coordinates are meters on a
+// local projection centred on the depot.
+struct Problem {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<int> demand;
+    std::vector<int> neighbours;  // `width` per node, closest first; stops only
+    std::size_t width = 0;
+
+    double distance(const int a, const int b) const {
+        const double dx = x[a] - x[b];
+        const double dy = y[a] - y[b];
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    std::span<const int> near(const int node) const {
+        return {neighbours.data() + static_cast<std::size_t>(node) * width, width};
+    }
+};
+
+// tours[r][0] is always the depot; the tour closes back to it.
+struct Routes {
+    std::vector<std::vector<int>> tours;
+    std::vector<int> capacity;
+    std::vector<int> load;
+    std::vector<int> routeOf;   // by node, -1 when unassigned
+    std::vector<int> position;  // by node, index within its tour
+    std::vector<char> queued;   // by node, local search work list membership
+
+    void renumber(const int route, const std::size_t from) {
+        const std::vector<int>& tour = tours[route];
+        for (std::size_t p = std::max<std::size_t>(from, 1); p < tour.size(); p++) {
+            position[tour[p]] = static_cast<int>(p);
+        }
+    }
+};
+
+double tourLength(const Problem& problem, const std::vector<int>& tour) {
+    double length = 0;
+    for (std::size_t p = 0; p < tour.size(); p++) {
+        length += problem.distance(tour[p], tour[p + 1 == tour.size() ? 0 : p + 1]);
+    }
+    return length;
+}
+
+// Iterated 2-opt / or-opt on one route. Only touches the nodes of that
+// route, so searches of different routes can run concurrently.
+class RouteSearch {
+    const Problem& problem;
+    Routes& routes;
+    const int route;
+    std::vector<int>& tour;
+    std::vector<int> work;
+
+    int last() const { return static_cast<int>(tour.size()) - 1; }
+    int at(const int p) const { return tour[p > last() ? 0 : p]; }
+    int succ(const int node) const { return at(routes.position[node] + 1); }
+    int pred(const int node) const { return tour[routes.position[node] - 1]; }
+    bool mine(const int node) const { return routes.routeOf[node] == route; }
+    double distance(const int a, const int b) const { return problem.distance(a, b); }
+
+    void push(const int node) {
+        if (node == 0 || routes.queued[node]) return;
+        routes.queued[node] = 1;
+        work.push_back(node);
+    }
+
+    void reverse(const int from, const int to) {
+        std::reverse(tour.begin() + from, tour.begin() + to + 1);
+        for (int p = from; p <= to; p++) routes.position[tour[p]] = p;
+    }
+
+    bool twoOpt(const int a) {
+        const int i = routes.position[a];
+        for (const bool forward : {true, false}) {
+            const int b = forward ? succ(a) : pred(a);
+            const double ab = distance(a, b);
+            for (const int c : problem.near(a)) {
+                if (!mine(c)) continue;
+                const double ac = distance(a, c);
+                if (ac >= ab - Epsilon) break;
+                const int d = forward ? succ(c) : pred(c);
+                if (c == b || d == a) continue;
+                if (ab + distance(c, d) - ac - distance(b, d) <= Epsilon) continue;
+                // Replace edges a-b and c-d with a-c and b-d.
+                const int j = routes.position[c];
+                if (forward) {
+                    if (i < j) reverse(i + 1, j);
+                    else reverse(j + 1, i);
+                }
+                else {
+                    if (i < j) reverse(i, j - 1);
+                    else reverse(j, i - 1);
+                }
+                push(a);
+                push(b);
+                push(c);
+                push(d);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool orOpt(const int first) {
+        const int p = routes.position[first];
+        for (int length = 1; length <= MaxOrOptSegment && p + length - 1 <= last(); length++) {
+            const int end = p + length - 1;
+            const int lastNode = tour[end];
+            const int prev = tour[p - 1];
+            const int next = at(end + 1);
+            const double removeGain = distance(prev, first) + distance(lastNode, next) - distance(prev, next);
+            if (removeGain <= Epsilon) continue;
+
+            auto inSegment = [&](const int node) {
+                return node != 0 && routes.position[node] >= p && routes.position[node] <= end;
+            };
+            double bestGain = Epsilon;
+            int bestU = -1;
+            int bestV = -1;
+            bool bestReversed = false;
+            for (const int endpoint : {first, lastNode}) {
+                for (const int c : problem.near(endpoint)) {
+                    if (!mine(c) || inSegment(c)) continue;
+                    for (const bool after : {true, false}) {
+                        const int u = after ? c : pred(c);
+                        const int v = after ? succ(c) : c;
+                        if (inSegment(u) || inSegment(v)) continue;
+                        const double uv = distance(u, v);
+                        const double straight = removeGain - (distance(u, first) + distance(lastNode, v) - uv);
+                        const double reversed = removeGain - (distance(u, lastNode) + distance(first, v) - uv);
+                        if (straight > bestGain) {
+                            bestGain = straight;
+                            bestU = u;
+                            bestV = v;
+                            bestReversed = false;
+                        }
+                        if (reversed > bestGain) {
+                            bestGain = reversed;
+                            bestU = u;
+                            bestV = v;
+                            bestReversed = true;
+                        }
+                    }
+                }
+            }
+            if (bestU < 0) continue;
+
+            std::vector<int> segment(tour.begin() + p, tour.begin() + end + 1);
+            if (bestReversed) std::reverse(segment.begin(), segment.end());
+            tour.erase(tour.begin() + p, tour.begin() + end + 1);
+            const int uPosition = routes.position[bestU] - (routes.position[bestU] > end ? length : 0);
+            tour.insert(tour.begin() + uPosition + 1, segment.begin(), segment.end());
+            routes.renumber(route, std::min(p, uPosition + 1));
+            push(prev);
+            push(next);
+            push(bestU);
+            push(bestV);
+            push(first);
+            push(lastNode);
+            return true;
+        }
+        return false;
+    }
+
+    void localSearch() {
+        while (!work.empty()) {
+            const int node = work.back();
+            work.pop_back();
+            routes.queued[node] = 0;
+            if (twoOpt(node) || orOpt(node)) push(node);
+        }
+    }
+public:
+    RouteSearch(const Problem& problem, Routes& routes, const int route)
+        : problem(problem), routes(routes), route(route), tour(routes.tours[route]) {}
+
+    void optimize(const std::size_t perturbations, std::mt19937_64& rng) {
+        for (int p = 1; p <= last(); p++) push(tour[p]);
+        localSearch();
+        if (last() < 8) return;
+
+        double length = tourLength(problem, tour);
+        std::vector<int> best = tour;
+        for (std::size_t kick = 0; kick < perturbations; kick++) {
+            // Swap two adjacent segments inside a short window, then repair.
+            const int p1 = 1 + static_cast<int>(rng() % static_cast<std::uint64_t>(last() - 1));
+            const int span = std::min(last() + 1 - p1, KickSpan);
+            const int p3 = p1 + 2 + static_cast<int>(rng() % static_cast<std::uint64_t>(span - 1));
+            const int p2 = p1 + 1 + static_cast<int>(rng() % static_cast<std::uint64_t>(p3 - p1 - 1));
+            std::rotate(tour.begin() + p1, tour.begin() + p2, tour.begin() + p3);
+            routes.renumber(route, p1);
+            for (int p = p1 - 1; p <= p3; p++) push(at(p));
+            localSearch();
+
+            const double kicked = tourLength(problem, tour);
+            if (kicked < length - Epsilon) {
+                length = kicked;
+                best = tour;
+            }
+            else {
+                tour = best;
+                routes.renumber(route, 1);
+            }
+        }
+    }
+};
+
+// Moves single stops to the route of a nearby stop when that shortens the
+// total and the receiving truck has room. Returns the routes changed.
+std::vector<char> relocateBetweenRoutes(const Problem& problem, Routes& routes) {
+    std::vector<char> changed(routes.tours.size(), 0);
+    auto succ = [&](const int node) {
+        const std::vector<int>& tour = routes.tours[routes.routeOf[node]];
+        const std::size_t p = static_cast<std::size_t>(routes.position[node]) + 1;
+        return p == tour.size() ? tour[0] : tour[p];
+    };
+    auto pred = [&](const int node) { return routes.tours[routes.routeOf[node]][routes.position[node] - 1]; };
+
+    for (int node = 1; node < static_cast<int>(problem.x.size()); node++) {
+        const int from = routes.routeOf[node];
+        if (from < 0) continue;
+        const int prev = pred(node);
+        const int next = succ(node);
+        const double removeGain = problem.distance(prev, node) + problem.distance(node, next) - problem.distance(prev, next);
+
+        double bestGain = Epsilon;
+        int bestU = -1;
+        int target = -1;
+        for (const int c : problem.near(node)) {
+            const int to = routes.routeOf[c];
+            if (to < 0 || to == from || routes.load[to] + problem.demand[node] > routes.capacity[to]) continue;
+            for (const bool after : {true, false}) {
+                const int u = after ? c : pred(c);
+                const int v = after ? succ(c) : c;
+                const double gain = removeGain - (problem.distance(u, node) + problem.distance(node, v) - problem.distance(u, v));
+                if (gain > bestGain) {
+                    bestGain = gain;
+                    bestU = u;
+                    target = to;
+                }
+            }
+        }
+        if (bestU < 0) continue;
+
+        std::vector<int>& source = routes.tours[from];
+        const int p = routes.position[node];
+        source.erase(source.begin() + p);
+        routes.renumber(from, p);
+        std::vector<int>& destination = routes.tours[target];
+        // The depot keeps position 0 in every route.
+        const int uPosition = bestU == 0 ? 0 : routes.position[bestU];
+        destination.insert(destination.begin() + uPosition + 1, node);
+        routes.renumber(target, uPosition + 1);
+        routes.routeOf[node] = target;
+        routes.load[from] -= problem.demand[node];
+        routes.load[target] += problem.demand[node];
+        changed[from] = 1;
+        changed[target] = 1;
+    }
+    return changed;
+}
+
+}
+
+RoutePlanner::RoutePlanner(RoutePlannerConfig config) : config(std::move(config)) {}
+
+RoutePlan RoutePlanner::plan(const std::vector<RouteStop>& stops) const {
+    const std::size_t trucks = config.truckCapacities.size();
+    const int nodes = static_cast<int>(stops.size()) + 1;
+
+    Problem problem;
+    problem.x.resize(nodes, 0);
+    problem.y.resize(nodes, 0);
+    problem.demand.resize(nodes, 0);
+    const double metersPerDegree = EarthRadiusMeters * DegreesToRadians;
+    const double lonScale = std::cos(config.depot.latitude * DegreesToRadians);
+    for (int node = 1; node < nodes; node++) {
+        const RouteStop& stop = stops[node - 1];
+        problem.x[node] = (stop.point.longitude - config.depot.longitude) * lonScale * metersPerDegree;
+        problem.y[node] = (stop.point.latitude - config.depot.latitude) * metersPerDegree;
+        problem.demand[node] = stop.demand;
+    }
+
+    // Candidate lists: the nearest other stops, re-sorted by planar distance.
+    problem.width = std::min<std::size_t>(config.neighbours, stops.size() > 0 ? stops.size() - 1 : 0);
+    problem.neighbours.assign(static_cast<std::size_t>(nodes) * problem.width, 0);
+    if (problem.width > 0) {
+        std::vector<DumbsterLocation> locations;
+        locations.reserve(stops.size());
+        for (int node = 1; node < nodes; node++) {
+            locations.push_back({node, stops[node - 1].point, false});
+        }
+        DumbsterGeoIndex index;
+        index.assign(locations);
+        parallelFor(stops.size(), config.threads, [&](const std::size_t i) {
+            const int node = static_cast<int>(i) + 1;
+            std::vector<GeoMatch> matches = index.nearest(stops[i].point, problem.width + 1);
+            std::erase_if(matches, [&](const GeoMatch& match) { return match.id == node; });
+            matches.resize(problem.width);
+            std::sort(matches.begin(), matches.end(), [&](const GeoMatch& a, const GeoMatch& b) {
+                const double da = problem.distance(node, a.id);
+                const double db = problem.distance(node, b.id);
+                return da != db ? da < db : a.id < b.id;
+            });
+            for (std::size_t k = 0; k < problem.width; k++) {
+                problem.neighbours[static_cast<std::size_t>(node) * problem.width + k] = matches[k].id;
+            }
+        });
+    }
+
+    Routes routes;
+    routes.tours.assign(trucks, std::vector<int>{0});
+    routes.capacity = config.truckCapacities;
+    routes.load.assign(trucks, 0);
+    routes.routeOf.assign(nodes, -1);
+    routes.position.assign(nodes, 0);
+    routes.queued.assign(nodes, 0);
+
+    // Sweep: stops by angle around the depot, starting after the widest gap,
+    // filling the trucks in order.
+    std::vector<int> order(stops.size());
+    std::vector<double> angle(nodes, 0);
+    for (int node = 1; node < nodes; node++) {
+        order[node - 1] = node;
+        angle[node] = std::atan2(problem.y[node], problem.x[node]);
+    }
+    std::sort(order.begin(), order.end(), [&](const int a, const int b) {
+        return angle[a] != angle[b] ? angle[a] < angle[b] : a < b;
+    });
+    if (order.size() > 1) {
+        std::size_t start = 0;
+        double widest = angle[order.front()] + 2 * 3.14159265358979323846 - angle[order.back()];
+        for (std::size_t k = 1; k < order.size(); k++) {
+            if (angle[order[k]] - angle[order[k - 1]] > widest) {
+                widest = angle[order[k]] - angle[order[k - 1]];
+                start = k;
+            }
+        }
+        std::rotate(order.begin(), order.begin() + static_cast<std::ptrdiff_t>(start), order.end());
+    }
+    std::vector<std::vector<int>> members(trucks);
+    std::vector<int> leftover;
+    std::size_t truck = 0;
+    auto fits = [&](const std::size_t t, const int node) {
+        return routes.load[t] + problem.demand[node] <= routes.capacity[t];
+    };
+    for (const int node : order) {
+        while (truck < trucks && !fits(truck, node) && (routes.load[truck] > 0 || routes.capacity[truck] <= 0)) {
+            truck++;
+        }
+        if (truck < trucks && fits(truck, node)) {
+            members[truck].push_back(node);
+            routes.load[truck] += problem.demand[node];
+            routes.routeOf[node] = static_cast<int>(truck);
+        }
+        else {
+            leftover.push_back(node);
+        }
+    }
+
+    // Nearest-neighbour tour through each truck's stops.
+    parallelFor(trucks, config.threads, [&](const std::size_t t) {
+        std::vector<int>& pool = members[t];
+        std::vector<int>& tour = routes.tours[t];
+        int current = 0;
+        while (!pool.empty()) {
+            std::size_t nearest = 0;
+            double nearestDistance = std::numeric_limits<double>::infinity();
+            for (std::size_t k = 0; k < pool.size(); k++) {
+                const double distance = problem.distance(current, pool[k]);
+                if (distance < nearestDistance) {
+                    nearestDistance = distance;
+                    nearest = k;
+                }
+            }
+            current = pool[nearest];
+            pool[nearest] = pool.back();
+            pool.pop_back();
+            tour.push_back(current);
+        }
+        routes.renumber(static_cast<int>(t), 1);
+    });
+
+    // Stops the sweep could not place go to the cheapest position with room.
+    RoutePlan plan;
+    for (const int node : leftover) {
+        double bestCost = std::numeric_limits<double>::infinity();
+        int bestRoute = -1;
+        std::size_t bestPosition = 0;
+        for (std::size_t t = 0; t < trucks; t++) {
+            if (!fits(t, node)) continue;
+            const std::vector<int>& tour = routes.tours[t];
+            for (std::size_t p = 0; p < tour.size(); p++) {
+                const int next = tour[p + 1 == tour.size() ? 0 : p + 1];
+                const double cost = problem.distance(tour[p], node) + problem.distance(node, next) - problem.distance(tour[p], next);
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestRoute = static_cast<int>(t);
+                    bestPosition = p;
+                }
+            }
+        }
+        if (bestRoute < 0) {
+            plan.unassigned.push_back(stops[node - 1].id);
+            continue;
+        }
+        std::vector<int>& tour = routes.tours[bestRoute];
+        tour.insert(tour.begin() + static_cast<std::ptrdiff_t>(bestPosition) + 1, node);
+        routes.renumber(bestRoute, bestPosition + 1);
+        routes.routeOf[node] = bestRoute;
+        routes.load[bestRoute] += problem.demand[node];
+    }
+    for (const std::vector<int>& tour : routes.tours) {
+        plan.constructionDistance += tourLength(problem, tour);
+    }
+
+    // Per-route searches in parallel, largest routes first, alternated with
+    // sequential moves between routes until those stop paying off.
+    std::vector<char> dirty(trucks, 1);
+    for (std::size_t round = 0; round < config.rounds; round++) {
+        std::vector<int> work;
+        for (std::size_t t = 0; t < trucks; t++) {
+            if (dirty[t] && routes.tours[t].size() > 2) work.push_back(static_cast<int>(t));
+        }
+        std::stable_sort(work.begin(), work.end(), [&](const int a, const int b) {
+            return routes.tours[a].size() > routes.tours[b].size();
+        });
+        parallelFor(work.size(), config.threads, [&](const std::size_t k) {
+            const int route = work[k];
+            std::mt19937_64 rng(config.seed ^ (0x9E3779B97F4A7C15ULL * (round * trucks + static_cast<std::size_t>(route) + 1)));
+            RouteSearch(problem, routes, route).optimize(config.perturbations, rng);
+        });
+        dirty = relocateBetweenRoutes(problem, routes);
+        if (std::find(dirty.begin(), dirty.end(), 1) == dirty.end()) break;
+    }
+
+    for (std::size_t t = 0; t < trucks; t++) {
+        TruckRoute route;
+        route.truck = t;
+        route.load = routes.load[t];
+        route.distance = tourLength(problem, routes.tours[t]);
+        for (std::size_t p = 1; p < routes.tours[t].size(); p++) {
+            route.stops.push_back(stops[routes.tours[t][p] - 1].id);
+        }
+        plan.distance += route.distance;
+        plan.routes.push_back(std::move(route));
+    }
+    return plan;
+}
+
+RoutePlan RoutePlanner::planFull(const DumbsterDatabaseManager& database) const {
+    std::vector<RouteStop> stops;
+    for (const DumbsterLocation& location : database.getDumbsterLocations(FullFilter::Full)) {
+        stops.push_back({location.id, location.point, 1});
+    }
+    return plan(stops);
+}
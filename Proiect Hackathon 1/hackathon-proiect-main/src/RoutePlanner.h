@@ -0,0 +1,57 @@
+#pragma once
+#include "DumbsterDatabaseManager.h"
+#include "GeoPoint.h"
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+struct RouteStop {
+    int id;
+    GeoPoint point;
+    int demand = 1;  // in the same units as the truck capacities
+};
+
+struct RoutePlannerConfig {
+    GeoPoint depot;
+    std::vector<int> truckCapacities;  // one route per truck, starting and ending at the depot
+    std::uint64_t seed = 1;
+    std::size_t threads = std::thread::hardware_concurrency();
+    std::size_t neighbours = 8;        // candidate list length for the local search
+    std::size_t perturbations = 50;    // kicks per route and round; 0 = plain local search
+    std::size_t rounds = 4;            // alternations of per-route search and inter-route moves
+};
+
+struct TruckRoute {
+    std::size_t truck;
+    std::vector<int> stops;  // RouteStop ids in visiting order
+    int load = 0;
+    double distance = 0;     // meters, depot to depot
+};
+
+struct RoutePlan {
+    std::vector<TruckRoute> routes;    // one per truck, possibly empty
+    std::vector<int> unassigned;       // stops that did not fit in any truck
+    double distance = 0;
+    double constructionDistance = 0;   // before local search
+};
+
+// Capacitated collection routes from a depot. Routes are built with a sweep
+// around the depot (filling trucks in order) and a nearest-neighbour tour per
+// truck, then improved by iterated local search: 2-opt and or-opt moves on
+// k-nearest candidate lists, run per route across `threads` workers, and
+// alternated with single-stop relocations between routes.
+//
+// Distances are straight lines on a local projection centred on the depot,
+// which is accurate to well under a percent across a city or county. Each
+// route draws its random kicks from (seed, round, route), so a plan depends
+// only on the stops and the config, never on thread count or timing.
+class RoutePlanner {
+    RoutePlannerConfig config;
+public:
+    explicit RoutePlanner(RoutePlannerConfig config);
+
+    RoutePlan plan(const std::vector<RouteStop>& stops) const;
+    // Plans over every located dumpster currently marked full.
+    RoutePlan planFull(const DumbsterDatabaseManager& database) const;
+};
@@ -0,0 +1,264 @@
+#pragma once
+#include "SessionStore.h"
+#include "SHA256.h"
+#include <algorithm>
+#include <iostream>
+#include <random>
+
+SessionStore::SessionStore(const SessionStoreConfig config) : config(config) {
+    this->config.tickSeconds = std::max<std::int64_t>(config.tickSeconds, 1);
+    this->config.ttlSeconds = std::max(config.ttlSeconds, this->config.tickSeconds);
+    this->config.wheelSlots = std::max<std::size_t>(config.wheelSlots, 1);
+    const std::int64_t lastTick = now() / this->config.tickSeconds - 1;
+    for (std::size_t i = 0; i < std::max<std::size_t>(config.shards, 1); i++) {
+        auto shard = std::make_unique<Shard>();
+        shard->wheel.resize(this->config.wheelSlots);
+        shard->sweptTick = lastTick;
+        shards.push_back(std::move(shard));
+    }
+    if (config.dbName.empty()) {
+        return;
+    }
+    database = std::make_unique<AccountDatabaseManager>(config.dbName);
+    for (SessionRecord& record : database->getSessions(now())) {
+        if (const std::optional<Key> key = parse(record.tokenHash)) {
+            Shard& shard = shardOf(*key);
+            std::lock_guard lock(shard.mutex);
+            insert(shard, *key, {std::move(record.email), record.expiresAt});
+        }
+    }
+}
+
+SessionStore::~SessionStore() {
+    detach();
+    if (!flush()) {
+        std::cerr << "Error saving sessions" << std::endl;
+    }
+}
+
+void SessionStore::attach(MonitorScheduler& scheduler) {
+    detach();
+    this->scheduler = &scheduler;
+    expireTask = scheduler.schedule(std::chrono::seconds(config.tickSeconds), [this] { expire(); });
+    if (database) {
+        flushTask = scheduler.schedule(config.flushPeriod, [this] { flush(); });
+    }
+}
+
+void SessionStore::detach() {
+    if (scheduler != nullptr) {
+        scheduler->cancel(expireTask);
+        scheduler->cancel(flushTask);
+        scheduler = nullptr;
+        expireTask = MonitorScheduler::InvalidTask;
+        flushTask = MonitorScheduler::InvalidTask;
+    }
+}
+
+std::optional<SessionStore::Key> SessionStore::parse(std::string_view token) {
+    if (token.size() != 32) {
+        return std::nullopt;
+    }
+    std::uint64_t halves[2] = {0, 0};
+    for (std::size_t i = 0; i < token.size(); i++) {
+        const char c = token[i];
+        std::uint64_t digit;
+        if (c >= '0' && c <= '9') digit = c - '0';
+        else if (c >= 'a' && c <= 'f') digit = c - 'a' + 10;
+        else return std::nullopt;
+        halves[i / 16] = halves[i / 16] << 4 | digit;
+    }
+    return Key{halves[0], halves[1]};
+}
+
+std::string SessionStore::format(const Key& key) {
+    static constexpr char hex[] = "0123456789abcdef";
+    std::string token(32, '0');
+    for (int i = 0; i < 16; i++) {
+        token[15 - i] = hex[(key.high >> (4 * i)) & 0xf];
+        token[31 - i] = hex[(key.low >> (4 * i)) & 0xf];
+    }
+    return token;
+}
+
+SessionStore::Key SessionStore::digest(const Key& token) {
+    std::uint8_t bytes[16];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = static_cast<std::uint8_t>(token.high >> (56 - 8 * i));
+        bytes[8 + i] = static_cast<std::uint8_t>(token.low >> (56 - 8 * i));
+    }
+    SHA256 sha;
+    sha.update(bytes, sizeof(bytes));
+    const std::array<std::uint8_t, 32> hash = sha.digest();
+    Key key{0, 0};
+    for (int i = 0; i < 8; i++) {
+        key.high = key.high << 8 | hash[i];
+        key.low = key.low << 8 | hash[8 + i];
+    }
+    return key;
+}
+
+std::int64_t SessionStore::now() {
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+SessionStore::Shard& SessionStore::shardOf(const Key& key) const {
+    // The high half picks the shard so the maps' buckets, taken from the low
+    // half, stay evenly used within it.
+    return *shards[key.high % shards.size()];
+}
+
+std::size_t SessionStore::slotOf(const std::int64_t expiresAt) const {
+    return static_cast<std::size_t>(expiresAt / config.tickSeconds) % config.wheelSlots;
+}
+
+void SessionStore::insert(Shard& shard, const Key& key, Session session) {
+    shard.wheel[slotOf(session.expiresAt)].push_back(key);
+    shard.sessions.insert_or_assign(key, std::move(session));
+}
+
+std::string SessionStore::issue(const std::string& email) {
+    std::random_device device;
+    const auto random64 = [&device] { return static_cast<std::uint64_t>(device()) << 32 | device(); };
+    const Key token{random64(), random64()};
+    const Key key = digest(token);
+    Shard& shard = shardOf(key);
+    {
+        std::lock_guard lock(shard.mutex);
+        insert(shard, key, {email, now() + config.ttlSeconds});
+    }
+    {
+        std::lock_guard lock(statsMutex);
+        issued++;
+    }
+    return format(token);
+}
+
+std::optional<std::string> SessionStore::validate(const std::string_view token) {
+    const std::optional<Key> parsed = parse(token);
+    if (!parsed) {
+        Shard& shard = *shards.front();
+        std::lock_guard lock(shard.mutex);
+        shard.rejected++;
+        return std::nullopt;
+    }
+    const Key key = digest(*parsed);
+    Shard& shard = shardOf(key);
+    const std::int64_t current = now();
+    std::lock_guard lock(shard.mutex);
+    const auto it = shard.sessions.find(key);
+    if (it == shard.sessions.end() || it->second.expiresAt <= current) {
+        // An expired entry stays until the sweep of its slot drops it.
+        shard.rejected++;
+        return std::nullopt;
+    }
+    if (config.slidingExpiry && it->second.expiresAt - current <= config.ttlSeconds / 2) {
+        it->second.expiresAt = current + config.ttlSeconds;
+    }
+    shard.validated++;
+    return it->second.email;
+}
+
+bool SessionStore::revoke(const std::string_view token) {
+    const std::optional<Key> parsed = parse(token);
+    if (!parsed) {
+        return false;
+    }
+    const Key key = digest(*parsed);
+    Shard& shard = shardOf(key);
+    bool erased;
+    {
+        std::lock_guard lock(shard.mutex);
+        erased = shard.sessions.erase(key) > 0;
+    }
+    if (erased) {
+        std::lock_guard lock(statsMutex);
+        revoked++;
+    }
+    return erased;
+}
+
+std::size_t SessionStore::revokeAll(const std::string& email) {
+    std::size_t erased = 0;
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        erased += std::erase_if(shard->sessions, [&email](const auto& entry) { return entry.second.email == email; });
+    }
+    std::lock_guard lock(statsMutex);
+    revoked += erased;
+    return erased;
+}
+
+std::size_t SessionStore::expire() {
+    const std::int64_t current = now();
+    // Only whole ticks that have passed: everything in their slots for this
+    // round is due, anything else is a later round or was extended.
+    const std::int64_t lastTick = current / config.tickSeconds - 1;
+    const auto slots = static_cast<std::int64_t>(config.wheelSlots);
+    std::size_t evicted = 0;
+    std::vector<Key> kept;
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        for (std::int64_t tick = std::max(shard->sweptTick + 1, lastTick - slots + 1); tick <= lastTick; tick++) {
+            const std::size_t slot = static_cast<std::size_t>(tick % slots);
+            kept.clear();
+            for (const Key& key : shard->wheel[slot]) {
+                const auto it = shard->sessions.find(key);
+                if (it == shard->sessions.end()) {
+                    continue;  // revoked
+                }
+                if (it->second.expiresAt <= current) {
+                    shard->sessions.erase(it);
+                    shard->expired++;
+                    evicted++;
+                    continue;
+                }
+                const std::size_t target = slotOf(it->second.expiresAt);
+                if (target == slot) kept.push_back(key);
+                else shard->wheel[target].push_back(key);
+            }
+            shard->wheel[slot].swap(kept);
+        }
+        shard->sweptTick = std::max(shard->sweptTick, lastTick);
+    }
+    return evicted;
+}
+
+bool SessionStore::flush() {
+    if (!database) {
+        return true;
+    }
+    std::lock_guard flushLock(flushMutex);
+    const std::int64_t current = now();
+    std::vector<SessionRecord> records;
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        for (const auto& [key, session] : shard->sessions) {
+            if (session.expiresAt > current) {
+                records.push_back({format(key), session.email, session.expiresAt});
+            }
+        }
+    }
+    const bool saved = database->saveSessions(records);
+    std::lock_guard lock(statsMutex);
+    flushes++;
+    if (!saved) failedWrites++;
+    return saved;
+}
+
+SessionStoreStats SessionStore::stats() const {
+    SessionStoreStats result{};
+    for (const auto& shard : shards) {
+        std::lock_guard lock(shard->mutex);
+        result.sessions += shard->sessions.size();
+        result.validated += shard->validated;
+        result.rejected += shard->rejected;
+        result.expired += shard->expired;
+    }
+    std::lock_guard lock(statsMutex);
+    result.issued = issued;
+    result.revoked = revoked;
+    result.flushes = flushes;
+    result.failedWrites = failedWrites;
+    return result;
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "AccountDatabaseManager.h"
+#include "MonitorScheduler.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct SessionStoreConfig {
+    std::int64_t ttlSeconds = 1800;
+    bool slidingExpiry = true;        // validate() pushes the expiry back once half the ttl has passed
+    std::size_t shards = 16;
+    std::int64_t tickSeconds = 1;     // expiry resolution of the wheel
+    std::size_t wheelSlots = 256;
+    std::string dbName;               // empty keeps sessions in memory only
+    std::chrono::milliseconds flushPeriod{30000};  // when persistent and attached
+};
+
+struct SessionStoreStats {
+    std::size_t sessions;
+    std::uint64_t issued;
+    std::uint64_t validated;
+    std::uint64_t rejected;   // unknown, malformed or expired tokens
+    std::uint64_t expired;    // evicted by the wheel
+    std::uint64_t revoked;
+    std::uint64_t flushes;
+    std::uint64_t failedWrites;
+};
+
+// Logged-in sessions, keyed by a random 128-bit token handed to the client as
+// 32 hex characters. The store itself only keeps the first 128 bits of the
+// token's SHA-256, in memory and in the sessions table, so reading either
+// does not hand out live tokens. Sessions are spread over independently
+// locked shards of hash maps, so validate() is a parse, one SHA-256 block,
+// one shard lock and one lookup, with no SQLite or password hashing.
+//
+// Each shard also has a hashed timer wheel: a session sits in the slot of the
+// tick it expires in, and expire() walks the slots between the last sweep and
+// now, evicting what is due. Sliding expiry only moves a session's deadline;
+// the sweep finds it still live and moves it to its new slot then, so a
+// validate() never touches the wheel. Revoked sessions leave the map at once
+// and their wheel entry is dropped by the next sweep of its slot. validate()
+// checks the deadline itself, so expiry is exact whatever the sweep lag.
+//
+// With a dbName the live sessions are loaded on construction and written
+// back by flush(), every flushPeriod once attached and from the destructor,
+// so a restart does not log everyone out.
+class SessionStore {
+    struct Key {
+        std::uint64_t high;
+        std::uint64_t low;
+        bool operator==(const Key&) const = default;
+    };
+    struct KeyHash {
+        std::size_t operator()(const Key& key) const { return key.low; }  // already random
+    };
+    struct Session {
+        std::string email;
+        std::int64_t expiresAt;
+    };
+    struct Shard {
+        mutable std::mutex mutex;
+        std::unordered_map<Key, Session, KeyHash> sessions;
+        std::vector<std::vector<Key>> wheel;
+        std::int64_t sweptTick = 0;  // ticks up to and including it have been swept
+        std::uint64_t validated = 0;
+        std::uint64_t rejected = 0;
+        std::uint64_t expired = 0;
+    };
+
+    SessionStoreConfig config;
+    std::unique_ptr<AccountDatabaseManager> database;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    mutable std::mutex statsMutex;
+    std::uint64_t issued = 0;
+    std::uint64_t revoked = 0;
+    std::uint64_t flushes = 0;
+    std::uint64_t failedWrites = 0;
+    std::mutex flushMutex;
+
+    MonitorScheduler* scheduler = nullptr;
+    MonitorScheduler::TaskId expireTask = MonitorScheduler::InvalidTask;
+    MonitorScheduler::TaskId flushTask = MonitorScheduler::InvalidTask;
+
+    static std::optional<Key> parse(std::string_view token);
+    static std::string format(const Key& key);
+    // What a token is stored under.
+    static Key digest(const Key& token);
+    static std::int64_t now();
+    Shard& shardOf(const Key& key) const;
+    std::size_t slotOf(std::int64_t expiresAt) const;
+    void insert(Shard& shard, const Key& key, Session session);
+public:
+    explicit SessionStore(SessionStoreConfig config = {});
+    ~SessionStore();
+
+    SessionStore(const SessionStore&) = delete;
+    SessionStore& operator=(const SessionStore&) = delete;
+
+    void attach(MonitorScheduler& scheduler);
+    void detach();
+
+    // A new token for an account whose password was just checked.
+    std::string issue(const std::string& email);
+    // The email the token was issued for, if it is live.
+    std::optional<std::string> validate(std::string_view token);
+    bool revoke(std::string_view token);
+    // Every session of the account, e.g. after a password change. O(sessions).
+    std::size_t revokeAll(const std::string& email);
+
+    // Evicts the sessions that have expired since the last sweep.
+    std::size_t expire();
+    // Writes the live sessions to dbName; true without one.
+    bool flush();
+
+    SessionStoreStats stats() const;
+};
@@ -0,0 +1,95 @@
+#pragma once
+#include "StatementCache.h"
+#include <iostream>
+#include <ostream>
+
+Statement::Statement(StatementCache* cache, std::vector<sqlite3_stmt*>* slot, sqlite3_stmt* stmt)
+    : slot(slot), cache(cache), stmt(stmt) {}
+
+Statement::Statement(Statement&& other) noexcept
+    : slot(other.slot), cache(other.cache), stmt(other.stmt) {
+    other.stmt = nullptr;
+}
+
+Statement& Statement::operator=(Statement&& other) noexcept {
+    if (this != &other) {
+        release();
+        slot = other.slot;
+        cache = other.cache;
+        stmt = other.stmt;
+        other.stmt = nullptr;
+    }
+    return *this;
+}
+
+Statement::~Statement() {
+    release();
+}
+
+void Statement::release() {
+    if (stmt == nullptr) return;
+    sqlite3_reset(stmt);
+    sqlite3_clear_bindings(stmt);
+    cache->giveBack(slot, stmt);
+    stmt = nullptr;
+}
+
+StatementCache::~StatementCache() {
+    clear();
+}
+
+void StatementCache::attach(sqlite3* database) {
+    std::lock_guard lock(mutex);
+    db = database;
+}
+
+Statement StatementCache::acquire(std::string_view sql) {
+    std::lock_guard lock(mutex);
+    if (db == nullptr) {
+        return {};
+    }
+    auto entry = idle.find(sql);
+    if (entry == idle.end()) {
+        entry = idle.emplace(std::string(sql), std::vector<sqlite3_stmt*>()).first;
+    }
+    std::vector<sqlite3_stmt*>& slot = entry->second;
+    if (!slot.empty()) {
+        sqlite3_stmt* stmt = slot.back();
+        slot.pop_back();
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return {this, &slot, stmt};
+    }
+
+    misses.fetch_add(1, std::memory_order_relaxed);
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v3(db, sql.data(), static_cast<int>(sql.size()), SQLITE_PREPARE_PERSISTENT, &stmt, nullptr) != SQLITE_OK) {
+        std::cerr << "Error preparing statement: " << sqlite3_errmsg(db) << std::endl;
+        sqlite3_finalize(stmt);
+        return {};
+    }
+    return {this, &slot, stmt};
+}
+
+void StatementCache::giveBack(std::vector<sqlite3_stmt*>* slot, sqlite3_stmt* stmt) {
+    std::lock_guard lock(mutex);
+    if (db == nullptr) {
+        sqlite3_finalize(stmt);
+        return;
+    }
+    slot->push_back(stmt);
+}
+
+void StatementCache::clear() {
+    std::lock_guard lock(mutex);
+    for (auto& [sql, slot] : idle) {
+        for (sqlite3_stmt* stmt : slot) {
+            sqlite3_finalize(stmt);
+        }
+        slot.clear();
+    }
+    db = nullptr;
+}
+
+StatementCacheStats StatementCache::stats() const {
+    return {hits.load(std::memory_order_relaxed), misses.load(std::memory_order_relaxed)};
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "sqlite3.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+class StatementCache;
+
+// RAII handle for a prepared statement checked out of a StatementCache.
+// When the handle goes out of scope the statement is reset, its bindings are
+// cleared and it goes back to the cache instead of being finalized.
+class Statement {
+    std::vector<sqlite3_stmt*>* slot = nullptr;
+    StatementCache* cache = nullptr;
+    sqlite3_stmt* stmt = nullptr;
+public:
+    Statement() = default;
+    Statement(StatementCache* cache, std::vector<sqlite3_stmt*>* slot, sqlite3_stmt* stmt);
+    Statement(Statement&& other) noexcept;
+    Statement& operator=(Statement&& other) noexcept;
+    Statement(const Statement&) = delete;
+    Statement& operator=(const Statement&) = delete;
+    ~Statement();
+
+    sqlite3_stmt* get() const { return stmt; }
+    operator sqlite3_stmt*() const { return stmt; }
+    explicit operator bool() const { return stmt != nullptr; }
+
+    void release();
+};
+
+struct StatementCacheStats {
+    std::uint64_t hits;
+    std::uint64_t misses;
+};
+
+// Per-connection cache of prepared statements keyed by SQL text. A statement is
+// checked out while a Statement handle holds it, so concurrent or nested use of
+// the same SQL gets a second prepared copy rather than sharing one.
+class StatementCache {
+    struct SqlHash {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view sql) const { return std::hash<std::string_view>{}(sql); }
+    };
+
+    sqlite3* db = nullptr;
+    std::mutex mutex;
+    std::unordered_map<std::string, std::vector<sqlite3_stmt*>, SqlHash, std::equal_to<>> idle;
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+
+    friend class Statement;
+    void giveBack(std::vector<sqlite3_stmt*>* slot, sqlite3_stmt* stmt);
+public:
+    StatementCache() = default;
+    StatementCache(const StatementCache&) = delete;
+    StatementCache& operator=(const StatementCache&) = delete;
+    ~StatementCache();
+
+    void attach(sqlite3* database);
+    Statement acquire(std::string_view sql);
+    void clear();
+
+    StatementCacheStats stats() const;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include "StringPool.h"
+#include <algorithm>
+#include <cstring>
+
+std::string_view StringPool::store(const std::string_view text) {
+    if (blocks.empty() || blockUsed + text.size() > BlockSize) {
+        // Strings longer than a block get a block of their own.
+        const std::size_t size = std::max(BlockSize, text.size());
+        blocks.push_back(std::make_unique<char[]>(size));
+        characterBytes += size;
+        blockUsed = 0;
+    }
+    char* target = blocks.back().get() + blockUsed;
+    std::memcpy(target, text.data(), text.size());
+    blockUsed += text.size();
+    return {target, text.size()};
+}
+
+std::uint32_t StringPool::intern(const std::string_view text) {
+    auto found = ids.find(text);
+    if (found != ids.end()) {
+        return found->second;
+    }
+    const std::string_view stored = store(text);
+    const auto id = static_cast<std::uint32_t>(strings.size());
+    strings.push_back(stored);
+    ids.emplace(stored, id);
+    return id;
+}
+
+std::optional<std::uint32_t> StringPool::find(const std::string_view text) const {
+    auto found = ids.find(text);
+    if (found == ids.end()) return std::nullopt;
+    return found->second;
+}
+
+std::size_t StringPool::bytes() const {
+    // Approximate unordered_map cost: one node (key, value, next, hash) per
+    // entry plus the bucket array.
+    const std::size_t nodeBytes = sizeof(std::string_view) + sizeof(std::uint32_t) + 2 * sizeof(void*);
+    return characterBytes + strings.capacity() * sizeof(std::string_view)
+         + ids.size() * nodeBytes + ids.bucket_count() * sizeof(void*);
+}
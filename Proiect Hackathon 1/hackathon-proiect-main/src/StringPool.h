@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Interns strings into dense 32-bit ids. Characters are copied once into
+// large blocks, so views returned by view() stay valid for the pool's
+// lifetime. Strings are never removed. Not synchronized; the owner locks.
+class StringPool {
+    static constexpr std::size_t BlockSize = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]>> blocks;
+    std::size_t blockUsed = 0;
+    std::size_t characterBytes = 0;
+    std::vector<std::string_view> strings;
+    std::unordered_map<std::string_view, std::uint32_t> ids;
+
+    std::string_view store(std::string_view text);
+public:
+    std::uint32_t intern(std::string_view text);
+    std::optional<std::uint32_t> find(std::string_view text) const;
+    std::string_view view(std::uint32_t id) const { return strings[id]; }
+
+    std::size_t size() const { return strings.size(); }
+    // Heap bytes held by the pool: character blocks, the id table and the lookup map.
+    std::size_t bytes() const;
+};
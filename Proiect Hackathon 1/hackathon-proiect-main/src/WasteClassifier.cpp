@@ -0,0 +1,194 @@
+#pragma once
+#include "WasteClassifier.h"
+#include "CpuFeatures.h"
+#include <cmath>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <ostream>
+#include <sstream>
+
+#if CPU_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr std::size_t Features = ReadingChannelCount;
+
+// Readings are read as six consecutive doubles (timestamp slot + channels).
+static_assert(sizeof(Reading) == 6 * sizeof(double) && offsetof(Reading, carbonDioxide) == sizeof(double));
+
+double confidenceOf(const double* scores, const std::size_t stride, const std::size_t classes, const double best) {
+    double sum = 0.0;
+    for (std::size_t c = 0; c < classes; c++) {
+        sum += std::exp(scores[c * stride] - best);
+    }
+    return 1.0 / sum;
+}
+
+void classifyScalar(const double* weights, const double* bias, const std::size_t classes,
+                    std::span<const Reading> readings, std::span<WasteClassification> out) {
+    std::vector<double> scores(classes);
+    for (std::size_t i = 0; i < readings.size(); i++) {
+        const double x[Features] = {readings[i].carbonDioxide, readings[i].methane, readings[i].ammonia,
+                                    readings[i].inductivity, readings[i].reflectance};
+        std::uint32_t label = 0;
+        for (std::size_t c = 0; c < classes; c++) {
+            double score = bias[c];
+            for (std::size_t j = 0; j < Features; j++) {
+                score += weights[c * Features + j] * x[j];
+            }
+            scores[c] = score;
+            if (score > scores[label]) label = static_cast<std::uint32_t>(c);
+        }
+        out[i] = {label, confidenceOf(scores.data(), 1, classes, scores[label])};
+    }
+}
+
+#if CPU_X86
+TARGET_AVX2 void classifyAvx2(const double* weights, const double* bias, const std::size_t classes,
+                              std::span<const Reading> readings, std::span<WasteClassification> out) {
+    std::vector<double> scores(classes * 4);
+    const __m256i stride = _mm256_setr_epi64x(0, 6, 12, 18);
+    std::size_t i = 0;
+    for (; i + 4 <= readings.size(); i += 4) {
+        const double* base = &readings[i].carbonDioxide;
+        __m256d x[Features];
+        for (std::size_t j = 0; j < Features; j++) {
+            x[j] = _mm256_i64gather_pd(base + j, stride, 8);
+        }
+        __m256d best = _mm256_set1_pd(-HUGE_VAL);
+        __m256d bestLabel = _mm256_setzero_pd();
+        for (std::size_t c = 0; c < classes; c++) {
+            __m256d score = _mm256_set1_pd(bias[c]);
+            for (std::size_t j = 0; j < Features; j++) {
+                score = _mm256_add_pd(score, _mm256_mul_pd(_mm256_set1_pd(weights[c * Features + j]), x[j]));
+            }
+            _mm256_storeu_pd(scores.data() + c * 4, score);
+            const __m256d better = _mm256_cmp_pd(score, best, _CMP_GT_OQ);
+            best = _mm256_blendv_pd(best, score, better);
+            bestLabel = _mm256_blendv_pd(bestLabel, _mm256_set1_pd(static_cast<double>(c)), better);
+        }
+        alignas(32) double bests[4], labels[4];
+        _mm256_store_pd(bests, best);
+        _mm256_store_pd(labels, bestLabel);
+        for (std::size_t lane = 0; lane < 4; lane++) {
+            out[i + lane] = {static_cast<std::uint32_t>(labels[lane]),
+                             confidenceOf(scores.data() + lane, 4, classes, bests[lane])};
+        }
+    }
+    classifyScalar(weights, bias, classes, readings.subspan(i), out.subspan(i));
+}
+#endif
+
+using ClassifyFn = void (*)(const double*, const double*, std::size_t, std::span<const Reading>, std::span<WasteClassification>);
+
+ClassifyFn selectClassify() {
+#if CPU_X86
+    if (cpuFeatures().avx2) return classifyAvx2;
+#endif
+    return classifyScalar;
+}
+
+const ClassifyFn classifyKernel = selectClassify();
+
+}
+
+bool WasteClassifier::load(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Error opening classifier model " << path << std::endl;
+        return false;
+    }
+    std::string kind;
+    double mean[Features] = {0.0, 0.0, 0.0, 0.0, 0.0};
+    double stddev[Features] = {1.0, 1.0, 1.0, 1.0, 1.0};
+    std::vector<std::string> loadedNames;
+    std::vector<std::array<double, Features + 1>> rows;
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        line = line.substr(0, line.find('#'));
+        std::istringstream words(line);
+        std::string directive;
+        if (!(words >> directive)) continue;
+
+        bool ok = true;
+        if (directive == "classifier") {
+            ok = static_cast<bool>(words >> kind) && (kind == "centroid" || kind == "linear");
+        }
+        else if (directive == "normalize") {
+            for (double& m : mean) ok = ok && static_cast<bool>(words >> m);
+            for (double& s : stddev) ok = ok && static_cast<bool>(words >> s) && s > 0.0;
+        }
+        else if (directive == "class") {
+            std::string name;
+            std::array<double, Features + 1> row{};
+            ok = static_cast<bool>(words >> name);
+            for (std::size_t j = 0; j < Features; j++) ok = ok && static_cast<bool>(words >> row[j]);
+            if (ok && !(words >> row[Features])) row[Features] = 0.0;
+            loadedNames.push_back(name);
+            rows.push_back(row);
+        }
+        else {
+            ok = false;
+        }
+        if (!ok) {
+            std::cerr << "Invalid classifier model line " << lineNumber << " in " << path << std::endl;
+            return false;
+        }
+    }
+    if (kind.empty() || rows.empty()) {
+        std::cerr << "Classifier model " << path << " has no classifier kind or classes" << std::endl;
+        return false;
+    }
+
+    // Scores are linear in the normalized features z = (x - mean) / stddev. A
+    // centroid, normalized the same way, scores 2 c.z - |c|^2, which ranks (and softmaxes) like -|z - c|^2.
+    // Folding the normalization in gives w.x + b on the raw channels.
+    names = std::move(loadedNames);
+    weights.assign(rows.size() * Features, 0.0);
+    bias.assign(rows.size(), 0.0);
+    for (std::size_t c = 0; c < rows.size(); c++) {
+        double b = rows[c][Features];
+        if (kind == "centroid") {
+            b = 0.0;
+            for (std::size_t j = 0; j < Features; j++) {
+                rows[c][j] = (rows[c][j] - mean[j]) / stddev[j];
+                b -= rows[c][j] * rows[c][j];
+            }
+        }
+        for (std::size_t j = 0; j < Features; j++) {
+            const double w = (kind == "centroid" ? 2.0 * rows[c][j] : rows[c][j]) / stddev[j];
+            weights[c * Features + j] = w;
+            b -= w * mean[j];
+        }
+        bias[c] = b;
+    }
+    return true;
+}
+
+std::size_t WasteClassifier::classCount() const {
+    return names.size();
+}
+
+const std::string& WasteClassifier::className(const std::uint32_t label) const {
+    return names.at(label);
+}
+
+void WasteClassifier::classify(std::span<const Reading> readings, std::span<WasteClassification> out) const {
+    if (names.empty()) {
+        std::cerr << "Classifier used before a model was loaded" << std::endl;
+        return;
+    }
+    classifyKernel(weights.data(), bias.data(), names.size(), readings, out.first(readings.size()));
+}
+
+std::vector<WasteClassification> WasteClassifier::classify(std::span<const Reading> readings) const {
+    std::vector<WasteClassification> out(readings.size());
+    classify(readings, out);
+    return out;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "DatabaseManager.h"
+#include "ReadingColumnStore.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+struct WasteClassification {
+    std::uint32_t label;  // index into WasteClassifier::className
+    double confidence;    // softmax probability of the label
+};
+
+// Batch waste-type classifier over the five sensor channels. Models are either
+// nearest-centroid (one centroid per class) or linear (weights + bias per
+// class); both are reduced to a linear score per class at load time, so one
+// kernel scores four readings at a time with AVX2.
+//
+// Model file, one directive per line ('#' starts a comment):
+//   classifier centroid|linear
+//   normalize <mean x5> <stddev x5>     optional, applied before scoring
+//   class <name> <value x5> [bias]      centroid, or weights + bias
+// Values are in channel order: carbonDioxide methane ammonia inductivity reflectance.
+// Centroids are in raw channel units; linear weights apply to normalized channels.
+class WasteClassifier {
+    std::vector<std::string> names;
+    // weights[c * ReadingChannelCount + j] and bias[c] for class c, with the
+    // normalization folded in.
+    std::vector<double> weights;
+    std::vector<double> bias;
+public:
+    bool load(const std::string& path);
+
+    std::size_t classCount() const;
+    const std::string& className(std::uint32_t label) const;
+
+    // out must hold readings.size() entries.
+    void classify(std::span<const Reading> readings, std::span<WasteClassification> out) const;
+    std::vector<WasteClassification> classify(std::span<const Reading> readings) const;
+};